@@ -149,6 +149,7 @@ class SimBase(SimPortManager, SimChannelManager):
 		        lambda content: replace_define_macro(content, self.getIncPath(fullPath=True)),
 		        lambda content: replace_namespace_name(content, self.group == "", self.group),
 		        lambda content: replace_class_name(content, self.name),
+		        lambda content: self.replace_port_handles(content),
 		    )
 		)
 
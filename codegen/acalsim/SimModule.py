@@ -79,7 +79,8 @@ class SimModule(SimPortManager):
 		    func=chain_lambdas(
 		        lambda content: replace_define_macro(content, self.getIncPath(fullPath=True)),
 		        lambda content: replace_class_name(content, self.name),
-		        lambda content: replace_namespace_name(content, self.group == "", self.group)
+		        lambda content: replace_namespace_name(content, self.group == "", self.group),
+		        lambda content: self.replace_port_handles(content)
 		    )
 		)
 
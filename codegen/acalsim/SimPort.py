@@ -13,6 +13,30 @@
 # limitations under the License.
 
 
+import re
+
+
+def port_handle_name(port_name: str, suffix: str) -> str:
+	"""Turn a port name such as 'sIF-m' into a lowerCamel member name such as 'sIFMMasterPort'."""
+	parts = [p for p in re.split(r"[^0-9A-Za-z]+", port_name) if p]
+	name = parts[0] + "".join(p[0].upper() + p[1 :] for p in parts[1 :]) if parts else "port"
+	if name[0].isdigit(): name = "p" + name
+	return name[0].lower() + name[1 :] + suffix
+
+
+def align_declarations(decls: list[tuple[str, str, str]]) -> list[str]:
+	"""Format consecutive (type, name, value) declarations the way clang-format aligns them."""
+	type_width = max((len(t) for t, _, _ in decls), default=0)
+	name_width = max((len(n) for _, n, _ in decls), default=0)
+	return [f"{t.ljust(type_width)} {n.ljust(name_width)} = {v};" for t, n, v in decls]
+
+
+def align_assignments(assigns: list[tuple[str, str]]) -> list[str]:
+	"""Format consecutive (target, value) assignments the way clang-format aligns them."""
+	width = max((len(t) for t, _ in assigns), default=0)
+	return [f"{t.ljust(width)} = {v};" for t, v in assigns]
+
+
 class SimPortManager:
 
 	def __init__(self):
@@ -36,7 +60,39 @@ class SimPortManager:
 		return name in self.s_simports
 
 	def replace_simport(self, content):
-		return self.replace_masterports(self.replace_slaveports(content))
+		content = self.replace_masterports(self.replace_slaveports(content))
+		return self.replace_port_bindings(self.replace_port_handles(content))
+
+	def replace_port_handles(self, content):
+		# One typed handle per port, so that step() never looks a port up by its name
+		decls = [
+		    ("acalsim::MasterPort*", port_handle_name(name, "MasterPort"), "nullptr")
+		    for name in self.m_simports
+		]
+		decls += [
+		    ("acalsim::SlavePort*", port_handle_name(name, "SlavePort"), "nullptr")
+		    for name in self.s_simports
+		]
+		handles = align_declarations(decls)
+		block = "\n\nprivate:\n\t// Port handles resolved in init()\n\t" + "\n\t".join(handles) if handles else ""
+		return content.replace("\n{{SimPort.SimPortManager.handles}}", block)
+
+	def replace_port_bindings(self, content):
+		assigns = [
+		    (f'this->{port_handle_name(name, "MasterPort")}', f'this->getMasterPort(\"{name}\")')
+		    for name in self.m_simports
+		]
+		assigns += [
+		    (f'this->{port_handle_name(name, "SlavePort")}', f'this->getSlavePort(\"{name}\")')
+		    for name in self.s_simports
+		]
+		bindings = align_assignments(assigns)
+		block = ""
+		if bindings:
+			block = "\n\t// Resolve the port handles once, step() uses them instead of looking ports up by name"
+			block += "".join(f"\n\t{line}" for line in bindings)
+		content = content.replace("\n\t{{SimPort.SimPortManager.bindings}}", block)
+		return content.replace("init() {\n}", "init() {}")
 
 	def replace_masterports(self, content):
 		ports = "\n\t".join(f'this->addMasterPort(\"{name}\");' for name in self.m_simports)
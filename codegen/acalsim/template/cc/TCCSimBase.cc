@@ -15,7 +15,10 @@
 
 {{util.class_name}}::~{{util.class_name}}() {}
 
-void {{util.class_name}}::init() { this->registerModules(); }
+void {{util.class_name}}::init() {
+	{{SimPort.SimPortManager.bindings}}
+	this->registerModules();
+}
 
 void {{util.class_name}}::registerModules() {
 	// Generate and Register Modules
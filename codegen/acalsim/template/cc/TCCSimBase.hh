@@ -50,7 +50,7 @@ public:
 	 * @note Release dynamic memory, clean up the event queue, etc., in this function.
 	 */
 	void cleanup() override;
-
+{{SimPort.SimPortManager.handles}}
 };
 
 {{util.namespace_name.footer}}
@@ -12,7 +12,9 @@
 
 {{util.class_name}}::~{{util.class_name}}() {}
 
-void {{util.class_name}}::init() {}
+void {{util.class_name}}::init() {
+	{{SimPort.SimPortManager.bindings}}
+}
 
 void {{util.class_name}}::step() {}
 
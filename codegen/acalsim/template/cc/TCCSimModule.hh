@@ -36,7 +36,7 @@ public:
 	 * @note Design what the component can do or print out some information here each iteration.
 	 */
 	void step() override;
-
+{{SimPort.SimPortManager.handles}}
 };
 
 {{util.namespace_name.footer}}
@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+
+# Copyright 2023-2024 Playlab/ACAL
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Runs test programs of the riscv app with the pipeline stage models stepped on one and on several
+# host threads (SOC parameter "stage_threads", CLI option --stage_threads) and checks that the runs
+# give the same results: the completion tick, the interval statistics, the CPI stack, the Konata
+# trace and the binary trace. Every run gets its own working directory holding a copy of
+# src/riscv/configs.json, which is where the app reads its configuration from.
+
+from typing import Any, Dict, List, Optional, Tuple
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+import click
+
+from riscv_trace_decode import Record, read_header, read_records
+
+CONFIG_PATH: str = "src/riscv/configs.json"
+ASM_DIR: str = "src/riscv/asm"
+
+# Test program -> SOC parameters it needs
+PROGRAMS: Dict[str, Dict[str, Any]] = {
+    "multicore_sum.txt": {"num_cores": 4},
+    "matmul_pingpong.txt": {},
+}
+
+# SOC parameters of every run, the outputs are compared between the runs
+OUTPUTS: Dict[str, Any] = {
+    "pipeline_models": 1,
+    "binary_trace": "trace.bin",
+    "konata_trace": "pipeline.kanata",
+    "cpi_stack": "cpi_stack.json",
+    "stats_interval": 64,
+    "stats_file": "interval_stats.csv",
+}
+
+# Regular expressions
+COLOR_REGEX: re.Pattern = re.compile(r"\033\[[0-9;]+m")
+TIMETICK_REGEX: re.Pattern = re.compile(r"Tick=(\d+) Info: \[.+\] Simulation complete\.")
+
+
+def move_to_root_dir() -> None:
+	os.chdir(os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
+
+
+def run(sim: str, program: str, threads: int, workdir: str, timeout: int) -> Optional[int]:
+	with open(CONFIG_PATH) as f:
+		config: Dict[str, Any] = json.load(f)
+	config["SOC"].update(OUTPUTS)
+	config["SOC"].update(PROGRAMS[program])
+
+	os.makedirs(os.path.join(workdir, os.path.dirname(CONFIG_PATH)))
+	with open(os.path.join(workdir, CONFIG_PATH), "w") as f:
+		json.dump(config, f, indent=2)
+
+	cmd: List[str] = [
+	    os.path.abspath(sim), "--asm_file_path",
+	    os.path.abspath(os.path.join(ASM_DIR, program)), "--stage_threads",
+	    str(threads)
+	]
+	proc = subprocess.run(
+	    cmd,
+	    cwd=workdir,
+	    stdout=subprocess.PIPE,
+	    stderr=subprocess.STDOUT,
+	    text=True,
+	    timeout=timeout,
+	    check=True
+	)
+
+	tick: Optional[int] = None
+	for line in proc.stdout.splitlines():
+		m = TIMETICK_REGEX.search(COLOR_REGEX.sub("", line))
+		tick = int(m.group(1)) if m else tick
+	return tick
+
+
+def canonical_trace(path: str) -> Tuple[List[str], List[Record]]:
+	with open(path, "rb") as stream:
+		op_names: List[str] = read_header(stream)
+		records: List[Record] = list(read_records(stream))
+
+	# Every thread writes its own buffers, so only the events of one unit of one core keep their order
+	# in the file; the sort is stable
+	records.sort(key=lambda r: (r.tick, r.hart, r.stage))
+	return op_names, records
+
+
+def compare(program: str, base: str, other: str, threads: int) -> List[str]:
+	diffs: List[str] = []
+
+	for name in [OUTPUTS["stats_file"], OUTPUTS["cpi_stack"], OUTPUTS["konata_trace"]]:
+		with open(os.path.join(base, name), "rb") as a, open(os.path.join(other, name), "rb") as b:
+			if a.read() != b.read():
+				diffs.append(f"{program}: {name} differs with {threads} threads")
+
+	base_ops, base_records = canonical_trace(os.path.join(base, OUTPUTS["binary_trace"]))
+	ops, records = canonical_trace(os.path.join(other, OUTPUTS["binary_trace"]))
+	if base_ops != ops or base_records != records:
+		index: int = next(
+		    (i for i, (a, b) in enumerate(zip(base_records, records)) if a != b),
+		    min(len(base_records), len(records))
+		)
+		diffs.append(
+		    f"{program}: {OUTPUTS['binary_trace']} differs with {threads} threads"
+		    f" from record {index} ({len(base_records)} vs. {len(records)} records)"
+		)
+
+	return diffs
+
+
+@click.command()
+@click.option(
+    "--sim",
+    help="The riscv executable.",
+    default="build/release/riscv",
+    type=click.Path(exists=True, dir_okay=False)
+)
+@click.option(
+    "--threads",
+    help="Stage threads of the runs compared with the single-thread run.",
+    default=[4],
+    multiple=True,
+    type=int
+)
+@click.option(
+    "--timeout", help="Time limitation in seconds for every run.", default=300, type=int
+)
+def main(sim: str, threads: List[int], timeout: int) -> None:
+	move_to_root_dir()
+	diffs: List[str] = []
+
+	for program in PROGRAMS:
+		with tempfile.TemporaryDirectory(prefix="riscv-determinism-") as tmp:
+			base: str = os.path.join(tmp, "1")
+			base_tick: Optional[int] = run(sim, program, 1, base, timeout)
+			print(f"{program}: 1 thread completes at tick {base_tick}")
+
+			for n in threads:
+				other: str = os.path.join(tmp, str(n))
+				tick: Optional[int] = run(sim, program, n, other, timeout)
+				print(f"{program}: {n} threads complete at tick {tick}")
+				if tick != base_tick:
+					diffs.append(f"{program}: completes at tick {tick} with {n} threads")
+				diffs += compare(program, base, other, n)
+
+	for diff in diffs:
+		print(diff, file=sys.stderr)
+	if diffs:
+		exit(1)
+	print("All runs are identical.")
+
+
+if __name__ == "__main__":
+	main()
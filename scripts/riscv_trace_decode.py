@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+
+# Copyright 2023-2024 Playlab/ACAL
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Decodes the binary trace written by the riscv app (SOC parameter "binary_trace") into the
+# text log lines the simulator used to print. See src/riscv/include/BinaryTrace.hh for the format.
+
+from typing import Callable, Dict, Iterator, List, NamedTuple, Optional, TextIO
+import struct
+import sys
+
+import click
+
+MAGIC: bytes = b"SOCTRC01"
+RECORD_FORMAT: struct.Struct = struct.Struct("<QIIHBBB3x")
+
+# TraceStage -> name of the unit that produced the event
+STAGE_NAMES: Dict[int, str] = {
+    0: "Single-Cycle CPU Model {}",
+    1: "IF stage model {}",
+    2: "EXE stage model {}",
+    3: "WB stage model {}",
+}
+
+
+class Record(NamedTuple):
+    tick: int
+    pc: int
+    arg: int
+    hart: int
+    stage: int
+    op: int
+    kind: int
+
+
+# TraceEvent -> message, given the record and the opcode name
+MESSAGES: Dict[int, Callable[[Record, str], str]] = {
+    0: lambda r, op: f"Instruction {op} is completed at Tick = {r.tick} | PC = {r.pc}",
+    1: lambda r, op: f"send {op}@ PC={r.pc} to IFStage successfully",
+    2: lambda r, op: f"send {op}@ PC={r.pc}, Got backpressure",
+    3: lambda r, op: f"resend {op}@ PC={r.pc} to IFStage successfully",
+    4: lambda r, op: f"issue memRead for {op} @ PC={r.pc}",
+    5: lambda r, op: f"issue memWrite for {op} @ PC={r.pc}",
+    6: lambda r, op: f"issue memAtomic for {op} @ PC={r.pc}",
+    7: lambda r, op: f"handle memory response for {op} @ PC={r.pc} after {r.arg} stall cycles",
+    8: lambda r, op: "   IFStage step() : has an inbound  InstPacket availble ",
+    9: lambda r, op: "   IFStage step() :  popped an InstPacket",
+    10: lambda r, op: "   IFStage step() :  data Hazard detected. Stall IFStage",
+    11: lambda r, op: "   IFStage step() :  control Hazard detected. Stall IFStage",
+    12: lambda r, op: f"   IFStage::instPacketHandler() has received InstPacket @PC={r.pc}"
+    " from soc-s and push it to prIF2EXE-in",
+    13: lambda r, op: f"   EXEStage step() an InstPacket @PC={r.pc} controlHazard: {'Yes' if r.arg else 'No'}",
+    14: lambda r, op: "   EXEStage step(), no inbound packet",
+    15: lambda r, op: f"   EXEStage::instPacketHandler()  has received and an InstPacket @PC={r.pc}"
+    " from prIF2EXE-out and push it to prEXE2WB-in",
+    16: lambda r, op: f"   WBStage step() pop an InstPacket @PC={r.pc}",
+    17: lambda r, op: f"   WBStage::instPacketHandler(()  has received from prEXE2WB-out and retired inst@PC={r.pc}",
+}
+
+
+def read_header(stream) -> List[str]:
+    if stream.read(len(MAGIC)) != MAGIC:
+        raise click.ClickException("Not a riscv binary trace.")
+    record_size, num_ops = struct.unpack("<II", stream.read(8))
+    if record_size != RECORD_FORMAT.size:
+        raise click.ClickException(f"Unsupported record size {record_size}, expected {RECORD_FORMAT.size}.")
+    op_names: List[str] = []
+    for _ in range(num_ops):
+        name: bytearray = bytearray()
+        while (c := stream.read(1)) not in (b"\0", b""):
+            name += c
+        op_names.append(name.decode())
+    return op_names
+
+
+def read_records(stream) -> Iterator[Record]:
+    while chunk := stream.read(RECORD_FORMAT.size * 4096):
+        if len(chunk) % RECORD_FORMAT.size:
+            print("Warning: the trace ends with a truncated record.", file=sys.stderr)
+            chunk = chunk[: len(chunk) - len(chunk) % RECORD_FORMAT.size]
+        for fields in RECORD_FORMAT.iter_unpack(chunk):
+            yield Record(*fields)
+
+
+def decode(trace: str, out: TextIO, hart: Optional[int], stage: Optional[int]) -> int:
+    with open(trace, "rb") as stream:
+        op_names: List[str] = read_header(stream)
+        records: List[Record] = [
+            r for r in read_records(stream)
+            if (hart is None or r.hart == hart) and (stage is None or r.stage == stage)
+        ]
+
+    # Buffers of different threads interleave in the file; the sort is stable, so each thread keeps its order
+    records.sort(key=lambda r: r.tick)
+    for r in records:
+        op: str = op_names[r.op] if r.op < len(op_names) else f"op{r.op}"
+        unit: str = STAGE_NAMES.get(r.stage, "unit {}").format(r.hart)
+        message: Callable[[Record, str], str] = MESSAGES.get(r.kind, lambda r, op: f"unknown event {r.kind}")
+        out.write(f"Tick={r.tick} Info: [{unit}] {message(r, op)}\n")
+    return len(records)
+
+
+@click.command()
+@click.argument("trace", type=click.Path(exists=True, dir_okay=False))
+@click.option("-o", "--output", type=click.File("w"), default="-", help="Output file, stdout by default.")
+@click.option("--hart", type=int, default=None, help="Only decode the events of this core.")
+@click.option(
+    "--stage",
+    type=click.Choice(["cpu", "if", "exe", "wb"]),
+    default=None,
+    help="Only decode the events of this unit.",
+)
+def main(trace: str, output: TextIO, hart: Optional[int], stage: Optional[str]) -> None:
+    stage_id: Optional[int] = None if stage is None else ["cpu", "if", "exe", "wb"].index(stage)
+    count: int = decode(trace, output, hart, stage_id)
+    print(f"Decoded {count} records.", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOC_INCLUDE_BINARYTRACE_HH_
+#define SOC_INCLUDE_BINARYTRACE_HH_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ACALSim.hh"
+
+/**
+ * @brief Compile-time trace level: 0 records nothing, 1 the instructions of the cores and their
+ *        memory requests, 2 also the pipeline stage models
+ * @details Set with the SOC_TRACE_LEVEL CMake cache variable. Records above the level are removed by
+ *          the compiler, so a Release build with level 0 pays nothing for tracing.
+ */
+#ifndef SOC_TRACE_LEVEL
+#define SOC_TRACE_LEVEL 2
+#endif
+
+/**
+ * @brief Records a trace event if its level is compiled in and a trace file is open
+ * @param _level Trace level of the event
+ * @details The remaining arguments are those of BinaryTrace::record().
+ */
+#define SOC_TRACE(_level, ...)                                              \
+	do {                                                                    \
+		if constexpr ((_level) <= SOC_TRACE_LEVEL) {                        \
+			if (BinaryTrace::isEnabled()) BinaryTrace::record(__VA_ARGS__); \
+		}                                                                   \
+	} while (0)
+
+/**
+ * @brief Unit that produced a trace event
+ */
+enum class TraceStage : uint8_t { CPU = 0, IF = 1, EXE = 2, WB = 3 };
+
+/**
+ * @brief Kind of a trace event
+ * @details The values are part of the file format: scripts/riscv_trace_decode.py maps each of them
+ *          to the text the simulator used to log, so new kinds are only appended.
+ */
+enum class TraceEvent : uint8_t {
+	COMMIT           = 0,   ///< An instruction is completed
+	SEND_IF          = 1,   ///< The committed instruction is sent to the IF stage
+	SEND_IF_BLOCKED  = 2,   ///< The IF stage applies backpressure
+	RESEND_IF        = 3,   ///< The blocked instruction is sent to the IF stage
+	MEM_READ         = 4,   ///< A load issues its memory request
+	MEM_WRITE        = 5,   ///< A store issues its memory request
+	MEM_ATOMIC       = 6,   ///< An atomic issues its memory request
+	MEM_RESP         = 7,   ///< A blocking memory instruction gets its response, arg = stall cycles
+	IF_INBOUND       = 8,   ///< The IF stage has an instruction waiting
+	IF_POP           = 9,   ///< The IF stage takes the instruction
+	IF_DATA_HAZARD   = 10,  ///< The IF stage stalls on a data hazard
+	IF_CTRL_HAZARD   = 11,  ///< The IF stage stalls on a control hazard
+	IF_RECEIVE       = 12,  ///< The IF stage pushes the instruction to prIF2EXE
+	EXE_INBOUND      = 13,  ///< The EXE stage has an instruction, arg = control hazard
+	EXE_IDLE         = 14,  ///< The EXE stage has no instruction
+	EXE_RECEIVE      = 15,  ///< The EXE stage pushes the instruction to prEXE2WB
+	WB_POP           = 16,  ///< The WB stage takes the instruction
+	WB_RETIRE        = 17,  ///< The WB stage retires the instruction
+};
+
+/**
+ * @brief A fixed-size trace record as stored in the file
+ */
+struct TraceRecord {
+	uint64_t tick;
+	uint32_t pc;
+	uint32_t arg;    ///< Event specific argument
+	uint16_t hartId;
+	uint8_t  stage;  ///< TraceStage
+	uint8_t  op;     ///< instr_type of the instruction, see the opcode table in the file header
+	uint8_t  kind;   ///< TraceEvent
+	uint8_t  reserved[3];
+};
+static_assert(sizeof(TraceRecord) == 24, "The trace record layout is part of the file format.");
+
+/**
+ * @class BinaryTrace
+ * @brief Structured binary trace of the cores and their pipeline stage models
+ * @details record() appends a TraceRecord to a buffer owned by the calling thread, without locks,
+ *          formatting or I/O. Full buffers are handed to a background thread that writes them to the
+ *          file. The pool holds at most 64 buffers of 4096 records besides the first buffer of each
+ *          thread. A thread that fills its buffer while the pool is exhausted blocks until the writer
+ *          has written one, so records are never dropped and memory stays bounded when the disk cannot
+ *          keep up. The file starts with the header
+ *          - 8 bytes magic "SOCTRC01"
+ *          - uint32 record size, uint32 number of opcode names
+ *          - the opcode names, each terminated by a NUL byte
+ *
+ *          followed by the records. Records of one thread keep their order, buffers of different
+ *          threads may interleave, so the decoder orders the records by tick.
+ */
+class BinaryTrace {
+public:
+	/**
+	 * @brief Opens the trace file and starts the background writer
+	 * @param _path Path of the trace file
+	 * @param _opNames Name of every instr_type, indexed by its value
+	 */
+	static void open(const std::string& _path, const std::vector<std::string>& _opNames);
+
+	/**
+	 * @brief Writes the records of every thread and closes the file
+	 * @details Must be called while no thread records, e.g. in the cleanup of the simulation.
+	 */
+	static void close();
+
+	/** @return Whether a trace file is open */
+	static bool isEnabled() { return enabled.load(std::memory_order_acquire); }
+
+	/**
+	 * @brief Appends an event to the buffer of the calling thread
+	 * @param _tick Tick of the event
+	 * @param _stage Unit that produced the event
+	 * @param _kind Kind of the event
+	 * @param _hartId Core the unit belongs to
+	 * @param _pc PC of the instruction
+	 * @param _op instr_type of the instruction
+	 * @param _arg Event specific argument
+	 */
+	static void record(acalsim::Tick _tick, TraceStage _stage, TraceEvent _kind, uint32_t _hartId, uint32_t _pc,
+	                   uint32_t _op, uint32_t _arg = 0);
+
+private:
+	static std::atomic<bool> enabled;
+};
+
+#endif  // SOC_INCLUDE_BINARYTRACE_HH_
@@ -0,0 +1,255 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOC_INCLUDE_BUS_HH_
+#define SOC_INCLUDE_BUS_HH_
+
+#include <deque>
+#include <functional>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "ACALSim.hh"
+#include "IntervalStats.hh"
+#include "PacketTarget.hh"
+
+class MMIODevice;
+
+/**
+ * @class Bus
+ * @brief AXI-style split-transaction interconnect between the masters (CPU, data cache, DMA) and the
+ *        memory-mapped targets
+ * @details Targets (the data memory and the devices) register the address range they serve. Requests
+ *          are decoded with a binary search over the range table sorted by base address, which is
+ *          kept behind a one-entry cache of the last target hit.
+ *
+ *          Reads and writes travel on two independent channels shared by all masters. A request
+ *          spends `hop_latency` cycles crossing the bus and then waits in the queue of its master
+ *          until the arbiter grants it the channel. The arbiter picks one of the masters waiting for a
+ *          free channel in round-robin order or by fixed priority, the master added first winning. A
+ *          granted request holds its channel for ceil(bytes / `data_width`) beats.
+ *
+ *          Two kinds of requests are carried:
+ *          - Packet requests (send()) are delivered to their target max(latency, 1) - 1 cycles after
+ *            the grant; a single-cycle request granted in the cycle it is sent is served within it.
+ *          - Bulk transfers (transfer()) model the data movement of a device. The callback of the
+ *            transfer is told the tick at which its last beat has been transferred.
+ *
+ *          Every master has a limit of outstanding requests, counted from the send until the request
+ *          is delivered or its last beat is transferred. As with a MasterPort push, a send beyond the
+ *          limit fails and the bus calls the retry handler with the port name of the master once one
+ *          of its requests retires.
+ */
+class Bus : public acalsim::SimModule {
+public:
+	enum Channel : uint32_t { READ = 0, WRITE = 1, NUM_CHANNELS = 2 };
+	enum class Arbitration { ROUND_ROBIN, PRIORITY };
+
+	/**
+	 * @brief A target of the bus
+	 */
+	struct Target {
+		std::string         name;
+		uint32_t            baseAddr = 0;
+		uint32_t            size     = 0;
+		acalsim::SimModule* module   = nullptr;
+		MemoryTarget        kind     = MemoryTarget::DataMemory;  ///< Type of the module for the packet visit
+		MMIODevice*         device   = nullptr;                   ///< The module as a device, or nullptr for a memory
+		uint64_t            requests = 0;
+
+		bool contains(uint32_t _addr) const { return _addr >= this->baseAddr && _addr - this->baseAddr < this->size; }
+	};
+
+	/**
+	 * @brief Constructor that reads the bus parameters from the "Bus" configuration
+	 * @param _name Name identifier for the bus
+	 */
+	Bus(std::string _name);
+
+	/**
+	 * @brief Virtual destructor
+	 */
+	virtual ~Bus() {}
+
+	/**
+	 * @brief Registers a target serving an address range
+	 * @param _name Name used in the statistics
+	 * @param _baseAddr First address of the range
+	 * @param _size Size of the range in bytes; ranges of different targets must not overlap
+	 * @param _module Module receiving the requests
+	 * @param _kind Type tag of the module, see PacketTarget.hh
+	 * @param _device The module as a memory-mapped device, or nullptr for a memory
+	 */
+	void addTarget(const std::string& _name, uint32_t _baseAddr, uint32_t _size, acalsim::SimModule* _module,
+	               MemoryTarget _kind, MMIODevice* _device = nullptr);
+
+	/**
+	 * @brief Registers a target serving an address range, tagged with the static type of the module
+	 */
+	template <typename T>
+	void addTarget(const std::string& _name, uint32_t _baseAddr, uint32_t _size, T* _module,
+	               MMIODevice* _device = nullptr) {
+		this->addTarget(_name, _baseAddr, _size, _module, MemoryTargetOf<T>::value, _device);
+	}
+
+	/**
+	 * @brief Registers a master; masters added first win priority arbitration
+	 * @param _name Name used in the statistics
+	 * @param _port Port name passed to the retry handler
+	 * @param _maxOutstanding Requests the master may have in flight
+	 * @return The master ID used to send requests
+	 */
+	uint32_t addMaster(const std::string& _name, const std::string& _port, uint32_t _maxOutstanding);
+
+	/**
+	 * @brief Connects the handler called when a master may retry a failed send
+	 * @param _handler Invoked with the port name of the master
+	 */
+	void setRetryHandler(std::function<void(const std::string&)> _handler) { this->retryHandler = _handler; }
+
+	/**
+	 * @brief Looks up the target serving an address
+	 * @param _addr Memory address to decode
+	 * @return The target, or nullptr if the address is not mapped
+	 */
+	const Target* decode(uint32_t _addr) const;
+
+	/**
+	 * @brief Checks whether a master may send a request, like MasterPort::isPushReady()
+	 * @param _when Current simulation tick
+	 * @param _master ID of the master
+	 */
+	bool isReqAcceptable(acalsim::Tick _when, uint32_t _master) {
+		Master& master = this->masters[_master];
+		return this->getOutstanding(_when, master) < master.maxOutstanding;
+	}
+
+	/**
+	 * @brief Routes a request packet to the target of its address
+	 * @param _when Simulation tick at which the request enters the bus
+	 * @param _master ID of the sending master
+	 * @param _memReqPkt Memory read or write request packet
+	 * @param _addr Address of the request
+	 * @param _bytes Bytes carried by the request or its response
+	 * @param _isWrite True for a write request
+	 * @param _latency Access latency of the target in cycles
+	 * @return False if the master has reached its outstanding limit; the packet is not taken
+	 */
+	bool send(acalsim::Tick _when, uint32_t _master, acalsim::SimPacket* _memReqPkt, uint32_t _addr, uint32_t _bytes,
+	          bool _isWrite, acalsim::Tick _latency);
+
+	/**
+	 * @brief Moves a block of data of a device over the bus
+	 * @param _when Simulation tick at which the transfer enters the bus
+	 * @param _master ID of the sending master
+	 * @param _addr First address of the block
+	 * @param _bytes Size of the block in bytes
+	 * @param _isWrite True if the block is written to the target
+	 * @param _callback Invoked at the grant with the tick at which the last beat has been transferred
+	 * @return False if the master has reached its outstanding limit; the transfer is not taken
+	 */
+	bool transfer(acalsim::Tick _when, uint32_t _master, uint32_t _addr, uint32_t _bytes, bool _isWrite,
+	              std::function<void(acalsim::Tick)> _callback);
+
+	/**
+	 * @brief Grants a channel to the waiting requests
+	 * @param _when Current simulation tick
+	 * @param _channel Channel to arbitrate
+	 */
+	void arbitrate(acalsim::Tick _when, Channel _channel);
+
+	/**
+	 * @brief Lets a master blocked by its outstanding limit retry
+	 * @param _when Current simulation tick
+	 * @param _master ID of the master
+	 */
+	void retry(acalsim::Tick _when, uint32_t _master);
+
+	/** @return The cycles a request spends crossing the bus */
+	acalsim::Tick getHopLatency() const { return this->hopLatency; }
+
+	/**
+	 * @brief Prints the channel, master and target statistics
+	 * @details Every master reports its bandwidth per channel and a histogram of its request
+	 *          latencies in power-of-two buckets.
+	 */
+	void printStats() const;
+
+	/**
+	 * @brief Registers the busy cycle and traffic counters for the interval statistics
+	 * @param _prefix Column name prefix, e.g. "bus."
+	 */
+	void addIntervalStats(IntervalStats& _stats, const std::string& _prefix) const;
+
+private:
+	struct Request {
+		acalsim::Tick                      issue   = 0;  ///< Tick at which the request was sent
+		acalsim::Tick                      arrival = 0;  ///< Tick at which the request may be granted
+		uint32_t                           bytes   = 0;
+		Target*                            target  = nullptr;
+		acalsim::SimPacket*                pkt     = nullptr;  ///< Packet of a packet request
+		bool                               isWrite = false;    ///< The packet is a MemWriteReqPacket
+		acalsim::Tick                      latency = 0;        ///< Target latency of a packet request
+		std::function<void(acalsim::Tick)> callback;           ///< Callback of a bulk transfer
+	};
+
+	using TickHeap = std::priority_queue<acalsim::Tick, std::vector<acalsim::Tick>, std::greater<acalsim::Tick>>;
+
+	struct Master {
+		std::string         name;
+		std::string         port;
+		uint32_t            maxOutstanding = 1;
+		std::deque<Request> queues[NUM_CHANNELS];    ///< Requests waiting for a grant
+		TickHeap            retireTicks;             ///< Retirement of the granted requests in flight
+		bool                blocked        = false;  ///< A send failed on the outstanding limit
+		bool                retryPending   = false;  ///< A retry event is scheduled
+
+		// Statistics
+		uint64_t              requests[NUM_CHANNELS] = {0, 0};
+		uint64_t              bytes[NUM_CHANNELS]    = {0, 0};
+		uint64_t              refused                = 0;  ///< Sends that failed on the outstanding limit
+		acalsim::Tick         waitCycles             = 0;  ///< Cycles requests waited for a grant
+		acalsim::Tick         latencySum             = 0;
+		std::vector<uint64_t> latencyHist;  ///< Bucket 0 counts latency 0, bucket b counts [2^(b-1), 2^b)
+	};
+
+	struct ChannelState {
+		acalsim::Tick freeTick      = 0;  ///< First tick at which the channel is free
+		acalsim::Tick nextArbitrate = 0;  ///< Tick of the scheduled arbitration, 0 if none
+		uint32_t      rrNext        = 0;  ///< Master checked first by the round-robin arbiter
+		acalsim::Tick busyCycles    = 0;
+	};
+
+	bool     enqueue(acalsim::Tick _when, uint32_t _master, uint32_t _addr, bool _isWrite, Request&& _req);
+	size_t   findTarget(uint32_t _addr) const;  ///< Index of the target serving an address, or targets.size()
+	uint32_t getOutstanding(acalsim::Tick _when, Master& _master);
+	void     grant(acalsim::Tick _when, Channel _channel, uint32_t _master);
+	void     scheduleArbitration(Channel _channel, acalsim::Tick _when);
+	void     scheduleRetry(uint32_t _master);
+
+	acalsim::Tick hopLatency;   ///< Cycles to cross the bus
+	uint32_t      dataWidth;    ///< Bytes per beat of a channel
+	Arbitration   arbitration;  ///< Policy choosing among the masters waiting for a channel
+
+	std::vector<Target>                     targets;  ///< Targets sorted by base address
+	mutable size_t                          lastHit;  ///< Index of the target decoded last
+	std::vector<Master>                     masters;
+	ChannelState                            channels[NUM_CHANNELS];
+	std::function<void(const std::string&)> retryHandler;
+};
+
+#endif  // SOC_INCLUDE_BUS_HH_
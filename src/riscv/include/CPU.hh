@@ -18,14 +18,21 @@
 #define SOC_INCLUDE_CPU_HH_
 
 #include <string>
+#include <vector>
 
 #include "ACALSim.hh"
+#include "Bus.hh"
+#include "CycleStack.hh"
+#include "DataCache.hh"
 #include "DataMemory.hh"
 #include "DataStruct.hh"
 #include "Emulator.hh"
 #include "InstPacket.hh"
+#include "IntervalStats.hh"
 #include "MemPacket.hh"
+#include "PCProfiler.hh"
 
+class MMIODevice;
 class SOC;
 
 /**
@@ -37,17 +44,26 @@ public:
 	/**
 	 * @brief Constructor for the CPU class
 	 * @param _name Name identifier for the CPU instance
-	 * @param _emulator Pointer to the ISA emulator
+	 * @param _soc Pointer to the SOC the core belongs to
+	 * @param _hartId Hart ID of the core, passed to software in a0 at reset
 	 */
-	CPU(std::string _name, SOC* _soc);
+	CPU(std::string _name, SOC* _soc, uint32_t _hartId = 0);
 
 	/**
 	 * @brief Destructor that frees instruction memory
 	 */
-	virtual ~CPU() { delete[] this->imem; }
+	virtual ~CPU() {
+		delete[] this->imem;
+		delete this->profiler;
+	}
 
 	/**
 	 * @brief Execute one instruction
+	 * @details With a `quantum` above one, the core keeps executing the following instructions that only
+	 *          touch its own registers in the same event, each one cycle after the previous, instead of
+	 *          scheduling an event per cycle. They cannot observe or change anything outside the core, so
+	 *          the run stops at the next memory access, at HCF or after `quantum` cycles and that
+	 *          instruction is executed at its own tick, like without running ahead.
 	 */
 	void execOneInstr();
 
@@ -65,36 +81,133 @@ public:
 
 	void retrySendInstPacket(MasterPort* mp);
 	/**
-	 * @brief Performs a memory read operation
+	 * @brief Issues a memory read request to the data memory
 	 * @param _i The instruction requesting the read
 	 * @param _op Type of instruction
 	 * @param _addr Memory address to read from
 	 * @param _a1 Operand for storing the read data
-	 * @return Whether the memory access is done or not
+	 * @return Whether the request has been issued to the memory system
+	 * @details The request is delivered after `memory_read_latency` cycles and the instruction
+	 *          is committed in memReadRespHandler() once the response comes back.
 	 */
 	bool memRead(const instr& _i, instr_type _op, uint32_t _addr, operand _a1, InstPacket* instPacket);
 
 	/**
-	 * @brief Performs a memory write operation
+	 * @brief Issues a memory write request to the data memory
 	 * @param _i The instruction requesting the write
 	 * @param _op Type of instruction
 	 * @param _addr Memory address to write to
 	 * @param _data Data to write
-	 * @return Whether the memory access is done or not
+	 * @return Whether the request has been issued to the memory system
+	 * @details The request is delivered after `memory_write_latency` cycles and the instruction
+	 *          is committed in memWriteRespHandler() once the response comes back.
 	 */
 	bool memWrite(const instr& _i, instr_type _op, uint32_t _addr, uint32_t _data, InstPacket* instPacket);
 
+	/**
+	 * @brief Issues an RV32A atomic memory operation
+	 * @param _i The atomic instruction (LR_W, SC_W or AMO*_W)
+	 * @param _addr Word address of the operation (rs1)
+	 * @param _data Source operand (rs2)
+	 * @return Whether the request has been issued to the memory system
+	 * @details The atomic is performed by the data cache once it owns the line, or by the data memory
+	 *          when there is no data cache or `atomic_location` is "memory". Its result is handled
+	 *          like the data of a load in memReadRespHandler().
+	 */
+	bool memAtomic(const instr& _i, uint32_t _addr, uint32_t _data, InstPacket* instPacket);
+
+	/**
+	 * @brief Handles the response of an outstanding memory read
+	 * @param _when Simulation tick when the response arrives
+	 * @param _memRespPkt Pointer to the memory read response packet
+	 */
+	void memReadRespHandler(acalsim::Tick _when, MemReadRespPacket* _memRespPkt);
+
+	/**
+	 * @brief Handles the response of an outstanding memory write
+	 * @param _when Simulation tick when the response arrives
+	 * @param _memRespPkt Pointer to the memory write response packet
+	 */
+	void memWriteRespHandler(acalsim::Tick _when, MemWriteRespPacket* _memRespPkt);
+
+	/**
+	 * @brief Places a non-blocking data cache between the CPU and the data memory
+	 * @param _dcache Pointer to the data cache
+	 * @details With a data cache, loads no longer block the CPU. Instructions keep executing until
+	 *          one of them depends on a load that has not returned yet (stall on use).
+	 */
+	void setDataCache(DataCache* _dcache) { this->dcache = _dcache; }
+
+	/**
+	 * @brief Connects the bus that routes the memory requests by address
+	 * @param _bus Pointer to the bus
+	 * @param _master Master ID of the CPU on the bus
+	 */
+	void setBus(Bus* _bus, uint32_t _master) {
+		this->bus       = _bus;
+		this->busMaster = _master;
+	}
+
+	/**
+	 * @brief Connects the SOC master port that sends the committed instructions to the IF stage
+	 * @param _port The port, resolved once so that committing an instruction does not look it up by name
+	 */
+	void setIFPort(MasterPort* _port) { this->ifMasterPort = _port; }
+
 	/**
 	 * @brief Returns pointer to instruction memory
 	 * @return Pointer to instruction memory array
 	 */
 	inline instr* getIMemPtr() const { return this->imem; }
 
+	/**
+	 * @brief Sets the address of the first instruction of the core
+	 * @param _pc Entry point; must be set before the simulation starts
+	 */
+	void setEntryPoint(uint32_t _pc) { this->pc = _pc; }
+
+	/** @return The hart ID of the core */
+	uint32_t getHartId() const { return this->hartId; }
+	/** @return The SOC master port that sends the committed instructions to the IF stage of the core */
+	const std::string& getIFPortName() const { return this->ifPort; }
+	/** @return Whether the core has committed HCF */
+	bool isHalted() const { return this->halted; }
+
+	/**
+	 * @brief Converts instruction type to string representation
+	 * @param _op Instruction type to convert
+	 * @return String representation of the instruction
+	 */
+	static std::string instrToString(instr_type _op);
+
 	/**
 	 * @brief Prints the contents of the register file
 	 */
 	void printRegfile() const;
 
+	/**
+	 * @brief Prints the memory access statistics of the CPU
+	 */
+	void printStats() const;
+
+	/**
+	 * @brief Registers the instruction and memory stall counters for the interval statistics
+	 * @param _prefix Column name prefix, e.g. "cpu0."
+	 */
+	void addIntervalStats(IntervalStats& _stats, const std::string& _prefix) const;
+
+	/**
+	 * @brief Fills in the cycles, instructions, memory stalls and skipped idle cycles of the core
+	 * @param _stack CPI stack of the core, whose stage components are counted by the stage models
+	 */
+	void accountCycles(CycleStack& _stack) const;
+
+	/**
+	 * @brief Charges the last instruction of the per-PC profile up to the end of the simulation
+	 * @return The profile of the core, nullptr unless SOC.pc_profile names an output file
+	 */
+	PCProfiler* finishProfile();
+
 protected:
 	/**
 	 * @brief Fetches an instruction from instruction memory
@@ -104,11 +217,80 @@ protected:
 	instr fetchInstr(uint32_t _pc) const;
 
 	/**
-	 * @brief Converts instruction type to string representation
-	 * @param _op Instruction type to convert
-	 * @return String representation of the instruction
+	 * @brief Delivers a memory request packet to the data memory or to the device mapped at its address
+	 * @param _memReqPkt The request packet to be delivered
+	 * @param _addr Memory address of the request
+	 * @param _isWrite True for a write request
+	 * @param _latency Access latency of the request in cycles
+	 * @param _uncached Bypass the data cache, e.g. for an atomic performed at memory
+	 * @details Data memory accesses go to the data cache when there is one. Everything else is
+	 *          routed by the bus, which adds its hop latency and arbitration wait to `_latency`; a
+	 *          single-cycle access granted right away by a zero-latency bus is served within the
+	 *          issuing cycle. Device registers are never cached.
+	 */
+	void sendMemReq(acalsim::SimPacket* _memReqPkt, uint32_t _addr, bool _isWrite, acalsim::Tick _latency,
+	                bool _uncached = false);
+
+	/**
+	 * @brief Schedules an ExecOneInstrEvent to execute the next instruction
+	 * @param _when Simulation tick to execute the next instruction
+	 */
+	void scheduleExecOneInstr(acalsim::Tick _when);
+
+	/**
+	 * @brief Returns the registers read or written by an instruction as a bit mask (x0 excluded)
+	 * @param _i The instruction to inspect
+	 */
+	uint32_t getRegMask(const instr& _i) const;
+
+	/**
+	 * @brief Checks whether an instruction is a load, a store or an atomic
+	 * @param _op Instruction type to check
+	 */
+	bool isMemInstr(instr_type _op) const;
+
+	/**
+	 * @brief Checks whether the core may execute an instruction ahead of the global tick
+	 * @param _i The instruction at the current PC
+	 * @details True for ALU, branch and jump instructions that do not wait for an outstanding load, as
+	 *          long as the PC is not the head of a polling loop that skipIdleLoop() may fast-forward.
+	 */
+	bool isCoreLocal(const instr& _i) const;
+
+	/** @return The tick of the instruction being executed, ahead of the global tick while running ahead */
+	acalsim::Tick getLocalTick() const { return this->runAhead ? this->runAheadTick : acalsim::top->getGlobalTick(); }
+
+	/**
+	 * @brief Observes an instruction of a candidate polling loop before it executes
+	 * @param _i The instruction at the current PC
+	 */
+	void trackIdleLoop(const instr& _i);
+
+	/**
+	 * @brief Records a taken backward branch as the closing branch of a candidate polling loop
+	 * @param _pc PC of the branch
+	 * @param _target Branch target, i.e. the first instruction of the loop
 	 */
-	std::string instrToString(instr_type _op) const;
+	void updateIdleLoopCandidate(uint32_t _pc, uint32_t _target);
+
+	/**
+	 * @brief Fast-forwards a polling loop to the next device state change
+	 * @return Whether the loop has been skipped and the next instruction rescheduled
+	 * @details Called at the head of a candidate loop. If the last two iterations took the same
+	 *          number of cycles, only read device registers and left the register file unchanged, every
+	 *          following iteration that reads the devices before their next state change is identical.
+	 *          Those iterations are skipped at once and their instructions, memory accesses and cycles
+	 *          are accounted as if they had been executed. The IF stage only updates its hazard state
+	 *          when instructions arrive, so the pipeline resumes in the same state as without skipping.
+	 */
+	bool skipIdleLoop();
+
+	/**
+	 * @brief Commits the outstanding memory instruction once its response has arrived
+	 * @param _when Simulation tick when the response arrives
+	 */
+	void completeMemInstr(acalsim::Tick _when);
+
 
 	/**
 	 * @brief Increments the instruction count
@@ -122,13 +304,72 @@ protected:
 	inline const int& getInstCount() const { return this->inst_cnt; }
 
 private:
-	instr*      imem;         ///< Pointer to instruction memory
-	Emulator*   isaEmulator;  ///< Pointer to the ISA emulator
-	uint32_t    rf[32];       ///< Register file with 32 general-purpose registers
-	uint32_t    pc;           ///< Program counter
-	int         inst_cnt;     ///< Counter for executed instructions
+	instr*      imem;          ///< Pointer to instruction memory
+	Emulator*   isaEmulator;   ///< Pointer to the ISA emulator
+	uint32_t    rf[32];        ///< Register file with 32 general-purpose registers
+	uint32_t    pc;            ///< Program counter
+	int         inst_cnt;      ///< Counter for executed instructions
+	uint32_t    hartId;        ///< Hart ID of the core
+	std::string ifPort;        ///< SOC master port to the IF stage of the core
+	MasterPort* ifMasterPort;  ///< Handle of `ifPort`, nullptr without pipeline stage models
+	bool        halted;        ///< The core has committed HCF
 	InstPacket* pendingInstPacket;
 	SOC*        soc;
+	Bus*        bus;        ///< Interconnect to the data memory and the devices
+	uint32_t    busMaster;  ///< Master ID of the CPU on the bus
+
+	InstPacket*   memInstPacket;    ///< Memory instruction waiting for its response
+	acalsim::Tick memReqTick;       ///< Tick when the outstanding memory request was issued
+	acalsim::Tick memReadLatency;   ///< Cycles of a memory read access
+	acalsim::Tick memWriteLatency;  ///< Cycles of a memory write access
+	uint64_t      memAccessCnt;     ///< Number of completed memory accesses
+	uint64_t      memStallCycles;   ///< Cycles the CPU stalled on outstanding memory accesses
+	acalsim::Tick haltTick = 0;     ///< Tick when the core committed HCF, the cycles of its CPI stack
+
+	DataCache*    dcache;            ///< Optional non-blocking data cache
+	uint32_t      pendingLoadRegs;   ///< Destination registers of outstanding loads
+	bool          loadUseStalled;    ///< Whether the next instruction waits for an outstanding load
+	acalsim::Tick loadUseStallTick;  ///< Tick when the load-use stall started
+	bool          atomicsAtMemory;   ///< Atomics bypass the data cache and are performed at memory
+
+	bool          pipelineModel;           ///< Committed instructions are sent to the IF/EXE/WB stage simulators
+	acalsim::Tick quantum;                 ///< Cycles the core may run ahead of the global tick
+	bool          runAhead       = false;  ///< execOneInstr() is executing instructions ahead of the global tick
+	acalsim::Tick runAheadTick   = 0;      ///< Local tick of the instruction executed ahead
+	acalsim::Tick runAheadNext   = 0;      ///< Tick of the next instruction while running ahead (0 if none)
+	uint64_t      runAheadInstrs = 0;      ///< Instructions executed ahead of the global tick
+	uint64_t      runAheadEvents = 0;      ///< Events that executed at least one instruction ahead
+
+	uint64_t amoCnt     = 0;
+	uint64_t lrCnt      = 0;
+	uint64_t scCnt      = 0;
+	uint64_t scFailures = 0;  ///< SCs that lost their reservation and have to be retried
+
+	struct IdleLoop {
+		bool                     candidate   = false;  ///< A backward branch has defined [head, tail]
+		uint32_t                 head        = 0;
+		uint32_t                 tail        = 0;
+		bool                     iterValid   = false;  ///< An iteration is being observed from its start
+		bool                     iterPure    = false;  ///< The iteration only polled devices and updated registers
+		acalsim::Tick            iterStart   = 0;
+		acalsim::Tick            period      = 0;  ///< Cycles of the previous iteration (0 if unknown)
+		acalsim::Tick            pollOffset  = 0;  ///< Latest device read of the iteration relative to its start
+		uint32_t                 rf[32]      = {};  ///< Register file at the start of the iteration
+		int                      instCnt     = 0;
+		uint64_t                 memAccesses = 0;
+		uint64_t                 memStalls   = 0;
+		std::vector<MMIODevice*> devices;  ///< Devices polled by the iteration
+	};
+
+	bool          idleLoopSkip;  ///< Whether polling loops on device registers are fast-forwarded
+	IdleLoop      idleLoop;
+	uint64_t      idleLoopSkips     = 0;
+	uint64_t      skippedIterations = 0;
+	uint64_t      skippedInstrs     = 0;
+	acalsim::Tick skippedCycles     = 0;
+	acalsim::Tick skippedMemStalls  = 0;  ///< Memory stall cycles of the skipped iterations
+
+	PCProfiler* profiler = nullptr;  ///< Per-PC profile, nullptr when not collected
 };
 
 #endif
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOC_INCLUDE_COHERENCE_HH_
+#define SOC_INCLUDE_COHERENCE_HH_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ACALSim.hh"
+
+class DataCache;
+
+/**
+ * @class Coherence
+ * @brief Snooping MSI/MESI coherence among the private data caches of the cores
+ * @details Every request a cache puts on the bus for a line it cannot serve locally is broadcast to
+ *          the other caches, which update the state of their copy:
+ *          - READ (BusRd, a read miss or a prefetch): a MODIFIED copy is flushed to memory, every copy
+ *            becomes SHARED. The requester installs the line SHARED if another cache keeps a copy and
+ *            EXCLUSIVE otherwise; MSI has no EXCLUSIVE state and always installs it SHARED.
+ *          - READ_EXCLUSIVE (BusRdX, a write miss) and UPGRADE (BusUpgr, a write to a SHARED copy):
+ *            every other copy is invalidated, a MODIFIED one is flushed first.
+ *
+ *          The snoop takes effect when the request is issued, which serializes the requests in the
+ *          order they reach the bus. Requests still waiting for their line fill are snooped as well,
+ *          so a later request downgrades or invalidates the line as soon as it arrives.
+ *
+ *          The caches only model timing, so coherence never changes the values software observes. It
+ *          adds the upgrade requests and the flushes to the bus and memory traffic and is the source
+ *          of the statistics: transactions, invalidations and false-sharing invalidations per cache
+ *          line. An invalidation is false sharing when the invalidated copy was referenced but never
+ *          in the words the invalidating store writes.
+ */
+class Coherence : virtual public acalsim::HashableType {
+public:
+	enum class Protocol { MSI, MESI };
+	enum Request : uint32_t { READ = 0, READ_EXCLUSIVE = 1, UPGRADE = 2, NUM_REQUESTS = 3 };
+
+	/**
+	 * @brief Outcome of a snoop in one cache
+	 */
+	struct SnoopResult {
+		bool hadCopy      = false;  ///< The cache keeps or is fetching the line
+		bool flushed      = false;  ///< A MODIFIED copy was written back
+		bool invalidated  = false;  ///< The copy was invalidated
+		bool falseSharing = false;  ///< The invalidated copy never referenced the written words
+	};
+
+	/**
+	 * @brief Constructor
+	 * @param _protocol "msi" or "mesi"
+	 */
+	Coherence(const std::string& _protocol);
+
+	/**
+	 * @brief Registers a private data cache
+	 * @param _cache The cache to keep coherent
+	 * @return The ID of the cache, passed back by snoop()
+	 */
+	uint32_t addCache(DataCache* _cache);
+
+	/** @return The coherence protocol */
+	Protocol getProtocol() const { return this->protocol; }
+
+	/**
+	 * @brief Broadcasts a request of a cache to the other caches
+	 * @param _when Simulation tick of the request
+	 * @param _requester ID of the requesting cache
+	 * @param _req Kind of the request
+	 * @param _lineAddr Address of the line
+	 * @param _writeMask Words of the line written by the request (bit i is word i), 0 for a read
+	 * @return Whether another cache keeps or is fetching a copy of the line after the request
+	 */
+	bool snoop(acalsim::Tick _when, uint32_t _requester, Request _req, uint32_t _lineAddr, uint64_t _writeMask);
+
+	/**
+	 * @brief Prints the coherence statistics and the lines with the most invalidations
+	 */
+	void printStats() const;
+
+private:
+	struct LineStats {
+		uint64_t transactions  = 0;
+		uint64_t invalidations = 0;
+		uint64_t falseSharing  = 0;
+	};
+
+	Protocol                                protocol;
+	std::vector<DataCache*>                 caches;
+	std::unordered_map<uint32_t, LineStats> lineStats;  ///< Statistics of every line put on the bus
+
+	// Statistics
+	uint64_t requests[NUM_REQUESTS] = {0, 0, 0};
+	uint64_t snoopHits              = 0;  ///< Snoops that found a copy in another cache
+	uint64_t flushes                = 0;
+	uint64_t invalidations          = 0;
+	uint64_t falseSharing           = 0;
+};
+
+#endif  // SOC_INCLUDE_COHERENCE_HH_
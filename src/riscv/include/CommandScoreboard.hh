@@ -0,0 +1,129 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOC_INCLUDE_COMMANDSCOREBOARD_HH_
+#define SOC_INCLUDE_COMMANDSCOREBOARD_HH_
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "ACALSim.hh"
+
+class MMIODevice;
+
+/**
+ * @class CommandScoreboard
+ * @brief Orders the commands of the accelerator subsystem by the memory ranges they touch
+ * @details Devices queue the commands software starts and submit them here with their read and
+ *          write footprints. A command may start once no older unfinished command of any device
+ *          conflicts with it (read-after-write, write-after-read or write-after-write on an
+ *          overlapping range). Each device still runs its own queue in order, but commands of
+ *          different devices working on disjoint ping-pong buffers overlap without software
+ *          polling in between.
+ *
+ *          The scoreboard also measures how much of the busy time of every device is overlapped
+ *          with the other devices.
+ */
+class CommandScoreboard : virtual public acalsim::HashableType {
+public:
+	struct Range {
+		uint32_t addr;
+		uint32_t bytes;
+	};
+
+	struct Footprint {
+		std::vector<Range> reads;
+		std::vector<Range> writes;
+	};
+
+	CommandScoreboard() = default;
+
+	/**
+	 * @brief Registers a device whose commands are tracked
+	 * @param _device The device; its issueCommands() is called whenever a command completes
+	 */
+	void addDevice(MMIODevice* _device);
+
+	/**
+	 * @brief Submits a queued command
+	 * @param _device Device that owns the command
+	 * @param _footprint Memory ranges read and written by the command
+	 * @param _when Simulation tick of the submission
+	 * @return The command ID, increasing in submission order
+	 */
+	uint64_t submit(MMIODevice* _device, Footprint _footprint, acalsim::Tick _when);
+
+	/** @return Whether no older unfinished command conflicts with the command */
+	bool isReady(uint64_t _id) const;
+
+	/**
+	 * @brief Marks a command as running on its device
+	 * @param _id Command ID returned by submit()
+	 * @param _when Simulation tick of the start
+	 */
+	void start(uint64_t _id, acalsim::Tick _when);
+
+	/**
+	 * @brief Retires a command and lets every device start the commands it was blocking
+	 * @param _id Command ID returned by submit()
+	 * @param _when Simulation tick of the completion
+	 */
+	void complete(uint64_t _id, acalsim::Tick _when);
+
+	/**
+	 * @brief Returns the earliest status change among the devices running a command
+	 * @param _when Current simulation tick
+	 * @return A lower bound of the next completion of a running command, or 0 if none is running
+	 */
+	acalsim::Tick getNextCompletionTick(acalsim::Tick _when) const;
+
+	/**
+	 * @brief Prints the busy, overlap and wait cycles of every device
+	 */
+	void printStats() const;
+
+private:
+	struct Command {
+		MMIODevice*   device;
+		Footprint     footprint;
+		acalsim::Tick submitTick;
+		bool          running;
+	};
+
+	struct DeviceStats {
+		MMIODevice*   device;
+		bool          running    = false;
+		uint64_t      commands   = 0;
+		acalsim::Tick busy       = 0;  ///< Cycles running a command
+		acalsim::Tick overlapped = 0;  ///< Busy cycles during which another device is busy as well
+		acalsim::Tick waiting    = 0;  ///< Cycles commands spent queued before they started
+	};
+
+	/** @brief Whether the footprint of an older command orders a younger one after it */
+	static bool  conflicts(const Footprint& _older, const Footprint& _younger);
+	/** @brief Accounts the cycles since the previous start or completion */
+	void         accumulate(acalsim::Tick _when);
+	DeviceStats& getStats(MMIODevice* _device);
+
+	std::map<uint64_t, Command> commands;  ///< Unfinished commands by ID
+	std::vector<DeviceStats>    devices;
+	uint64_t                    nextId   = 0;
+	acalsim::Tick               lastTick = 0;
+	acalsim::Tick               anyBusy  = 0;  ///< Cycles during which at least one device is busy
+};
+
+#endif  // SOC_INCLUDE_COMMANDSCOREBOARD_HH_
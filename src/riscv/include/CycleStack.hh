@@ -0,0 +1,51 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOC_INCLUDE_CYCLESTACK_HH_
+#define SOC_INCLUDE_CYCLESTACK_HH_
+
+#include <cstdint>
+
+/**
+ * @struct CycleStack
+ * @brief Cycle accounting of one core, split into the components of its CPI stack
+ * @details The IF and EXE stages count their stall cycles in step() while the simulation runs, each in
+ *          its own cache line since the stages may step on different worker threads. The CPU fills in
+ *          its part once the simulation is over, see CPU::accountCycles(). The base component is what
+ *          remains of the cycles: one per instruction plus the pipeline fill and drain.
+ */
+struct CycleStack {
+	// IF stage
+	alignas(64) uint64_t dataHazard    = 0;  ///< Cycles holding an instruction on a data hazard
+	uint64_t             controlHazard = 0;  ///< Cycles holding an instruction behind a taken branch
+
+	// EXE stage
+	alignas(64) uint64_t structural = 0;  ///< Cycles holding an instruction on a full prEXE2WB
+
+	// CPU
+	alignas(64) uint64_t cycles       = 0;  ///< Cycles until the core halted
+	uint64_t             instructions = 0;  ///< Instructions committed, including the skipped idle loops
+	uint64_t             memory       = 0;  ///< Cycles the CPU waits for memory responses
+	uint64_t             idle         = 0;  ///< Cycles of the idle loops fast-forwarded by the CPU
+
+	/** @return Cycles not attributed to a stall */
+	uint64_t base() const {
+		uint64_t stalls = this->dataHazard + this->controlHazard + this->structural + this->memory + this->idle;
+		return this->cycles > stalls ? this->cycles - stalls : 0;
+	}
+};
+
+#endif  // SOC_INCLUDE_CYCLESTACK_HH_
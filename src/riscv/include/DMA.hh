@@ -0,0 +1,268 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOC_INCLUDE_DMA_HH_
+#define SOC_INCLUDE_DMA_HH_
+
+#include <deque>
+#include <functional>
+#include <string>
+
+#include "ACALSim.hh"
+#include "DataMemory.hh"
+#include "IntervalStats.hh"
+#include "MMIODevice.hh"
+
+/**
+ * @class DMA
+ * @brief Memory-mapped DMA engine that moves 2D blocks between memories
+ * @details Register map (offsets from the base address):
+ *          - 0x00 CTRL:   bit 0 starts a transfer, bit 1 enables the completion interrupt and
+ *                         bit 2 selects descriptor mode
+ *          - 0x04 SRC:    source address
+ *          - 0x08 DST:    destination address
+ *          - 0x0C CFG:    [31:24] source stride, [23:16] destination stride, [15:8] width - 1 and
+ *                         [7:0] height - 1, all in bytes except the height in rows
+ *          - 0x10 DESC:   address of the first descriptor in descriptor mode
+ *          - 0x14 STATUS: bit 0 done and bit 3 error (both cleared by writing 0), bit 1 busy, bit 2
+ *                         command queue full
+ *          - 0x18 DONE_CNT: number of completed commands (read-only)
+ *
+ *          Starting a transfer while the engine is busy queues it, up to `queue_depth` commands. The
+ *          registers are captured when the command is queued, so software may program the next
+ *          command right away. Queued commands run in order once the command scoreboard reports no
+ *          hazard with older commands of the accelerator subsystem.
+ *
+ *          In descriptor mode the engine walks a chain of descriptors stored in memory, each made of
+ *          four words {SRC, DST, CFG, NEXT}. A NEXT of 0 terminates the chain. A chain that does not
+ *          terminate within `kMaxDescriptors` descriptors, e.g. one that loops, completes the command
+ *          with the error bit set: at the start command if the chain is already too long then, or as
+ *          soon as the engine walks past the limit otherwise.
+ *
+ *          Rows are split into bursts of at most `max_burst_beats` beats of `bus_width` bytes that do
+ *          not cross a row. A burst takes `burst_latency` cycles plus one cycle per beat, where an
+ *          unaligned start address costs an extra beat. Bursts to or from the scratchpad also wait for
+ *          its banks, and the data memory side of a burst is a transfer on the system bus, where it
+ *          competes with the other masters. With the DRAM model enabled, that side also queues one
+ *          DRAM burst per DRAM burst size it covers behind the other requests of the data memory, and
+ *          the burst completes with the later of its bus grant and its DRAM completion. Data of a
+ *          burst is copied when it completes.
+ *
+ *          The analytical timing model assumes bus-aligned rows: a row of w bytes takes
+ *          ceil(w / (max_burst_beats * bus_width)) bursts and ceil(w / bus_width) beats, and a
+ *          descriptor fetch takes `burst_latency` plus ceil(16 / bus_width) cycles. The whole command
+ *          is copied when it completes. It does not model the scratchpad or the system bus.
+ */
+class DMA : public MMIODevice {
+public:
+	enum Reg : uint32_t {
+		CTRL     = 0x00,
+		SRC      = 0x04,
+		DST      = 0x08,
+		CFG      = 0x0c,
+		DESC     = 0x10,
+		STATUS   = 0x14,
+		DONE_CNT = 0x18
+	};
+	enum Ctrl : uint32_t { CTRL_START = 1u << 0, CTRL_IRQ_EN = 1u << 1, CTRL_DESC_MODE = 1u << 2 };
+	enum Status : uint32_t {
+		STATUS_DONE       = 1u << 0,
+		STATUS_BUSY       = 1u << 1,
+		STATUS_QUEUE_FULL = 1u << 2,
+		STATUS_ERROR      = 1u << 3
+	};
+
+	static constexpr uint32_t kMaxDescriptors = 1u << 16;  ///< Longest descriptor chain of a command
+
+	/**
+	 * @brief Constructor for DMA
+	 * @param _name Name identifier for the DMA engine
+	 * @param _baseAddr Base address of the register window
+	 * @details Bus parameters are read from the "DMA" configuration.
+	 */
+	DMA(std::string _name, uint32_t _baseAddr);
+
+	/**
+	 * @brief Virtual destructor
+	 */
+	virtual ~DMA() {}
+
+	/**
+	 * @brief Completes the pending descriptor fetch or burst and starts the next one
+	 * @param _when Current simulation tick
+	 */
+	void advance(acalsim::Tick _when);
+
+	/**
+	 * @brief Connects the data memory whose DRAM model times the bursts to main memory
+	 * @param _dmem The data memory; it must also be mapped with mapMemory() for functional accesses
+	 */
+	void setDataMemory(DataMemory* _dmem) { this->dmem = _dmem; }
+
+	void          issueCommands(acalsim::Tick _when) override;
+	void          retryBusRequests(acalsim::Tick _when) override;
+	bool          isBusActive() const override { return this->running && this->getBus(); }
+	acalsim::Tick getNextStatusChangeTick(acalsim::Tick _when) const override;
+
+	/**
+	 * @brief Prints the transfer statistics of the DMA engine
+	 */
+	void printStats() const;
+
+	/**
+	 * @brief Registers the transfer counters for the interval statistics
+	 * @param _prefix Column name prefix, e.g. "dma."
+	 */
+	void addIntervalStats(IntervalStats& _stats, const std::string& _prefix) const;
+
+protected:
+	uint32_t readReg(acalsim::Tick _when, uint32_t _offset) override;
+	void     writeReg(acalsim::Tick _when, uint32_t _offset, uint32_t _data) override;
+
+	struct Transfer {
+		uint32_t src       = 0;
+		uint32_t dst       = 0;
+		uint32_t srcStride = 0;
+		uint32_t dstStride = 0;
+		uint32_t width     = 0;
+		uint32_t height    = 0;
+		uint32_t next      = 0;  ///< Next descriptor (descriptor mode only)
+		uint32_t row       = 0;  ///< Row being transferred
+		uint32_t offset    = 0;  ///< Bytes of the current row already transferred
+	};
+
+	/**
+	 * @brief Registers captured when software starts a transfer
+	 */
+	struct Command {
+		uint64_t id   = 0;  ///< Scoreboard ID
+		uint32_t ctrl = 0;
+		uint32_t src  = 0;
+		uint32_t dst  = 0;
+		uint32_t cfg  = 0;
+		uint32_t desc = 0;
+	};
+
+	void submit(acalsim::Tick _when);
+	void updateStatus();
+
+	/**
+	 * @brief Collects the memory ranges a command reads and writes
+	 * @return False if the descriptor chain of the command exceeds kMaxDescriptors
+	 */
+	bool getFootprint(const Command& _cmd, CommandScoreboard::Footprint& _footprint) const;
+
+	/**
+	 * @brief Visits the descriptors of a chain in order
+	 * @param _desc Address of the first descriptor
+	 * @param _visit Called with the address and a copy of the four words of every descriptor
+	 * @return False if the chain does not end within kMaxDescriptors descriptors
+	 */
+	bool walkChain(uint32_t _desc, const std::function<void(uint32_t, const uint32_t*)>& _visit) const;
+
+	void     start(acalsim::Tick _when);
+	void     fetchDescriptor(acalsim::Tick _when, uint32_t _addr);
+	void     loadTransfer(uint32_t _src, uint32_t _dst, uint32_t _cfg, uint32_t _next);
+	void     issueBurst(acalsim::Tick _when);
+	void     finish(acalsim::Tick _when, bool _failed = false);
+	uint32_t getBurstBytes(const Transfer& _xfer) const;
+	uint32_t getBeats(uint32_t _addr, uint32_t _bytes) const;
+	void     schedule(acalsim::Tick _when);
+
+	/**
+	 * @brief Queues the bus transfer of the current burst or descriptor fetch for an address range
+	 * @details Only the data memory is reached over the bus, the scratchpad is local to the accelerators.
+	 */
+	void requestBus(uint32_t _addr, uint32_t _bytes, bool _isWrite);
+	/** @brief Queues the DRAM bursts of the current burst or descriptor fetch for a data memory range */
+	void requestDRAM(acalsim::Tick _when, uint32_t _addr, uint32_t _bytes, bool _isWrite);
+	/** @brief Sends the queued bus transfers until the outstanding limit refuses one */
+	void sendBusRequests(acalsim::Tick _when);
+	/** @brief Ends the current burst or descriptor fetch once all its bus transfers are granted */
+	void busGranted(acalsim::Tick _done);
+	/** @brief Ends the current burst or descriptor fetch once all its DRAM bursts complete as well */
+	void dramCompleted(acalsim::Tick _done);
+	/** @brief Schedules the end of the current burst or descriptor fetch */
+	void endPhase();
+
+	/**
+	 * @brief Analytical latency of the running command
+	 * @param _cycles Set to the latency
+	 * @return False if the descriptor chain of the command exceeds kMaxDescriptors
+	 * @details O(1) for a 2D transfer; a descriptor chain costs one lookup per descriptor.
+	 */
+	bool estimateCommand(acalsim::Tick& _cycles) const;
+	/** @brief Analytical latency of a single 2D transfer described by a CFG value */
+	acalsim::Tick estimateTransfer(uint32_t _cfg) const;
+	/**
+	 * @brief Copies the whole running command at once (analytical model)
+	 * @return False if the descriptor chain exceeds kMaxDescriptors; the descriptors up to there are copied
+	 */
+	bool copyCommand();
+	/** @brief Copies a single 2D transfer at once (analytical model) */
+	void copyTransfer(uint32_t _src, uint32_t _dst, uint32_t _cfg);
+
+private:
+	uint32_t      busWidth;       ///< Bytes per bus beat
+	uint32_t      maxBurstBeats;  ///< Maximum beats of one burst
+	acalsim::Tick burstLatency;   ///< Cycles from a burst request to its first beat
+	uint32_t      queueDepth;     ///< Commands that may wait behind the running one
+
+	// Registers
+	uint32_t ctrl   = 0;
+	uint32_t src    = 0;
+	uint32_t dst    = 0;
+	uint32_t cfg    = 0;
+	uint32_t desc   = 0;
+	uint32_t status = 0;
+
+	std::deque<Command> queue;            ///< Commands waiting to start
+	Command             cmd;              ///< Running command
+	bool                running = false;  ///< A command is running
+	uint32_t            doneCnt = 0;      ///< Completed commands
+
+	Transfer      xfer;
+	bool          fetchingDesc    = false;  ///< The pending event completes a descriptor fetch
+	uint32_t      descAddr        = 0;      ///< Address of the descriptor being fetched
+	uint32_t      chainLength     = 0;      ///< Descriptors of the running command fetched so far
+	uint32_t      burstBytes      = 0;      ///< Bytes of the burst in flight
+	acalsim::Tick phaseEndTick    = 0;      ///< End of the current transfer or descriptor fetch
+	acalsim::Tick remainingCycles = 0;      ///< Bus cycles of the bursts of the transfer not issued yet
+	acalsim::Tick estimate        = 0;      ///< Analytical latency of the command in flight
+
+	struct BusRequest {
+		uint32_t addr;
+		uint32_t bytes;
+		bool     isWrite;
+	};
+	std::deque<BusRequest> busRequests;            ///< Bus transfers of the current phase not sent yet
+	uint32_t               busPending  = 0;        ///< Bus transfers of the current phase sent but not granted
+	uint32_t               dramPending = 0;        ///< DRAM accesses of the current phase not completed
+	acalsim::Tick          burstEnd    = 0;        ///< End of the current burst or descriptor fetch
+	DataMemory*            dmem        = nullptr;  ///< Data memory timing main-memory accesses, if connected
+
+	// Statistics
+	uint64_t      transfers   = 0;
+	uint64_t      descriptors = 0;
+	uint64_t      bursts      = 0;
+	uint64_t      beats       = 0;
+	uint64_t      bytes       = 0;
+	uint64_t      interrupts  = 0;
+	acalsim::Tick startTick   = 0;
+	acalsim::Tick busyCycles  = 0;
+};
+
+#endif  // SOC_INCLUDE_DMA_HH_
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOC_INCLUDE_DRAMCONTROLLER_HH_
+#define SOC_INCLUDE_DRAMCONTROLLER_HH_
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "ACALSim.hh"
+
+/**
+ * @class DRAMController
+ * @brief Cycle-approximate DRAM timing model used as the backend of DataMemory
+ * @details Models independent channels, each with a shared data bus and a set of banks that keep
+ *          one open row in their row buffer. Requests are scheduled per channel with FR-FCFS:
+ *          the oldest request that hits an open row is served first, otherwise the oldest request
+ *          whose bank is ready. At most one command is issued per channel in a cycle.
+ *
+ *          The controller only computes timing. It does not hold any data and does not schedule
+ *          events by itself; the owner calls issue() whenever a request arrives or the tick
+ *          returned by getNextIssueTick() is reached, and delivers the returned completions.
+ *
+ *          Address mapping (low to high bits): burst offset, channel, column, bank, row.
+ */
+class DRAMController : virtual public acalsim::HashableType {
+public:
+	using Callback   = std::function<void()>;
+	using Completion = std::pair<acalsim::Tick, Callback>;
+
+	/**
+	 * @brief Constructor that reads the organization and timing from the "DRAM" configuration
+	 */
+	DRAMController();
+
+	/**
+	 * @brief Queues a request for one burst
+	 * @param _when Arrival tick of the request
+	 * @param _addr Memory address of the request
+	 * @param _isWrite True for a write burst
+	 * @param _callback Invoked when the data transfer finishes (may be empty)
+	 */
+	void enqueue(acalsim::Tick _when, uint32_t _addr, bool _isWrite, Callback _callback);
+
+	/**
+	 * @brief Queues one burst request per burst covered by an access, e.g. a cache line fill
+	 * @param _when Arrival tick of the access
+	 * @param _addr First byte of the access
+	 * @param _bytes Size of the access in bytes, at least one burst is transferred
+	 * @param _isWrite True for a write access
+	 * @param _callback Invoked when the last of the bursts finishes (may be empty)
+	 */
+	void enqueueAccess(acalsim::Tick _when, uint32_t _addr, uint32_t _bytes, bool _isWrite, Callback _callback);
+
+	/**
+	 * @brief Issues every request that can be scheduled at the given tick
+	 * @param _when Current simulation tick
+	 * @param _completions Receives (completion tick, callback) pairs of the issued requests
+	 */
+	void issue(acalsim::Tick _when, std::vector<Completion>& _completions);
+
+	/**
+	 * @brief Returns the earliest tick after _when at which a queued request may be issued
+	 * @param _when Current simulation tick
+	 * @return The next issue tick, or 0 when no request is queued
+	 */
+	acalsim::Tick getNextIssueTick(acalsim::Tick _when) const;
+
+	/**
+	 * @brief Prints row buffer and bandwidth statistics
+	 */
+	void printStats() const;
+
+private:
+	struct Request {
+		bool          isWrite;
+		size_t        bank;
+		uint32_t      row;
+		acalsim::Tick arrival;
+		Callback      callback;
+	};
+
+	struct Bank {
+		bool          rowOpen   = false;
+		uint32_t      openRow   = 0;
+		acalsim::Tick readyTick = 0;  ///< Earliest tick of the next command to this bank
+	};
+
+	struct Channel {
+		std::vector<Bank>   banks;
+		std::deque<Request> queue;
+		acalsim::Tick       busFreeTick   = 0;
+		acalsim::Tick       lastIssueTick = 0;
+		bool                issued        = false;  ///< A command was issued at lastIssueTick
+	};
+
+	bool isRowHit(const Channel& _channel, const Request& _req) const;
+
+	std::vector<Channel> channels;
+	size_t               burstSize;
+	size_t               burstsPerRow;
+	bool                 closedPage;
+	acalsim::Tick        tRCD;
+	acalsim::Tick        tCAS;
+	acalsim::Tick        tRP;
+	acalsim::Tick        tBurst;
+
+	// Statistics
+	uint64_t reads           = 0;
+	uint64_t writes          = 0;
+	uint64_t rowHits         = 0;
+	uint64_t rowEmpty        = 0;  ///< Accesses to a precharged bank
+	uint64_t rowConflicts    = 0;  ///< Accesses that had to close another row first
+	uint64_t readLatencySum  = 0;
+	uint64_t busBusyCycles   = 0;
+	size_t   peakQueueLength = 0;
+};
+
+#endif  // SOC_INCLUDE_DRAMCONTROLLER_HH_
@@ -0,0 +1,252 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOC_INCLUDE_DATACACHE_HH_
+#define SOC_INCLUDE_DATACACHE_HH_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ACALSim.hh"
+#include "Bus.hh"
+#include "Coherence.hh"
+#include "DataMemory.hh"
+#include "DataStruct.hh"
+#include "IntervalStats.hh"
+#include "MemPacket.hh"
+#include "Prefetcher.hh"
+
+/**
+ * @class DataCache
+ * @brief Non-blocking L1 data cache placed between the CPU and DataMemory
+ * @details Models a set-associative, write-back and write-allocate cache with LRU replacement.
+ *          Misses are tracked by a configurable number of MSHRs. A miss to a line that already
+ *          owns an MSHR is merged into it (secondary miss), and hits are served while misses are
+ *          outstanding (hit-under-miss). An optional Prefetcher observes the demand accesses and
+ *          issues line fills into free MSHRs, always leaving one MSHR for demand misses.
+ *
+ *          The cache only models timing. Data is accessed functionally in DataMemory when a request
+ *          arrives, so outstanding misses never observe out-of-order memory contents.
+ *
+ *          Lines are tracked in the MESI states. Without a Coherence hub every fill is EXCLUSIVE and
+ *          the first store makes it MODIFIED, which is a plain write-back cache. With one, the cache
+ *          is a private L1 of a core: its bus requests are snooped by its peers, and a store to a
+ *          SHARED line is posted while an MSHR upgrades the line on the bus.
+ */
+class DataCache : public acalsim::SimModule {
+public:
+	/**
+	 * @brief Constructor for DataCache
+	 * @param _name Name identifier for the cache module
+	 * @param _dmem Backing data memory that holds the functional data
+	 */
+	DataCache(std::string _name, DataMemory* _dmem);
+
+	/**
+	 * @brief Virtual destructor
+	 */
+	virtual ~DataCache() {}
+
+	/**
+	 * @brief Connects the bus that carries the line fills to the data memory
+	 * @param _bus Pointer to the bus
+	 * @param _master Master ID of the cache on the bus; it must allow one request per MSHR
+	 */
+	void setBus(Bus* _bus, uint32_t _master) {
+		this->bus       = _bus;
+		this->busMaster = _master;
+	}
+
+	/**
+	 * @brief Registers the cache with the coherence hub of the private caches
+	 * @param _coherence Pointer to the coherence hub
+	 */
+	void setCoherence(Coherence* _coherence) {
+		this->coherence = _coherence;
+		this->cacheId   = _coherence->addCache(this);
+	}
+
+	/**
+	 * @brief Checks whether the cache can take a new request
+	 * @param _addr Memory address of the request
+	 * @param _isWrite Whether the request is a store, which needs an MSHR to upgrade a SHARED line
+	 * @return False when the request needs an MSHR and no MSHR (or MSHR target slot) is available
+	 * @note A rejected request is expected to be retried in the next cycle, so every rejection is
+	 *       accounted as one MSHR-exhaustion stall cycle.
+	 */
+	bool isReqAcceptable(uint32_t _addr, bool _isWrite = false);
+
+	/**
+	 * @brief Handles memory read request packets from the CPU
+	 * @param _when Simulation time tick when the request was received
+	 * @param _memReqPkt Pointer to the memory read request packet
+	 * @details Also performs the atomic memory operations of the CPU. An SC or AMO that writes the
+	 *          line returns its value once the cache owns the line in MODIFIED state.
+	 */
+	void memReadReqHandler(acalsim::Tick _when, MemReadReqPacket* _memReqPkt);
+
+	/**
+	 * @brief Handles memory write request packets from the CPU
+	 * @param _when Simulation time tick when the request was received
+	 * @param _memReqPkt Pointer to the memory write request packet
+	 * @details Stores are posted. They are acknowledged after the hit latency even if the line
+	 *          has to be allocated by an MSHR.
+	 */
+	void memWriteReqHandler(acalsim::Tick _when, MemWriteReqPacket* _memReqPkt);
+
+	/**
+	 * @brief Gives up the line of an atomic memory operation performed at memory
+	 * @param _when Simulation tick of the atomic
+	 * @param _addr Address of the atomic
+	 * @details The copy of this cache is written back if it is dirty and invalidated, and the other
+	 *          caches are snooped like for a write miss, so no cache holds the line the atomic updates.
+	 */
+	void releaseLine(acalsim::Tick _when, uint32_t _addr);
+
+	/**
+	 * @brief Handles the response of a line fill issued by an MSHR
+	 * @param _when Simulation tick when the line arrives
+	 * @param _lineAddr Address of the filled cache line
+	 * @param _memRespPkt The response packet from DataMemory
+	 */
+	void lineFillRespHandler(acalsim::Tick _when, uint32_t _lineAddr, MemReadRespPacket* _memRespPkt);
+
+	/**
+	 * @brief Applies a request of another cache to the copy of a line
+	 * @param _when Simulation tick of the request
+	 * @param _req Kind of the request
+	 * @param _lineAddr Address of the line
+	 * @param _writeMask Words of the line written by the request
+	 * @return What the snoop found and did in this cache
+	 */
+	Coherence::SnoopResult snoop(acalsim::Tick _when, Coherence::Request _req, uint32_t _lineAddr,
+	                             uint64_t _writeMask);
+
+	/**
+	 * @brief Prints the cache and MSHR statistics
+	 */
+	void printStats() const;
+
+	/**
+	 * @brief Registers the access and miss counters for the interval statistics
+	 * @param _prefix Column name prefix, e.g. "dcache0."
+	 */
+	void addIntervalStats(IntervalStats& _stats, const std::string& _prefix) const;
+
+protected:
+	enum class State : uint8_t { INVALID, SHARED, EXCLUSIVE, MODIFIED };
+
+	struct CacheLine {
+		State    state      = State::INVALID;
+		bool     prefetched = false;  ///< Filled by a prefetch and not referenced yet
+		uint32_t tag        = 0;
+		uint64_t lastUse    = 0;  ///< LRU timestamp
+		uint64_t wordMask   = 0;  ///< Words referenced since the line was installed (bit i is word i)
+
+		bool isValid() const { return this->state != State::INVALID; }
+		bool isDirty() const { return this->state == State::MODIFIED; }
+	};
+
+	struct MSHRTarget {
+		bool                                    isWrite;  ///< Makes the line dirty (stores, SC and AMOs)
+		bool                                    hasResp;  ///< Returns data to the CPU (loads and atomics)
+		instr                                   i;
+		instr_type                              op;
+		uint32_t                                data;  ///< Load data captured when the request arrived
+		operand                                 a1;
+		std::function<void(MemReadRespPacket*)> callback;
+	};
+
+	struct MSHR {
+		bool                    valid     = false;
+		bool                    prefetch  = false;  ///< Allocated by the prefetcher without demand targets
+		bool                    exclusive = false;  ///< Requested ownership (BusRdX or BusUpgr)
+		bool                    shared    = false;  ///< Another cache keeps a copy, install the line SHARED
+		bool                    stolen    = false;  ///< A later request invalidated the line, do not keep it
+		uint32_t                lineAddr  = 0;
+		uint64_t                wordMask  = 0;  ///< Words referenced by the targets
+		acalsim::Tick           allocTick = 0;
+		std::vector<MSHRTarget> targets;
+	};
+
+	uint32_t   getLineAddr(uint32_t _addr) const { return _addr / this->lineSize * this->lineSize; }
+	uint64_t   getWordMask(uint32_t _addr) const { return uint64_t(1) << (_addr % this->lineSize / 4); }
+	CacheLine* lookup(uint32_t _lineAddr);
+	MSHR*      findMSHR(uint32_t _lineAddr);
+	MSHR*      allocateMSHR(acalsim::Tick _when, uint32_t _lineAddr);
+	void       freeMSHR(acalsim::Tick _when, MSHR* _mshr);
+	CacheLine* installLine(acalsim::Tick _when, uint32_t _lineAddr, State _state, bool _prefetched);
+	void       issueLineFill(acalsim::Tick _when, uint32_t _lineAddr, bool _upgrade = false);
+	bool       writeAccess(acalsim::Tick _when, uint32_t _addr, const MSHRTarget& _target, bool& _trigger);
+	bool       snoopPeers(acalsim::Tick _when, Coherence::Request _req, uint32_t _addr);
+	void       issuePrefetches(acalsim::Tick _when, uint32_t _pc, uint32_t _addr, bool _trigger);
+	void       sendReadResp(const MSHRTarget& _target);
+	void       respond(acalsim::Tick _latency, std::function<void()> _callback);
+	void       updateOccupancy(acalsim::Tick _when);
+
+private:
+	DataMemory* dmem;                 ///< Backing memory for functional accesses and line fills
+	Bus*        bus       = nullptr;  ///< Interconnect carrying the line fills
+	uint32_t    busMaster = 0;        ///< Master ID of the cache on the bus
+	Coherence*  coherence = nullptr;  ///< Coherence hub of the private caches, if any
+	uint32_t    cacheId   = 0;        ///< ID of the cache in the coherence hub
+
+	size_t        lineSize;
+	size_t        numSets;
+	size_t        numWays;
+	size_t        maxTargets;
+	acalsim::Tick hitLatency;
+	acalsim::Tick memReadLatency;
+
+	std::vector<CacheLine> lines;  ///< numSets * numWays cache lines
+	std::vector<MSHR>      mshrs;
+	uint64_t               useCnt = 0;
+
+	std::unique_ptr<Prefetcher> prefetcher;          ///< Optional hardware prefetcher
+	std::vector<uint32_t>       prefetchCandidates;  ///< Scratch buffer for Prefetcher::notify()
+
+	// Statistics
+	uint64_t      reads                 = 0;
+	uint64_t      writes                = 0;
+	uint64_t      readHits              = 0;
+	uint64_t      writeHits             = 0;
+	uint64_t      primaryMisses         = 0;
+	uint64_t      secondaryMisses       = 0;
+	uint64_t      hitUnderMiss          = 0;
+	uint64_t      writebacks            = 0;
+	uint64_t      mshrFullStallCycles   = 0;
+	uint64_t      targetFullStallCycles = 0;
+	size_t        activeMSHRs           = 0;
+	size_t        peakMSHRs             = 0;
+	uint64_t      occupancyIntegral     = 0;  ///< Sum of busy MSHRs over cycles
+	acalsim::Tick lastOccupancyTick     = 0;
+	uint64_t      prefetchesIssued      = 0;
+	uint64_t      prefetchesDropped     = 0;  ///< Candidates dropped for lack of a free MSHR
+	uint64_t      prefetchHits          = 0;  ///< Demand hits on prefetched lines (timely)
+	uint64_t      latePrefetches        = 0;  ///< Demand misses merged into an in-flight prefetch
+	uint64_t      unusedPrefetches      = 0;  ///< Prefetched lines evicted before any use
+	uint64_t      upgrades              = 0;  ///< Stores to SHARED lines
+	uint64_t      snoopFlushes          = 0;  ///< MODIFIED lines written back for another cache
+	uint64_t      invalidationsReceived = 0;
+	uint64_t      falseSharingReceived  = 0;  ///< Invalidations of lines that never referenced the written words
+	uint64_t      atomics               = 0;  ///< Atomics performed at the cache
+	uint64_t      atomicMisses          = 0;  ///< Atomics that waited for the line or its ownership
+	uint64_t      farAtomics            = 0;  ///< Atomics performed at memory
+};
+
+#endif  // SOC_INCLUDE_DATACACHE_HH_
@@ -17,10 +17,13 @@
 #ifndef SOC_INCLUDE_DATAMEMORY_HH_
 #define SOC_INCLUDE_DATAMEMORY_HH_
 
+#include <memory>
 #include <string>
+#include <unordered_map>
 
 #include "ACALSim.hh"
 #include "BaseMemory.hh"
+#include "DRAMController.hh"
 #include "DataStruct.hh"
 #include "MemPacket.hh"
 
@@ -29,7 +32,9 @@
  * @brief Data memory module for the system
  * @details Implements a memory module that handles both read and write operations
  *          Inherits from SimModule for simulation functionality and BaseMemory
- *          for basic memory operations
+ *          for basic memory operations. When the "DRAM" configuration is enabled, read responses
+ *          are timed by a DRAMController, while writes are acknowledged on arrival and drained to
+ *          DRAM in the background.
  */
 class DataMemory : public acalsim::SimModule, public BaseMemory {
 public:
@@ -38,28 +43,107 @@ public:
 	 * @param _name Name identifier for the memory module
 	 * @param _size Size of the memory in bytes
 	 */
-	DataMemory(std::string _name, size_t _size) : acalsim::SimModule(_name), BaseMemory(_size) {}
+	DataMemory(std::string _name, size_t _size);
 
 	/**
 	 * @brief Virtual destructor
 	 */
 	virtual ~DataMemory() {}
 
+	/**
+	 * @brief Functionally performs a load from memory
+	 * @param _op Load instruction type that determines the access width and sign extension
+	 * @param _addr Memory address to read from
+	 * @return The loaded value extended to 32 bits
+	 */
+	uint32_t loadData(instr_type _op, uint32_t _addr);
+
+	/**
+	 * @brief Functionally performs a store to memory
+	 * @param _op Store instruction type that determines the access width
+	 * @param _addr Memory address to write to
+	 * @param _data Data to write
+	 */
+	void storeData(instr_type _op, uint32_t _addr, uint32_t _data);
+
+	/**
+	 * @brief Functionally performs an RV32A atomic memory operation
+	 * @param _op LR_W, SC_W or one of the AMO*_W instruction types
+	 * @param _addr Word address of the operation
+	 * @param _data Source operand (rs2)
+	 * @param _hartId Hart ID of the requesting core
+	 * @return The value written to rd: the original memory word, or 0/1 for a successful/failed SC
+	 * @details LR registers a reservation on the word for the hart. Any store to the word, atomic or
+	 *          not, clears the reservations of all harts on it, so an SC only succeeds if no store
+	 *          reached the word since the LR of the same hart.
+	 */
+	uint32_t atomicData(instr_type _op, uint32_t _addr, uint32_t _data, uint32_t _hartId);
+
 	/**
 	 * @brief Handles memory read request packets
 	 * @param _when Simulation time tick when the request was received
 	 * @param _memReqPkt Pointer to the memory read request packet
-	 * @details Processes incoming read requests and generates appropriate responses
+	 * @details Processes incoming read requests and returns a MemReadRespPacket through the request callback
 	 */
-	uint32_t memReadReqHandler(acalsim::Tick _when, MemReadReqPacket* _memReqPkt);
+	void memReadReqHandler(acalsim::Tick _when, MemReadReqPacket* _memReqPkt);
 
 	/**
 	 * @brief Handles memory write request packets
 	 * @param _when Simulation time tick when the request was received
 	 * @param _memReqPkt Pointer to the memory write request packet
-	 * @details Processes incoming write requests and updates memory contents
+	 * @details Processes incoming write requests, updates memory contents and returns a MemWriteRespPacket
+	 *          through the request callback
 	 */
 	void memWriteReqHandler(acalsim::Tick _when, MemWriteReqPacket* _memReqPkt);
+
+	/**
+	 * @brief Posts timing-only write bursts to the DRAM model, e.g. a cache line write-back
+	 * @param _when Simulation tick of the write
+	 * @param _addr Address of the written data
+	 * @param _bytes Size of the written data, one burst per DRAM burst it covers
+	 * @note Data is already up to date in memory, so this only occupies the DRAM model.
+	 */
+	void postWrite(acalsim::Tick _when, uint32_t _addr, uint32_t _bytes = 4);
+
+	/**
+	 * @brief Times a block access of a device on the DRAM model, e.g. a DMA burst
+	 * @param _when Simulation tick of the access
+	 * @param _addr First address of the access
+	 * @param _bytes Size of the access, one request per DRAM burst it covers
+	 * @param _isWrite True for a write access
+	 * @param _callback Invoked at the tick the last DRAM burst of the access completes
+	 * @note The device moves the data itself, so this only occupies the DRAM model. Requires hasDRAM().
+	 */
+	void accessDRAM(acalsim::Tick _when, uint32_t _addr, uint32_t _bytes, bool _isWrite,
+	                DRAMController::Callback _callback);
+
+	/** @return Whether accesses are timed by the DRAM model */
+	bool hasDRAM() const { return (bool)this->dram; }
+
+	/**
+	 * @brief Runs the DRAM scheduler and delivers the responses of the issued requests
+	 * @param _when Current simulation tick
+	 */
+	void issueDRAMRequests(acalsim::Tick _when);
+
+	/**
+	 * @brief Prints the atomic memory operation statistics and the DRAM statistics if the DRAM model is enabled
+	 */
+	void printStats() const;
+
+private:
+	std::unique_ptr<DRAMController> dram;          ///< Optional DRAM timing backend
+	acalsim::Tick                   dramWakeTick;  ///< Earliest pending DRAMIssueEvent (0 if none)
+
+	std::unordered_map<uint32_t, uint32_t> reservations;  ///< Word reserved by LR, indexed by hart ID
+	std::unordered_map<uint32_t, uint32_t> lastAtomic;    ///< Hart of the latest atomic, indexed by word
+
+	// Statistics
+	uint64_t amoCnt       = 0;
+	uint64_t lrCnt        = 0;
+	uint64_t scCnt        = 0;
+	uint64_t scFailures   = 0;
+	uint64_t contendedCnt = 0;  ///< Atomics to a word whose previous atomic came from another hart
 };
 
 #endif
@@ -62,9 +62,24 @@ typedef enum {
 	SW,
 	XOR,
 	XORI,
+	// RV32A
+	LR_W,
+	SC_W,
+	AMOSWAP_W,
+	AMOADD_W,
+	AMOXOR_W,
+	AMOAND_W,
+	AMOOR_W,
+	AMOMIN_W,
+	AMOMAX_W,
+	AMOMINU_W,
+	AMOMAXU_W,
 	HCF
 } instr_type;
 
+/** @return Whether the instruction is an RV32A atomic memory operation (LR/SC included) */
+inline bool isAtomicOp(instr_type _op) { return _op >= LR_W && _op <= AMOMAXU_W; }
+
 typedef struct {
 	char* src;
 	int   offset;
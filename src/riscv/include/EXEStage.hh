@@ -20,12 +20,15 @@
 #include <string>
 
 #include "ACALSim.hh"
+#include "BinaryTrace.hh"
+#include "CycleStack.hh"
 #include "InstPacket.hh"
+#include "KonataTrace.hh"
 #include "SOC.hh"
 
 class EXEStage : public acalsim::CPPSimBase {
 public:
-	EXEStage(std::string name) : acalsim::CPPSimBase(name) {}
+	EXEStage(std::string name, uint32_t _hartId = 0) : acalsim::CPPSimBase(name), hartId(_hartId) {}
 	~EXEStage() {}
 
 	void init() override {}
@@ -33,7 +36,28 @@ public:
 	void cleanup() override {}
 	void instPacketHandler(Tick when, SimPacket* pkt);
 
+	/**
+	 * @brief Sets the CPI stack receiving the structural stall cycles, nullptr to not count them
+	 */
+	void setCycleStack(CycleStack* _stack) { this->cycleStack = _stack; }
+
+	/**
+	 * @brief Resolves the pipe register handles used by step(), see IFStage::bindHandles()
+	 */
+	void bindHandles() {
+		this->prIF2EXE = this->getPipeRegister("prIF2EXE-out");
+		this->prEXE2WB = this->getPipeRegister("prEXE2WB-in");
+	}
+
+	/** @return Whether an instruction of the IF stage is waiting */
+	bool hasWork() { return this->prIF2EXE->isValid(); }
+
 private:
+	uint32_t         hartId;                ///< Core the stage belongs to
+	SimPipeRegister* prIF2EXE   = nullptr;  ///< Pipe register from the IF stage
+	SimPipeRegister* prEXE2WB   = nullptr;  ///< Pipe register to the WB stage
+	CycleStack*      cycleStack = nullptr;  ///< CPI stack of the core, nullptr when not collected
+
 	InstPacket* WBInstPacket = nullptr;
 };
 
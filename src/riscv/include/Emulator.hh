@@ -25,6 +25,7 @@
 #include <string.h>
 
 #include <memory>
+#include <string>
 
 #include "ACALSim.hh"
 #include "DataMemory.hh"
@@ -43,6 +44,7 @@ public:
 	int      parse_reg(char* _tok, int _line, bool _strict = true);
 	uint32_t parse_imm(char* _tok, int _bits, int _line, bool _strict = true);
 	void     parse_mem(char* _tok, int* _reg, uint32_t* _imm, int _bits, int _line);
+	void     parse_amo_addr(char* _tok, int* _reg, int _line);
 	int      parse_assembler_directive(int _line, char* _ftok, uint8_t* _mem, int _memoff);
 	int      parse_instr(int _line, char* _ftok, instr* _imem, int _memoff, label_loc* _labels, source* _src);
 	instr_type parse_instr(char* _tok);
@@ -59,6 +61,13 @@ public:
 	void     normalize_labels(instr* _imem);
 	void     normalize_labels(instr* _imem, label_loc* _labels, int _label_count, source* _src);
 
+	/**
+	 * @brief Looks up a label of the parsed program
+	 * @param _label Label name without the colon, matched case-insensitively like the parser does
+	 * @return The address of the label, or -1 if the program has no such label
+	 */
+	int find_label(const std::string& _label) const;
+
 private:
 	label_loc* labels;
 	int        label_count;
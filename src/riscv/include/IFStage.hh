@@ -20,12 +20,15 @@
 #include <string>
 
 #include "ACALSim.hh"
+#include "BinaryTrace.hh"
+#include "CycleStack.hh"
 #include "Emulator.hh"
 #include "InstPacket.hh"
+#include "KonataTrace.hh"
 
 class IFStage : public acalsim::CPPSimBase {
 public:
-	IFStage(std::string name) : acalsim::CPPSimBase(name) {}
+	IFStage(std::string name, uint32_t _hartId = 0) : acalsim::CPPSimBase(name), hartId(_hartId) {}
 	~IFStage() {}
 
 	void init() override {}
@@ -35,9 +38,53 @@ public:
 	int  getDestReg(const instr& _inst);
 	bool checkDataHazard(int _rd, const instr& _inst);
 
+	/**
+	 * @brief Sets the CPI stack receiving the hazard stall cycles, nullptr to not count them
+	 */
+	void setCycleStack(CycleStack* _stack) { this->cycleStack = _stack; }
+
+	/**
+	 * @brief Resolves the port and pipe register handles used by step()
+	 * @details Called by SOCTop once the port and the pipe registers are connected, so that no port
+	 *          is looked up by name during the simulation.
+	 * @param _socPort Port receiving the instructions of the SOC, the "soc-s" port of the stage or the
+	 *        one of the StageScheduler stepping it
+	 */
+	void bindHandles(SlavePort* _socPort) {
+		this->socPort  = _socPort;
+		this->prIF2EXE = this->getPipeRegister("prIF2EXE-in");
+	}
+
+	/**
+	 * @brief Marks the stage as stepped by a StageScheduler, which keeps stepping it during a stall
+	 */
+	void setScheduled() { this->scheduled = true; }
+
+	/** @return Whether an instruction of the SOC is waiting */
+	bool hasWork() { return this->socPort->isPopValid(); }
+
 private:
+	/**
+	 * @brief Starts the pipeline trace stall of the instruction held on a hazard, once per stall
+	 */
+	void beginStall(Tick _when, const char* _cause);
+
+	/**
+	 * @brief Ends the pipeline trace stall if the popped instruction was held
+	 */
+	void endStall(Tick _when, InstPacket* _pkt);
+
+	uint32_t         hartId;                ///< Core the stage belongs to
+	SlavePort*       socPort    = nullptr;  ///< Committed instructions from the SOC
+	SimPipeRegister* prIF2EXE   = nullptr;  ///< Pipe register to the EXE stage
+	CycleStack*      cycleStack = nullptr;  ///< CPI stack of the core, nullptr when not collected
+	bool             scheduled  = false;    ///< Stepped by a StageScheduler instead of the framework
+
 	InstPacket* EXEInstPacket = nullptr;
 	InstPacket* WBInstPacket  = nullptr;
+
+	InstPacket* stalledPacket = nullptr;  ///< Instruction held on a hazard, for the pipeline trace
+	const char* stallCause    = nullptr;  ///< Stall name of `stalledPacket` in the pipeline trace
 };
 
 #endif  // SRC_RISCV_INCLUDE_IFSTAGE_HH_
@@ -21,6 +21,7 @@
 
 #include "ACALSim.hh"
 #include "DataStruct.hh"
+#include "PacketTarget.hh"
 
 using namespace acalsim;
 
@@ -33,6 +34,11 @@ public:
 	void visit(Tick _when, SimModule& _module) override;
 	void visit(Tick _when, SimBase& _simulator) override;
 
+	// Direct delivery to a pipeline stage, one overload per SOC_STAGE_TARGETS entry
+#define SOC_DECLARE_VISIT(_stage) void visit(Tick _when, _stage& _simulator);
+	SOC_STAGE_TARGETS(SOC_DECLARE_VISIT)
+#undef SOC_DECLARE_VISIT
+
 	void renew(const instr& _i) {
 		inst          = _i;
 		isTakenBranch = false;
@@ -43,6 +49,7 @@ public:
 	std::string str;
 	uint32_t    pc;
 	bool        isTakenBranch;
+	uint64_t    traceId = 0;  ///< Pipeline trace handle, assigned by the CPU when KonataTrace is open
 };
 
 #endif  // SRC_RISCV_INCLUDE_INSTPACKET_HH_
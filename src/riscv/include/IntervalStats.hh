@@ -0,0 +1,102 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOC_INCLUDE_INTERVALSTATS_HH_
+#define SOC_INCLUDE_INTERVALSTATS_HH_
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "ACALSim.hh"
+
+/**
+ * @class IntervalStats
+ * @brief Time series of the statistics counters, sampled every `interval` ticks
+ * @details The modules register their counters with addCounter(). Every sample writes one CSV row with
+ *          the tick, the cycles since the previous sample and the increment of every counter, followed
+ *          by the ratio columns registered with addRatio(), e.g. IPC or miss rates over the interval.
+ *          SOCTop samples in the serial phase of the tick, so the counters of all simulators are stable.
+ *          Ticks without events may be skipped by the simulation, so a row is written at the first
+ *          sampled tick past every interval boundary and its cycles column gives the actual length.
+ */
+class IntervalStats {
+public:
+	using Probe = std::function<uint64_t()>;
+
+	/**
+	 * @param _path Output CSV file
+	 * @param _interval Ticks between two samples
+	 */
+	IntervalStats(const std::string& _path, acalsim::Tick _interval);
+
+	/**
+	 * @brief Adds a counter column, before the first sample
+	 * @param _name Column name
+	 * @param _probe Reads the current value of the counter
+	 */
+	void addCounter(const std::string& _name, Probe _probe);
+
+	/**
+	 * @brief Adds a column dividing the increments of two counter columns
+	 * @param _name Column name
+	 * @param _num Numerator column
+	 * @param _den Denominator column, "cycles" for a per-cycle rate
+	 */
+	void addRatio(const std::string& _name, const std::string& _num, const std::string& _den);
+
+	/**
+	 * @brief Writes a row once the tick has passed the next interval boundary
+	 */
+	void sample(acalsim::Tick _now) {
+		if (_now >= this->nextTick) this->record(_now);
+	}
+
+	/**
+	 * @brief Writes the last, partial interval and closes the file
+	 */
+	void finish(acalsim::Tick _now);
+
+private:
+	void record(acalsim::Tick _now);
+
+	/** @return The index of a counter column, the cycles column being kCycles */
+	size_t findColumn(const std::string& _name) const;
+
+	static constexpr size_t kCycles = SIZE_MAX;
+
+	/// A ratio column, num / den of the increments over the interval
+	struct Ratio {
+		std::string name;
+		size_t      num;
+		size_t      den;
+	};
+
+	std::ofstream            out;
+	acalsim::Tick            interval;
+	acalsim::Tick            nextTick = 0;  ///< Next interval boundary
+	acalsim::Tick            lastTick = 0;  ///< Tick of the previous sample
+	bool                     started  = false;
+	std::vector<std::string> names;   ///< Name of every counter column
+	std::vector<Probe>       probes;  ///< Reader of every counter column
+	std::vector<uint64_t>    last;    ///< Counter values at the previous sample
+	std::vector<uint64_t>    delta;   ///< Scratch space for the increments of a row
+	std::vector<Ratio>       ratios;
+};
+
+#endif  // SOC_INCLUDE_INTERVALSTATS_HH_
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOC_INCLUDE_KONATATRACE_HH_
+#define SOC_INCLUDE_KONATATRACE_HH_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "ACALSim.hh"
+#include "BinaryTrace.hh"
+
+/**
+ * @brief Records a pipeline trace event if the stage level is compiled in and a pipeline trace is open
+ * @details The argument is a statement calling KonataTrace. It belongs to SOC_TRACE_LEVEL 2 like the
+ *          binary trace events of the stage models.
+ */
+#define SOC_KONATA(...)                                    \
+	do {                                                   \
+		if constexpr (SOC_TRACE_LEVEL >= 2) {              \
+			if (KonataTrace::isEnabled()) { __VA_ARGS__; } \
+		}                                                  \
+	} while (0)
+
+/**
+ * @class KonataTrace
+ * @brief Pipeline occupancy trace in the Kanata log format, opened by the Konata pipeline viewer
+ * @details Every instruction sent to the IF stage gets an id and goes through the stages
+ *          - IF: from the send of the CPU until the IF stage pushes it to prIF2EXE
+ *          - EX: until the EXE stage pushes it to prEXE2WB
+ *          - WB: until the WB stage retires it
+ *
+ *          Stalls are drawn on lane 1 of the instruction: "Bp" while the IF stage applies backpressure
+ *          to the CPU, "DH" and "CH" while the IF stage holds it on a data or control hazard.
+ *          Instructions still in the pipeline when the trace is closed are recorded as flushed.
+ *
+ *          The stage models may step on several worker threads, so every unit of every core records
+ *          its events into a buffer of its own, without a lock. SOCTop merges the buffers in the
+ *          serial phase of the tick with flush(), in tick order and then in hart and unit order, and
+ *          only then assigns the ids of the file and the retire order. The trace is therefore the same
+ *          whichever thread steps first. The text is written to the file whenever it reaches 1 MiB.
+ */
+class KonataTrace {
+public:
+	/// Recording units of a core, also the order in which their events of a tick are merged
+	enum Unit : uint32_t { CPU, IF, EXE, WB, NUM_UNITS };
+
+	/**
+	 * @brief Opens the trace file, starting at the current global tick
+	 * @param _path Path of the trace file
+	 * @param _numHarts Number of cores recording events
+	 */
+	static void open(const std::string& _path, uint32_t _numHarts);
+
+	/**
+	 * @brief Merges the events recorded since the last call into the trace
+	 * @details Must be called while no thread records, e.g. in the serial phase of every tick.
+	 */
+	static void flush();
+
+	/**
+	 * @brief Flushes the instructions still in flight, writes the buffer and closes the file
+	 * @details Must be called while no thread records, e.g. in the cleanup of the simulation.
+	 */
+	static void close();
+
+	/** @return Whether a pipeline trace is open */
+	static bool isEnabled() { return enabled.load(std::memory_order_acquire); }
+
+	/**
+	 * @brief Starts an instruction in the IF stage, recorded by the CPU unit
+	 * @param _tick Tick the CPU sends the instruction
+	 * @param _hartId Core executing the instruction
+	 * @param _pc PC of the instruction
+	 * @param _op Mnemonic of the instruction
+	 * @return Handle of the instruction for the other events; its id in the file is assigned by flush()
+	 */
+	static uint64_t fetch(acalsim::Tick _tick, uint32_t _hartId, uint32_t _pc, const std::string& _op);
+
+	/**
+	 * @brief Moves an instruction from stage `_from` to stage `_to`
+	 * @param _unit Unit recording the event
+	 */
+	static void advance(Unit _unit, acalsim::Tick _tick, uint64_t _id, const char* _from, const char* _to);
+
+	/**
+	 * @brief Starts a stall of an instruction, drawn on lane 1
+	 * @param _cause Short name of the stall shown by the viewer
+	 */
+	static void stall(Unit _unit, acalsim::Tick _tick, uint64_t _id, const char* _cause);
+
+	/**
+	 * @brief Ends a stall started by stall() with the same cause
+	 */
+	static void resume(Unit _unit, acalsim::Tick _tick, uint64_t _id, const char* _cause);
+
+	/**
+	 * @brief Ends the last stage of an instruction and retires it
+	 */
+	static void retire(Unit _unit, acalsim::Tick _tick, uint64_t _id, const char* _last);
+
+private:
+	static std::atomic<bool> enabled;
+};
+
+#endif  // SOC_INCLUDE_KONATATRACE_HH_
@@ -0,0 +1,256 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOC_INCLUDE_MMIODEVICE_HH_
+#define SOC_INCLUDE_MMIODEVICE_HH_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "ACALSim.hh"
+#include "BaseMemory.hh"
+#include "Bus.hh"
+#include "CommandScoreboard.hh"
+#include "DataStruct.hh"
+#include "MemPacket.hh"
+#include "Scratchpad.hh"
+
+/**
+ * @class MMIODevice
+ * @brief Base class of the memory-mapped devices of the SOC
+ * @details A device owns the address range [base, base + size) and exposes 32-bit registers in it.
+ *          Byte and half-word accesses are served by the base class on top of the word-level
+ *          readReg()/writeReg() interface that every device implements.
+ *
+ *          Devices also report when their software-visible state may change next, which lets the
+ *          CPU fast-forward polling loops on status registers. Devices that access memory on their own
+ *          (DMA, accelerators) reach it through the memories mapped with mapMemory().
+ *
+ *          Each device answers a command with one of the timing models of TimingModel. The analytical
+ *          model computes the latency of a whole command in closed form and completes it with a single
+ *          event, which makes broad design-space sweeps cheap. The validation mode keeps the cycle
+ *          model in charge and reports how far the analytical estimate is from it.
+ */
+class MMIODevice : public acalsim::SimModule {
+public:
+	enum class TimingModel {
+		CYCLE,       ///< Event-driven model of every burst or tile
+		ANALYTICAL,  ///< Closed-form latency per command
+		VALIDATE     ///< Cycle model, cross-checked against the analytical model
+	};
+
+	/**
+	 * @brief Constructor for MMIODevice
+	 * @param _name Name identifier for the device
+	 * @param _baseAddr First address of the register window
+	 * @param _size Size of the register window in bytes
+	 */
+	MMIODevice(std::string _name, uint32_t _baseAddr, uint32_t _size)
+	    : acalsim::SimModule(_name), baseAddr(_baseAddr), size(_size) {}
+
+	/**
+	 * @brief Virtual destructor
+	 */
+	virtual ~MMIODevice() {}
+
+	/** @return The first address of the register window */
+	uint32_t getBaseAddr() const { return this->baseAddr; }
+	/** @return The size of the register window in bytes */
+	uint32_t getSize() const { return this->size; }
+	/** @return Whether the address falls into the register window */
+	bool contains(uint32_t _addr) const { return _addr >= this->baseAddr && _addr - this->baseAddr < this->size; }
+	/** @return The timing model answering the commands of the device */
+	TimingModel getTimingModel() const { return this->timingModel; }
+
+	/**
+	 * @brief Handles register read requests
+	 * @param _when Simulation tick when the request arrives
+	 * @param _memReqPkt Pointer to the memory read request packet
+	 */
+	void memReadReqHandler(acalsim::Tick _when, MemReadReqPacket* _memReqPkt);
+
+	/**
+	 * @brief Handles register write requests
+	 * @param _when Simulation tick when the request arrives
+	 * @param _memReqPkt Pointer to the memory write request packet
+	 */
+	void memWriteReqHandler(acalsim::Tick _when, MemWriteReqPacket* _memReqPkt);
+
+	/**
+	 * @brief Returns when a register read may observe a different value next
+	 * @param _when Current simulation tick
+	 * @return A lower bound of the first tick at which a register read can return a value different
+	 *         from a read at _when, or 0 when no internal event is pending (the registers only
+	 *         change on writes)
+	 */
+	virtual acalsim::Tick getNextStatusChangeTick(acalsim::Tick _when) const = 0;
+
+	/**
+	 * @brief Connects the interrupt line of the device
+	 * @param _handler Invoked with the device whenever it raises an interrupt
+	 */
+	void setInterruptHandler(std::function<void(MMIODevice*)> _handler) { this->irqHandler = _handler; }
+
+	/**
+	 * @brief Connects the scoreboard that orders the commands of the accelerator subsystem
+	 * @param _scoreboard Shared scoreboard; must be connected before software starts a command
+	 */
+	void setScoreboard(CommandScoreboard* _scoreboard) { this->scoreboard = _scoreboard; }
+
+	/**
+	 * @brief Starts the queued commands whose memory hazards have resolved
+	 * @param _when Current simulation tick
+	 * @details Called by the scoreboard whenever a command of any device completes. Devices without
+	 *          a command queue ignore it.
+	 */
+	virtual void issueCommands(acalsim::Tick _when) {}
+
+	/**
+	 * @brief Makes a memory reachable by the device
+	 * @param _baseAddr Address of the first byte of the memory
+	 * @param _mem The memory backing the address range [_baseAddr, _baseAddr + size)
+	 */
+	void mapMemory(uint32_t _baseAddr, BaseMemory* _mem) { this->regions.push_back(MemoryRegion{_baseAddr, _mem}); }
+
+	/**
+	 * @brief Connects the device to a port of the banked scratchpad
+	 * @param _spm The scratchpad; it must also be mapped with mapMemory() for functional accesses
+	 * @param _port Scratchpad port used by the device
+	 */
+	void setScratchpad(Scratchpad* _spm, uint32_t _port) {
+		this->spm     = _spm;
+		this->spmPort = _port;
+	}
+
+	/**
+	 * @brief Connects the device to the system bus as a master
+	 * @param _bus The system bus
+	 * @param _master Master ID of the device on the bus
+	 */
+	void setBus(Bus* _bus, uint32_t _master) {
+		this->bus       = _bus;
+		this->busMaster = _master;
+	}
+
+	/**
+	 * @brief Sends again the bus requests refused on the outstanding limit of the device
+	 * @param _when Current simulation tick
+	 * @details Called through SOC::masterPortRetry(). Devices that are not bus masters ignore it.
+	 */
+	virtual void retryBusRequests(acalsim::Tick _when) {}
+
+	/** @return Whether the device is in the middle of a command that moves data over the system bus */
+	virtual bool isBusActive() const { return false; }
+
+protected:
+	/**
+	 * @brief Selects the timing model of the device
+	 * @param _model "cycle", "analytical" or "validate"
+	 */
+	void setTimingModel(const std::string& _model);
+
+	/**
+	 * @brief Records the latency of a command under both timing models (validation mode)
+	 * @param _analytical Latency predicted by the analytical model
+	 * @param _cycle Latency measured by the cycle model
+	 */
+	void recordValidation(acalsim::Tick _analytical, acalsim::Tick _cycle);
+
+	/**
+	 * @brief Prints the error of the analytical model observed in validation mode
+	 */
+	void printValidationStats() const;
+
+	/**
+	 * @brief Translates a range of device-visible addresses into a host pointer
+	 * @param _addr First address of the range
+	 * @param _bytes Size of the range in bytes
+	 * @return Pointer to the first byte; the range must lie in a single mapped memory
+	 */
+	uint8_t* translate(uint32_t _addr, uint32_t _bytes) const;
+
+	/**
+	 * @brief Times an access through the scratchpad port of the device
+	 * @param _when Simulation tick at which the access is issued
+	 * @param _addr First address of the access
+	 * @param _bytes Size of the access in bytes
+	 * @param _isWrite True for a write access
+	 * @return The tick at which the access completes, or 0 if the address is not in the scratchpad
+	 */
+	acalsim::Tick accessScratchpad(acalsim::Tick _when, uint32_t _addr, uint32_t _bytes, bool _isWrite) {
+		if (!this->spm || !this->spm->contains(_addr)) return 0;
+		return this->spm->access(_when, this->spmPort, _addr, _bytes, _isWrite);
+	}
+
+	/** @return The system bus if the device is a bus master, nullptr otherwise */
+	Bus* getBus() const { return this->bus; }
+	/** @return The master ID of the device on the system bus */
+	uint32_t getBusMaster() const { return this->busMaster; }
+
+	/** @return The scoreboard of the accelerator subsystem */
+	CommandScoreboard* getScoreboard() const { return this->scoreboard; }
+
+	/**
+	 * @brief Raises the interrupt line of the device
+	 */
+	void raiseInterrupt() {
+		if (this->irqHandler) this->irqHandler(this);
+	}
+
+	/**
+	 * @brief Reads a 32-bit register
+	 * @param _when Simulation tick of the access
+	 * @param _offset Word-aligned offset of the register
+	 * @note Reads must not have side effects, they are also used to merge sub-word writes.
+	 */
+	virtual uint32_t readReg(acalsim::Tick _when, uint32_t _offset) = 0;
+
+	/**
+	 * @brief Writes a 32-bit register
+	 * @param _when Simulation tick of the access
+	 * @param _offset Word-aligned offset of the register
+	 * @param _data New register value
+	 */
+	virtual void writeReg(acalsim::Tick _when, uint32_t _offset, uint32_t _data) = 0;
+
+private:
+	struct MemoryRegion {
+		uint32_t    baseAddr;
+		BaseMemory* mem;
+	};
+
+	uint32_t                         baseAddr;
+	uint32_t                         size;
+	std::function<void(MMIODevice*)> irqHandler;  ///< Interrupt line, unconnected by default
+	std::vector<MemoryRegion>        regions;     ///< Memories reachable by the device
+	CommandScoreboard*               scoreboard  = nullptr;
+	Scratchpad*                      spm         = nullptr;  ///< Banked internal buffer, if connected
+	uint32_t                         spmPort     = 0;
+	Bus*                             bus         = nullptr;  ///< System bus, if the device is a bus master
+	uint32_t                         busMaster   = 0;
+	TimingModel                      timingModel = TimingModel::CYCLE;
+
+	// Validation statistics
+	uint64_t      validatedCmds  = 0;
+	acalsim::Tick analyticalSum  = 0;
+	acalsim::Tick cycleSum       = 0;
+	double        absErrorSum    = 0.0;  ///< Sum of the relative errors of the commands
+	double        maxAbsError    = 0.0;  ///< Largest relative error of a command
+	acalsim::Tick maxErrorCycles = 0;    ///< Cycle-model latency of the command with the largest error
+};
+
+#endif  // SOC_INCLUDE_MMIODEVICE_HH_
@@ -22,7 +22,9 @@
 
 #include "ACALSim.hh"
 #include "DataStruct.hh"
+#include "PacketTarget.hh"
 
+class CPU;
 // Forward declaration for MemReadRespPacket
 class MemReadRespPacket;
 // Forward declaration for MemWriteRespPacket
@@ -31,7 +33,9 @@ class MemWriteRespPacket;
 /**
  * @class MemReadReqPacket
  * @brief Memory read request packet class for memory operations
- * @details Handles memory read requests with instruction information and callback handling
+ * @details Handles memory read requests with instruction information and callback handling. RV32A atomic
+ *          memory operations travel as read requests too: they return a value and carry the source
+ *          operand and the hart ID of the requesting core.
  */
 class MemReadReqPacket : public acalsim::SimPacket {
 public:
@@ -68,6 +72,10 @@ public:
 	void visit(acalsim::Tick _when, acalsim::SimModule& _module) override;
 	/** @brief Visit function for simulator interaction */
 	void visit(acalsim::Tick _when, acalsim::SimBase& _simulator) override;
+	/** @brief Hands the request to its receiver with a direct call, one overload per SOC_MEMORY_TARGETS entry */
+#define SOC_DECLARE_VISIT(_type) void visit(acalsim::Tick _when, _type& _target);
+	SOC_MEMORY_TARGETS(SOC_DECLARE_VISIT)
+#undef SOC_DECLARE_VISIT
 
 	/** @return The instruction associated with this request */
 	const instr& getInstr() { return this->i; }
@@ -79,13 +87,38 @@ public:
 	const operand getA1() { return this->a1; }
 	/** @return The callback function */
 	auto getCallback() { return this->callback; }
+	/** @return The PC of the requesting instruction */
+	uint32_t getPC() const { return this->pc; }
+	/** @brief Sets the PC of the requesting instruction */
+	void setPC(uint32_t _pc) { this->pc = _pc; }
+	/** @return The source operand (rs2) of an atomic memory operation */
+	uint32_t getData() const { return this->data; }
+	/** @return The hart ID of the requesting core */
+	uint32_t getHartId() const { return this->hartId; }
+	/**
+	 * @brief Sets the operands of an atomic memory operation
+	 * @param _data Source operand (rs2)
+	 * @param _hartId Hart ID of the requesting core, which owns the LR reservation
+	 */
+	void setAtomic(uint32_t _data, uint32_t _hartId) {
+		this->data   = _data;
+		this->hartId = _hartId;
+	}
+	/** @return The number of bytes the request transfers from memory */
+	uint32_t getBytes() const { return this->bytes; }
+	/** @brief Sets the number of bytes the request transfers, e.g. a whole line for a cache line fill */
+	void setBytes(uint32_t _bytes) { this->bytes = _bytes; }
 
 private:
-	instr                                   i;         ///< Associated instruction
-	instr_type                              op;        ///< Operation type
-	uint32_t                                addr;      ///< Memory address
-	operand                                 a1;        ///< Operand
-	std::function<void(MemReadRespPacket*)> callback;  ///< Response callback function
+	instr                                   i;           ///< Associated instruction
+	instr_type                              op;          ///< Operation type
+	uint32_t                                addr;        ///< Memory address
+	operand                                 a1;          ///< Operand
+	uint32_t                                pc     = 0;  ///< PC of the requesting instruction
+	uint32_t                                data   = 0;  ///< Source operand of an atomic memory operation
+	uint32_t                                hartId = 0;  ///< Hart ID of the requesting core
+	uint32_t                                bytes  = 4;  ///< Bytes transferred from memory
+	std::function<void(MemReadRespPacket*)> callback;    ///< Response callback function
 };
 
 /**
@@ -128,6 +161,10 @@ public:
 	void visit(acalsim::Tick _when, acalsim::SimModule& _module) override;
 	/** @brief Visit function for simulator interaction */
 	void visit(acalsim::Tick _when, acalsim::SimBase& _simulator) override;
+	/** @brief Hands the request to its receiver with a direct call, one overload per SOC_MEMORY_TARGETS entry */
+#define SOC_DECLARE_VISIT(_type) void visit(acalsim::Tick _when, _type& _target);
+	SOC_MEMORY_TARGETS(SOC_DECLARE_VISIT)
+#undef SOC_DECLARE_VISIT
 
 	/** @return The instruction associated with this request */
 	const instr& getInstr() { return this->i; }
@@ -139,12 +176,17 @@ public:
 	const uint32_t& getData() { return this->data; }
 	/** @return The callback function */
 	auto getCallback() { return this->callback; }
+	/** @return The PC of the requesting instruction */
+	uint32_t getPC() const { return this->pc; }
+	/** @brief Sets the PC of the requesting instruction */
+	void setPC(uint32_t _pc) { this->pc = _pc; }
 
 private:
 	instr                                    i;         ///< Associated instruction
 	instr_type                               op;        ///< Operation type
 	uint32_t                                 addr;      ///< Memory address
 	uint32_t                                 data;      ///< Data to write
+	uint32_t                                 pc = 0;    ///< PC of the requesting instruction
 	std::function<void(MemWriteRespPacket*)> callback;  ///< Write completion callback
 };
 
@@ -193,6 +235,8 @@ public:
 	void visit(acalsim::Tick _when, acalsim::SimModule& _module) override;
 	/** @brief Visit function for simulator interaction */
 	void visit(acalsim::Tick _when, acalsim::SimBase& _simulator) override;
+	/** @brief Hands the response to the core that issued the request */
+	void visit(acalsim::Tick _when, CPU& _cpu);
 
 private:
 	instr      i;     ///< Associated instruction
@@ -233,9 +277,22 @@ public:
 	void visit(acalsim::Tick _when, acalsim::SimModule& _module) override;
 	/** @brief Visit function for simulator interaction */
 	void visit(acalsim::Tick _when, acalsim::SimBase& _simulator) override;
+	/** @brief Hands the response to the core that issued the request */
+	void visit(acalsim::Tick _when, CPU& _cpu);
 
 private:
 	instr i;  ///< Associated instruction
 };
 
+/**
+ * @brief Delivers a memory request to a module that is only known by its tag
+ * @param _when Simulation tick of the delivery
+ * @param _pkt A MemWriteReqPacket if `_isWrite`, a MemReadReqPacket otherwise
+ * @param _isWrite Type of the request
+ * @param _kind Type tag of the receiver
+ * @param _module The receiver
+ */
+void visitMemoryTarget(acalsim::Tick _when, acalsim::SimPacket& _pkt, bool _isWrite, MemoryTarget _kind,
+                       acalsim::SimModule& _module);
+
 #endif
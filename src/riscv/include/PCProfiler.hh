@@ -0,0 +1,117 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOC_INCLUDE_PCPROFILER_HH_
+#define SOC_INCLUDE_PCPROFILER_HH_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ACALSim.hh"
+#include "DataStruct.hh"
+
+/**
+ * @class PCProfiler
+ * @brief Execution count, cycles and stall cycles of every instruction of a core
+ * @details The counters are flat arrays indexed by pc / 4. An instruction is charged the cycles from
+ *          its issue until the next instruction issues, so a blocking memory access or a backpressured
+ *          send stalls the instruction that caused it. When the next instruction itself waits, on a
+ *          load it depends on or on the bus, the CPU calls hold() and the wait is charged to that
+ *          instruction instead, which shows the dependence that costs the cycles. Every cycle charged
+ *          beyond the first one of an execution is a stall cycle.
+ */
+class PCProfiler {
+public:
+	/**
+	 * @param _numInstrs Size of the instruction memory in instructions
+	 */
+	explicit PCProfiler(size_t _numInstrs)
+	    : execCnt(_numInstrs, 0), cycles(_numInstrs, 0), stalls(_numInstrs, 0) {}
+
+	/**
+	 * @brief Counts an instruction and charges the cycles since the previous one
+	 * @param _pc PC of the instruction
+	 * @param _tick Tick the instruction executes
+	 */
+	void issue(uint32_t _pc, acalsim::Tick _tick) {
+		size_t idx = _pc / 4;
+		if (this->last != kNone) {
+			acalsim::Tick gap = _tick - this->lastTick;
+			if (this->held && gap > 1) {
+				this->cycles[this->last]++;
+				this->cycles[idx] += gap - 1;
+				this->stalls[idx] += gap - 1;
+			} else {
+				this->cycles[this->last] += gap;
+				this->stalls[this->last] += gap - 1;
+			}
+		}
+		this->execCnt[idx]++;
+		this->last     = idx;
+		this->lastTick = _tick;
+		this->held     = false;
+	}
+
+	/**
+	 * @brief Marks that the next instruction waits for its operands or for the bus before it issues
+	 */
+	void hold() { this->held = true; }
+
+	/**
+	 * @brief Leaves the cycles of fast-forwarded idle loop iterations out of the profile
+	 * @param _cycles Cycles skipped by the CPU
+	 */
+	void skip(acalsim::Tick _cycles) {
+		this->lastTick += _cycles;
+		this->skipped += _cycles;
+	}
+
+	/**
+	 * @brief Charges the last instruction up to the end of the simulation
+	 * @param _tick Tick after the last instruction of the core
+	 */
+	void finish(acalsim::Tick _tick);
+
+	/**
+	 * @brief Adds the counters of another core running the same program
+	 */
+	void merge(const PCProfiler& _other);
+
+	/**
+	 * @brief Writes the top-N report and the annotated source listing of the program
+	 * @param _path Output file
+	 * @param _asmPath Assembly source the instructions were parsed from
+	 * @param _imem Instruction memory, mapping every PC to its source line
+	 * @param _topN Number of instructions in the report
+	 */
+	void writeReport(const std::string& _path, const std::string& _asmPath, const instr* _imem,
+	                 uint32_t _topN) const;
+
+private:
+	static constexpr size_t kNone = SIZE_MAX;
+
+	std::vector<uint64_t> execCnt;  ///< Executions of every instruction
+	std::vector<uint64_t> cycles;   ///< Cycles charged to every instruction
+	std::vector<uint64_t> stalls;   ///< Part of `cycles` beyond one cycle per execution
+
+	size_t        last     = kNone;  ///< Index of the last instruction issued
+	acalsim::Tick lastTick = 0;      ///< Tick the last instruction issued
+	bool          held     = false;  ///< The next instruction waits on its own dependence
+	acalsim::Tick skipped  = 0;      ///< Cycles of the fast-forwarded idle loops
+};
+
+#endif  // SOC_INCLUDE_PCPROFILER_HH_
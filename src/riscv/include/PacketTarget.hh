@@ -0,0 +1,72 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOC_INCLUDE_PACKETTARGET_HH_
+#define SOC_INCLUDE_PACKETTARGET_HH_
+
+#include <cstdint>
+
+/**
+ * @file PacketTarget.hh
+ * @brief Lists of the simulators and modules that receive packets
+ * @details Every receiver gets a typed visit() overload in the packets it accepts, generated from
+ *          these lists, so the sender hands a packet over with a direct call instead of trying one
+ *          dynamic_cast per receiver type. A sender that only holds an acalsim::SimModule, like the
+ *          bus, keeps the MemoryTarget tag of the module next to it. A new receiver is added to its
+ *          list and given the handler the packets call.
+ */
+
+/// Pipeline stage simulators receiving InstPacket through instPacketHandler()
+#define SOC_STAGE_TARGETS(X) \
+	X(IFStage)               \
+	X(EXEStage)              \
+	X(WBStage)
+
+/// Modules receiving memory requests through memReadReqHandler() and memWriteReqHandler()
+#define SOC_MEMORY_TARGETS(X) \
+	X(DataMemory)             \
+	X(DataCache)              \
+	X(MMIODevice)
+
+#define SOC_DECLARE_TARGET(_type) class _type;
+SOC_STAGE_TARGETS(SOC_DECLARE_TARGET)
+SOC_MEMORY_TARGETS(SOC_DECLARE_TARGET)
+#undef SOC_DECLARE_TARGET
+
+/**
+ * @brief Type tag of a module receiving memory requests
+ */
+enum class MemoryTarget : uint8_t {
+#define SOC_TARGET_TAG(_type) _type,
+	SOC_MEMORY_TARGETS(SOC_TARGET_TAG)
+#undef SOC_TARGET_TAG
+};
+
+/**
+ * @brief Maps a receiver type to its MemoryTarget tag at compile time
+ */
+template <typename T>
+struct MemoryTargetOf;
+
+#define SOC_TARGET_TRAIT(_type)                                    \
+	template <>                                                    \
+	struct MemoryTargetOf<_type> {                                 \
+		static constexpr MemoryTarget value = MemoryTarget::_type; \
+	};
+SOC_MEMORY_TARGETS(SOC_TARGET_TRAIT)
+#undef SOC_TARGET_TRAIT
+
+#endif  // SOC_INCLUDE_PACKETTARGET_HH_
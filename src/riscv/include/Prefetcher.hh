@@ -0,0 +1,164 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOC_INCLUDE_PREFETCHER_HH_
+#define SOC_INCLUDE_PREFETCHER_HH_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ACALSim.hh"
+
+/**
+ * @class Prefetcher
+ * @brief Base class of the hardware prefetchers attached to DataCache
+ * @details A prefetcher observes every demand access of the cache and proposes line addresses to
+ *          fetch. The cache filters the candidates (already cached, already in flight, no free MSHR)
+ *          and keeps the coverage, accuracy and timeliness statistics.
+ *
+ *          Every prefetcher is parameterized by a degree (number of lines proposed per trigger) and
+ *          a distance (how many lines or strides ahead of the current access the first one is).
+ */
+class Prefetcher {
+public:
+	/**
+	 * @brief Constructor
+	 * @param _lineSize Cache line size in bytes
+	 * @param _degree Number of prefetches proposed per trigger
+	 * @param _distance Lookahead of the first prefetch in lines or strides
+	 */
+	Prefetcher(uint32_t _lineSize, uint32_t _degree, uint32_t _distance)
+	    : lineSize(_lineSize), degree(_degree), distance(_distance) {}
+
+	/**
+	 * @brief Virtual destructor
+	 */
+	virtual ~Prefetcher() = default;
+
+	/**
+	 * @brief Creates a prefetcher by name
+	 * @param _type "none", "next_line", "stride" or "stream"
+	 * @param _lineSize Cache line size in bytes
+	 * @param _degree Number of prefetches proposed per trigger
+	 * @param _distance Lookahead of the first prefetch
+	 * @param _tableSize Entries of the stride table or number of stream buffers
+	 * @return The prefetcher, or nullptr for "none"
+	 */
+	static std::unique_ptr<Prefetcher> create(const std::string& _type, uint32_t _lineSize, uint32_t _degree,
+	                                          uint32_t _distance, uint32_t _tableSize);
+
+	/**
+	 * @brief Observes a demand access
+	 * @param _pc PC of the memory instruction
+	 * @param _addr Byte address of the access
+	 * @param _trigger True on a miss or on the first hit to a prefetched line
+	 * @param _candidates Receives the line addresses to prefetch; lines past either end of the 32-bit
+	 *                    address space are dropped instead of wrapping around
+	 */
+	virtual void notify(uint32_t _pc, uint32_t _addr, bool _trigger, std::vector<uint32_t>& _candidates) = 0;
+
+	/**
+	 * @return The name of the prefetcher used in the statistics report
+	 */
+	virtual std::string getName() const = 0;
+
+protected:
+	/// Size of the 32-bit address space, the first address a candidate must stay below
+	static constexpr uint64_t kAddressSpace = (uint64_t)1 << 32;
+
+	uint32_t getLineAddr(uint32_t _addr) const { return _addr / this->lineSize * this->lineSize; }
+
+	uint32_t lineSize;
+	uint32_t degree;
+	uint32_t distance;
+};
+
+/**
+ * @class NextLinePrefetcher
+ * @brief Tagged next-line prefetcher
+ * @details On a miss or on the first use of a prefetched line, fetches the lines
+ *          [distance, distance + degree) after the accessed one.
+ */
+class NextLinePrefetcher : public Prefetcher {
+public:
+	using Prefetcher::Prefetcher;
+
+	void        notify(uint32_t _pc, uint32_t _addr, bool _trigger, std::vector<uint32_t>& _candidates) override;
+	std::string getName() const override { return "next-line"; }
+};
+
+/**
+ * @class StridePrefetcher
+ * @brief PC-indexed stride prefetcher backed by a direct-mapped reference prediction table
+ * @details Each entry tracks the last address and stride of one load/store PC with a 2-bit
+ *          confidence counter. Once the stride has repeated, the addresses
+ *          addr + stride * [distance, distance + degree) are prefetched on every access.
+ */
+class StridePrefetcher : public Prefetcher {
+public:
+	StridePrefetcher(uint32_t _lineSize, uint32_t _degree, uint32_t _distance, uint32_t _tableSize)
+	    : Prefetcher(_lineSize, _degree, _distance), table(_tableSize) {
+		ASSERT_MSG(_tableSize > 0, "The stride prefetcher needs at least one table entry (prefetch_table_size).");
+	}
+
+	void        notify(uint32_t _pc, uint32_t _addr, bool _trigger, std::vector<uint32_t>& _candidates) override;
+	std::string getName() const override { return "stride"; }
+
+private:
+	struct Entry {
+		bool     valid      = false;
+		uint32_t pc         = 0;
+		uint32_t lastAddr   = 0;
+		int32_t  stride     = 0;
+		uint32_t confidence = 0;
+	};
+
+	std::vector<Entry> table;
+};
+
+/**
+ * @class StreamPrefetcher
+ * @brief Stream buffer prefetcher tracking several sequential streams
+ * @details A miss that does not belong to a tracked stream allocates a stream buffer (LRU) and
+ *          fetches degree lines starting distance lines ahead. An access that falls into the
+ *          window of a stream advances it and keeps it degree lines ahead of the access. Prefetched
+ *          lines are installed in the cache instead of separate FIFOs.
+ */
+class StreamPrefetcher : public Prefetcher {
+public:
+	StreamPrefetcher(uint32_t _lineSize, uint32_t _degree, uint32_t _distance, uint32_t _numStreams)
+	    : Prefetcher(_lineSize, _degree, _distance), streams(_numStreams) {
+		ASSERT_MSG(_numStreams > 0, "The stream prefetcher needs at least one stream buffer (prefetch_table_size).");
+	}
+
+	void        notify(uint32_t _pc, uint32_t _addr, bool _trigger, std::vector<uint32_t>& _candidates) override;
+	std::string getName() const override { return "stream"; }
+
+private:
+	struct Stream {
+		bool     valid    = false;
+		uint64_t head     = 0;  ///< First line of the stream window, 64 bits to run past the address space
+		uint64_t nextLine = 0;  ///< Next line to prefetch
+		uint64_t lastUse  = 0;
+	};
+
+	std::vector<Stream> streams;
+	uint64_t            useCnt = 0;
+};
+
+#endif  // SOC_INCLUDE_PREFETCHER_HH_
@@ -25,20 +25,33 @@
 #include <string.h>
 
 #include <memory>
+#include <vector>
 
 #include "ACALSim.hh"
+#include "BaseMemory.hh"
+#include "Bus.hh"
 #include "CPU.hh"
+#include "Coherence.hh"
+#include "CommandScoreboard.hh"
+#include "CycleStack.hh"
+#include "DMA.hh"
+#include "DataCache.hh"
 #include "DataMemory.hh"
 #include "DataStruct.hh"
 #include "Emulator.hh"
+#include "IntervalStats.hh"
+#include "MMIODevice.hh"
+#include "Scratchpad.hh"
+#include "SystolicArray.hh"
 
 /**
  * @class SOC
  * @brief System-on-Chip (SOC) module integrating CPU, memory, and ISA emulator
  * @details Represents the top-level hardware system that combines:
  *          - An ISA behavior emulator
- *          - A single-cycle CPU model
- *          - A data memory subsystem
+ *          - `num_cores` single-cycle CPU cores running the same program, each with its own IF, EXE
+ *            and WB stage simulators
+ *          - A data memory subsystem shared by the cores through the system bus
  *          Inherits from STSimBase to provide simulation functionality
  */
 class SOC : public acalsim::CPPSimBase {
@@ -82,10 +95,85 @@ public:
 
 	void masterPortRetry(const std::string& port_name) override;
 
+	/**
+	 * @brief Names the master port that sends the committed instructions of a core to its IF stage
+	 * @param _hartId Hart ID of the core
+	 */
+	static std::string getIFPortName(uint32_t _hartId) { return "sIF" + std::to_string(_hartId) + "-m"; }
+
+	/** @return The number of CPU cores */
+	uint32_t getNumCores() const { return this->cpus.size(); }
+
+	/**
+	 * @brief Maps a memory-mapped device into the address space of the CPU
+	 * @param _device The device to register as a bus target; its register window must not overlap
+	 *                other targets
+	 */
+	void addDevice(MMIODevice* _device);
+
+	/**
+	 * @brief Looks up the device that owns an address in the bus address map
+	 * @param _addr Memory address to look up
+	 * @return The device mapped at the address, or nullptr for a data memory address
+	 */
+	MMIODevice* findDevice(uint32_t _addr) const;
+
+	/**
+	 * @brief Checks whether other masters may compete with a core for the bus
+	 * @param _cpu The core asking
+	 * @return True if a device is moving data over the bus or another core is still running
+	 */
+	bool hasBusTraffic(const CPU* _cpu) const;
+
+	/**
+	 * @brief Samples the interval statistics, called by SOCTop in the serial phase of every tick
+	 */
+	void sampleIntervalStats() {
+		if (this->intervalStats) this->intervalStats->sample(acalsim::top->getGlobalTick());
+	}
+
+	/**
+	 * @brief Returns the CPI stack the pipeline stages of a core count their stalls in
+	 * @param _hartId Hart ID of the core
+	 * @return nullptr unless SOC.cpi_stack names an output file
+	 */
+	CycleStack* getCycleStack(uint32_t _hartId) {
+		return this->cycleStacks.empty() ? nullptr : &this->cycleStacks[_hartId];
+	}
+
 private:
-	Emulator*   isaEmulator;  ///< ISA behavior model for instruction emulation
-	CPU*        cpu;          ///< Single-cycle CPU hardware model
-	DataMemory* dmem;         ///< Data memory subsystem model
+	/**
+	 * @brief Writes the CPI stack of every core to SOC.cpi_stack, as CSV if the file name ends with .csv
+	 *        and as JSON otherwise
+	 */
+	void dumpCycleStacks();
+
+	/**
+	 * @brief Writes the per-PC profile of all cores to SOC.pc_profile, if set
+	 */
+	void dumpPCProfile();
+
+	/**
+	 * @brief Registers the counters of all modules for the interval statistics, if SOC.stats_interval is set
+	 */
+	void setupIntervalStats();
+
+	Emulator*      isaEmulator;  ///< ISA behavior model for instruction emulation
+	DataMemory*    dmem;         ///< Data memory subsystem model
+	Bus*           bus;          ///< Address-decoding interconnect
+	Coherence*     coherence;    ///< Keeps the data caches of multiple cores coherent
+	Scratchpad*    spm;          ///< Banked internal buffer of the accelerators
+	DMA*           dma;          ///< Optional DMA engine
+	SystolicArray* sa;           ///< Optional systolic array
+
+	std::vector<CPU*>        cpus;          ///< Single-cycle CPU cores indexed by hart ID
+	std::vector<DataCache*>  dcaches;       ///< Optional private L1 data caches indexed by hart ID
+	std::vector<MMIODevice*> devices;       ///< Memory-mapped devices
+	CommandScoreboard        scoreboard;    ///< Orders the commands of the devices
+	uint64_t                 interruptCnt;  ///< Interrupts raised by the devices
+	std::vector<CycleStack>  cycleStacks;   ///< CPI stack of every core, empty when not collected
+
+	IntervalStats* intervalStats = nullptr;  ///< Time series of the counters, nullptr when not collected
 };
 
 #endif  // SOC_INCLUDE_SOC_HH_
@@ -17,12 +17,15 @@
 #define RISCV_INCLUDE_SOCTOP_HH_
 
 #include <string>
+#include <vector>
 
 #include "ACALSim.hh"
 #include "EXEStage.hh"
 #include "Emulator.hh"
 #include "IFStage.hh"
+#include "KonataTrace.hh"
 #include "SOC.hh"
+#include "StageScheduler.hh"
 #include "SystemConfig.hh"
 #include "TopPipeRegisterManager.hh"
 #include "WBStage.hh"
@@ -51,9 +54,15 @@ public:
 
 	/**
 	 * @brief Registers configuration objects for the simulation
-	 * @details Creates and registers two configuration objects:
+	 * @details Creates and registers the following configuration objects:
 	 *          1. EmulatorConfig: Configuration for the CPU emulator
 	 *          2. SOCConfig: Configuration for SOC timing parameters
+	 *          3. DataCacheConfig: Configuration for the L1 data cache
+	 *          4. DRAMConfig: Configuration for the DRAM timing backend
+	 *          5. DMAConfig: Configuration for the DMA engine
+	 *          6. SystolicArrayConfig: Configuration for the systolic array
+	 *          7. ScratchpadConfig: Configuration for the banked internal buffer
+	 *          8. BusConfig: Configuration for the address-decoding bus
 	 * @override Overrides base class method
 	 */
 	void registerConfigs() override {
@@ -61,12 +70,25 @@ public:
 		this->addConfig("Emulator", emuConfig);
 		auto socConfig = new SOCConfig("SOC configuration");
 		this->addConfig("SOC", socConfig);
+		auto dcacheConfig = new DataCacheConfig("Data cache configuration");
+		this->addConfig("DataCache", dcacheConfig);
+		auto dramConfig = new DRAMConfig("DRAM configuration");
+		this->addConfig("DRAM", dramConfig);
+		auto dmaConfig = new DMAConfig("DMA configuration");
+		this->addConfig("DMA", dmaConfig);
+		auto saConfig = new SystolicArrayConfig("Systolic array configuration");
+		this->addConfig("SystolicArray", saConfig);
+		auto spmConfig = new ScratchpadConfig("Scratchpad configuration");
+		this->addConfig("Scratchpad", spmConfig);
+		auto busConfig = new BusConfig("Bus configuration");
+		this->addConfig("Bus", busConfig);
 	}
 
 	/**
 	 * @brief Registers command-line interface arguments
 	 * @details Sets up CLI options for the simulation:
 	 *          - --asm_file_path: Path to the assembly code file
+	 *          - --stage_threads: Host threads stepping the pipeline stage models, SOC.stage_threads
 	 * @override Overrides base class method
 	 */
 	void registerCLIArguments() override {
@@ -75,51 +97,124 @@ public:
 		                                "Emulator",                           // Config section
 		                                "asm_file_path"                       // Parameter name
 		);
+		this->addCLIOption<int>("--stage_threads",                                            // Option name
+		                        "Host threads stepping the pipeline stage models, 0 for none",  // Description
+		                        "SOC",                                                        // Config section
+		                        "stage_threads"                                               // Parameter name
+		);
 	}
 
+	/**
+	 * @brief Creates the SOC and the pipeline stage simulators of every core
+	 * @details Each of the `num_cores` cores gets its own IF, EXE and WB stages. The stages keep
+	 *          their local port names, the SOC master port of a core is SOC::getIFPortName(). With
+	 *          `pipeline_models` off only the SOC is created and the cores retire their instructions
+	 *          themselves, so large core counts do not add three simulators per core to every tick.
+	 *          With `stage_threads` above 0 the stages are stepped by a StageScheduler on that many host
+	 *          threads, which then stands for them towards the framework and the SOC.
+	 */
 	void registerSimulators() override {
-		this->soc  = new SOC("top-level soc");
-		this->sIF  = new IFStage("IF stage model");
-		this->sEXE = new EXEStage("EXE stage model");
-		this->sWB  = new WBStage("WB stage model");
-
+		this->soc = new SOC("top-level soc");
 		this->addSimulator(this->soc);
-		this->addSimulator(this->sIF);
-		this->addSimulator(this->sEXE);
-		this->addSimulator(this->sWB);
-
-		// Create SimPort connection between SOC(functional modeling) and sIF(timing model)
-		// SOC only sends an instruction to the IF stage only when there is no backpressue
-		/* SOC -> sIF */
-		this->soc->addMasterPort("sIF-m");
-		this->sIF->addSlavePort("soc-s", 1);
-		// connect SimPort
-		acalsim::SimPortManager::ConnectPort(this->soc, this->sIF, "sIF-m", "soc-s");
+
+		if (!acalsim::top->getParameter<int>("SOC", "pipeline_models")) return;
+
+		int stageThreads = acalsim::top->getParameter<int>("SOC", "stage_threads");
+		ASSERT_MSG(stageThreads >= 0, "The number of stage threads cannot be negative.");
+		if (stageThreads > 0) {
+			this->stageScheduler = new StageScheduler("pipeline stage scheduler", stageThreads);
+			this->addSimulator(this->stageScheduler);
+		}
+
+		uint32_t numCores = acalsim::top->getParameter<int>("SOC", "num_cores");
+		for (uint32_t hartId = 0; hartId < numCores; hartId++) {
+			std::string id   = std::to_string(hartId);
+			IFStage*    sIF  = new IFStage("IF stage model " + id, hartId);
+			EXEStage*   sEXE = new EXEStage("EXE stage model " + id, hartId);
+			WBStage*    sWB  = new WBStage("WB stage model " + id, hartId);
+
+			// The simulator stepping the stages also receives the instructions of the SOC
+			acalsim::SimBase* receiver  = sIF;
+			std::string       slavePort = "soc-s";
+			if (this->stageScheduler) {
+				receiver  = this->stageScheduler;
+				slavePort = StageScheduler::getSlavePortName(hartId);
+				this->stageScheduler->addLane(sIF, sEXE, sWB);
+			} else {
+				this->addSimulator(sIF);
+				this->addSimulator(sEXE);
+				this->addSimulator(sWB);
+			}
+
+			// Create SimPort connection between SOC(functional modeling) and sIF(timing model)
+			// SOC only sends an instruction to the IF stage only when there is no backpressue
+			/* SOC -> sIF */
+			this->soc->addMasterPort(SOC::getIFPortName(hartId));
+			receiver->addSlavePort(slavePort, 1);
+			// connect SimPort
+			acalsim::SimPortManager::ConnectPort(this->soc, receiver, SOC::getIFPortName(hartId), slavePort);
+
+			sIF->setCycleStack(this->soc->getCycleStack(hartId));
+			sEXE->setCycleStack(this->soc->getCycleStack(hartId));
+
+			this->sIF.push_back(sIF);
+			this->sEXE.push_back(sEXE);
+			this->sWB.push_back(sWB);
+		}
 	}
 
 	void registerPipeRegisters() override {
-		// SimPipeRegister Setup
+		// SimPipeRegister Setup, for every core
 		// IF ->prIF2EXE->EXE->prEXE2WB->WB
 
-		acalsim::SimPipeRegister* prIF2EXE = new acalsim::SimPipeRegister("prIF2EXE");
-		acalsim::SimPipeRegister* prEXE2WB = new acalsim::SimPipeRegister("prEXE2WB");
-
 		this->pipeRegisterManager = new TopPipeRegisterManager("Top-Level Pipe Register Manager");
-		this->pipeRegisterManager->addPipeRegister(prIF2EXE);
-		this->pipeRegisterManager->addPipeRegister(prEXE2WB);
 
-		this->sIF->addPRMasterPort("prIF2EXE-in", prIF2EXE);
-		this->sEXE->addPRSlavePort("prIF2EXE-out", prIF2EXE);
-		this->sEXE->addPRMasterPort("prEXE2WB-in", prEXE2WB);
-		this->sWB->addPRSlavePort("prEXE2WB-out", prEXE2WB);
+		for (size_t hartId = 0; hartId < this->sIF.size(); hartId++) {
+			std::string               id       = std::to_string(hartId);
+			acalsim::SimPipeRegister* prIF2EXE = new acalsim::SimPipeRegister("prIF2EXE-" + id);
+			acalsim::SimPipeRegister* prEXE2WB = new acalsim::SimPipeRegister("prEXE2WB-" + id);
+
+			this->pipeRegisterManager->addPipeRegister(prIF2EXE);
+			this->pipeRegisterManager->addPipeRegister(prEXE2WB);
+
+			this->sIF[hartId]->addPRMasterPort("prIF2EXE-in", prIF2EXE);
+			this->sEXE[hartId]->addPRSlavePort("prIF2EXE-out", prIF2EXE);
+			this->sEXE[hartId]->addPRMasterPort("prEXE2WB-in", prEXE2WB);
+			this->sWB[hartId]->addPRSlavePort("prEXE2WB-out", prEXE2WB);
+
+			this->sIF[hartId]->bindHandles(this->getIFSlavePort(hartId));
+			this->sEXE[hartId]->bindHandles();
+			this->sWB[hartId]->bindHandles();
+		}
+	}
+
+	/**
+	 * @brief Serial phase of every tick, after all simulators have stepped
+	 * @details Recycles the instruction packets the WB stages retired, merges the pipeline trace
+	 *          events of the tick and samples the interval statistics of the SOC. Everything the
+	 *          simulators share is only touched here or through ports and pipe registers, which the
+	 *          framework synchronizes in this phase, so their step() may run concurrently on worker
+	 *          threads, the ones of the framework or those of the StageScheduler.
+	 */
+	void control_thread_step() override {
+		for (auto sWB : this->sWB) { sWB->recycleRetired(); }
+		SOC_KONATA(KonataTrace::flush());
+		this->soc->sampleIntervalStats();
 	}
 
 private:
-	SOC*      soc;
-	Emulator* isaEmulator;
-	IFStage*  sIF;
-	EXEStage* sEXE;
-	WBStage*  sWB;
+	/** @return The port receiving the instructions the SOC sends to a core */
+	acalsim::SlavePort* getIFSlavePort(uint32_t _hartId) const {
+		if (this->stageScheduler) return this->stageScheduler->getSlavePort(StageScheduler::getSlavePortName(_hartId));
+		return this->sIF[_hartId]->getSlavePort("soc-s");
+	}
+
+	SOC*                   soc;
+	Emulator*              isaEmulator;
+	std::vector<IFStage*>  sIF;                       ///< IF stage of every core, indexed by hart ID
+	std::vector<EXEStage*> sEXE;                      ///< EXE stage of every core, indexed by hart ID
+	std::vector<WBStage*>  sWB;                       ///< WB stage of every core, indexed by hart ID
+	StageScheduler*        stageScheduler = nullptr;  ///< Steps the stages, nullptr when the framework does
 };
 
 #endif
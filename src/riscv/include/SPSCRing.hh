@@ -0,0 +1,105 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOC_INCLUDE_SPSCRING_HH_
+#define SOC_INCLUDE_SPSCRING_HH_
+
+#include <atomic>
+#include <cstddef>
+
+#include "ACALSim.hh"
+
+/**
+ * @class SPSCRing
+ * @brief Bounded lock-free ring buffer between one producer thread and one consumer thread
+ * @tparam T Type of the entries, usually a packet pointer
+ * @tparam N Capacity, a power of two
+ * @details Offers the backpressure interface of a SimPort: push() fails when the ring is full,
+ *          isPopValid() tells whether an entry can be popped and pop() removes it. Entries pushed by
+ *          the producer only become visible to the consumer after publish(), so a simulator can fill
+ *          the ring during its step() and pay for a single release store. The head and the tail live
+ *          on separate cache lines and each side keeps a cached copy of the other side's index, so
+ *          push and pop only touch the shared lines when the ring looks full or empty.
+ */
+template <typename T, size_t N>
+class SPSCRing {
+	static_assert(N > 0 && (N & (N - 1)) == 0, "The capacity of an SPSCRing must be a power of two.");
+	static constexpr size_t kCacheLine = 64;
+
+public:
+	/**
+	 * @brief Appends an entry on the producer side; it is visible to the consumer after publish()
+	 * @return Whether there was room for the entry
+	 */
+	bool push(const T& _item) {
+		size_t tail = this->producer.tail;
+		if (tail - this->producer.cachedHead == N) {
+			this->producer.cachedHead = this->head.load(std::memory_order_acquire);
+			if (tail - this->producer.cachedHead == N) return false;
+		}
+		this->slots[tail & (N - 1)] = _item;
+		this->producer.tail         = tail + 1;
+		return true;
+	}
+
+	/**
+	 * @brief Makes every entry pushed so far visible to the consumer
+	 */
+	void publish() { this->tail.store(this->producer.tail, std::memory_order_release); }
+
+	/**
+	 * @brief Checks on the consumer side whether a published entry is waiting
+	 */
+	bool isPopValid() {
+		if (this->consumer.head == this->consumer.cachedTail) {
+			this->consumer.cachedTail = this->tail.load(std::memory_order_acquire);
+		}
+		return this->consumer.head != this->consumer.cachedTail;
+	}
+
+	/**
+	 * @brief Removes the oldest published entry; only valid after isPopValid() returned true
+	 */
+	T pop() {
+		size_t head = this->consumer.head;
+		ASSERT_MSG(head != this->consumer.cachedTail, "pop() on an SPSCRing without a published entry.");
+		T item              = this->slots[head & (N - 1)];
+		this->consumer.head = head + 1;
+		this->head.store(head + 1, std::memory_order_release);
+		return item;
+	}
+
+	/** @return The capacity of the ring */
+	static constexpr size_t capacity() { return N; }
+
+private:
+	struct alignas(kCacheLine) Producer {
+		size_t tail       = 0;  ///< Next slot to write, ahead of `tail` until publish()
+		size_t cachedHead = 0;  ///< Last head read from the consumer
+	};
+	struct alignas(kCacheLine) Consumer {
+		size_t head       = 0;  ///< Next slot to read
+		size_t cachedTail = 0;  ///< Last tail published by the producer
+	};
+
+	Producer                               producer;
+	Consumer                               consumer;
+	alignas(kCacheLine) std::atomic<size_t> head{0};  ///< Entries consumed, written by the consumer
+	alignas(kCacheLine) std::atomic<size_t> tail{0};  ///< Entries published, written by the producer
+	alignas(kCacheLine) T slots[N];
+};
+
+#endif  // SOC_INCLUDE_SPSCRING_HH_
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOC_INCLUDE_SCRATCHPAD_HH_
+#define SOC_INCLUDE_SCRATCHPAD_HH_
+
+#include <string>
+#include <vector>
+
+#include "ACALSim.hh"
+#include "BaseMemory.hh"
+#include "IntervalStats.hh"
+
+/**
+ * @class Scratchpad
+ * @brief Banked SRAM backing the internal buffer of the accelerators
+ * @details The scratchpad is split into `banks` banks that each serve one `bank_width`-byte word per
+ *          cycle. The bank of a word is chosen by the interleaving function:
+ *          - "word":  consecutive words go to consecutive banks (word % banks)
+ *          - "xor":   the row index is XORed into the bank bits ((word ^ word / banks) % banks), which
+ *                     spreads strided accesses whose stride is a multiple of the bank count
+ *          - "block": every bank holds one contiguous block of the address range
+ *
+ *          Devices reach the banks through `ports` ports. A port issues one request at a time; the
+ *          words of a request are issued in parallel across banks and serially within a bank, and
+ *          every word occupies its bank for one cycle. The last word is available `latency` cycles
+ *          after it is issued.
+ *
+ *          Cycles lost to words of the same request sharing a bank are counted as bank conflicts,
+ *          cycles lost to banks busy with other ports as contention stalls.
+ */
+class Scratchpad : public acalsim::SimModule, public BaseMemory {
+public:
+	/**
+	 * @brief Constructor for Scratchpad
+	 * @param _name Name identifier for the scratchpad
+	 * @param _baseAddr Device-visible address of the first byte
+	 * @param _size Size of the scratchpad in bytes
+	 * @details The bank organization is read from the "Scratchpad" configuration.
+	 */
+	Scratchpad(std::string _name, uint32_t _baseAddr, size_t _size);
+
+	/**
+	 * @brief Virtual destructor
+	 */
+	virtual ~Scratchpad() {}
+
+	/** @return Whether the address falls into the scratchpad */
+	bool contains(uint32_t _addr) const { return _addr >= this->baseAddr && _addr - this->baseAddr < this->getSize(); }
+	/** @return The number of ports */
+	uint32_t getPortCount() const { return this->ports.size(); }
+
+	/**
+	 * @brief Reserves the banks for an access and returns when its data is available
+	 * @param _when Simulation tick at which the request is presented to the port
+	 * @param _port Port issuing the request
+	 * @param _addr First address of the access
+	 * @param _bytes Size of the access in bytes
+	 * @param _isWrite True for a write access
+	 * @return The tick at which the last word is read or written
+	 * @note Banks are reserved first come, first served: a request never fills an idle gap left
+	 *       before the reservation of an earlier request.
+	 */
+	acalsim::Tick access(acalsim::Tick _when, uint32_t _port, uint32_t _addr, uint32_t _bytes, bool _isWrite);
+
+	/**
+	 * @brief Prints the bank conflict and utilization statistics
+	 */
+	void printStats() const;
+
+	/**
+	 * @brief Registers the access and bank conflict counters for the interval statistics
+	 * @param _prefix Column name prefix, e.g. "spm."
+	 */
+	void addIntervalStats(IntervalStats& _stats, const std::string& _prefix) const;
+
+protected:
+	enum class Interleave { WORD, XOR, BLOCK };
+
+	/** @brief Returns the bank holding a word of the scratchpad */
+	uint32_t getBank(uint32_t _word) const;
+
+private:
+	struct Port {
+		acalsim::Tick freeTick   = 0;  ///< First cycle at which the port can issue a new request
+		uint64_t      requests   = 0;
+		acalsim::Tick waitCycles = 0;  ///< Cycles requests waited for the port
+	};
+
+	uint32_t      baseAddr;
+	uint32_t      bankWidth;     ///< Bytes served by a bank per cycle
+	uint32_t      wordsPerBank;  ///< Words of a bank, used by the block interleaving
+	Interleave    interleave;
+	acalsim::Tick latency;
+
+	std::vector<acalsim::Tick> bankFree;  ///< First free cycle of each bank
+	std::vector<uint32_t>      bankLoad;  ///< Scratch space counting the words of a request per bank
+	std::vector<Port>          ports;
+
+	// Statistics
+	uint64_t              reads           = 0;
+	uint64_t              writes          = 0;
+	uint64_t              words           = 0;
+	acalsim::Tick         conflictCycles  = 0;  ///< Extra cycles from words of a request sharing a bank
+	acalsim::Tick         contentionStall = 0;  ///< Extra cycles from banks busy with other ports
+	std::vector<uint64_t> bankWords;            ///< Words served by each bank
+};
+
+#endif  // SOC_INCLUDE_SCRATCHPAD_HH_
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOC_INCLUDE_STAGESCHEDULER_HH_
+#define SOC_INCLUDE_STAGESCHEDULER_HH_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ACALSim.hh"
+#include "EXEStage.hh"
+#include "IFStage.hh"
+#include "SPSCRing.hh"
+#include "WBStage.hh"
+
+/**
+ * @class StageScheduler
+ * @brief Steps the IF/EXE/WB stage models of all cores on a pool of host threads
+ * @details Selected with SOC.stage_threads > 0. The stage models are then not registered with the
+ *          framework: the scheduler is the only simulator standing for them, it receives the
+ *          instructions the SOC sends to every core on its own slave ports and steps the stages in its
+ *          step(). The stages of a core form a lane, and core `h` is always stepped by thread
+ *          `h % stage_threads`, thread 0 being the one calling step(). A lane is stepped in every tick
+ *          in which one of its stages has an inbound instruction, and step() returns once all threads
+ *          are done with the tick.
+ *
+ *          The stages of different cores share nothing but the SOC and the trace writers, and they only
+ *          reach the SOC through the port and the pipe registers that are synchronized in the serial
+ *          phase of the tick. Every per-core trace and statistic is therefore written by a single
+ *          thread in program order, and a run gives the same results with any number of threads.
+ *
+ *          Every worker thread is driven through a pair of SPSCRing channels, one carrying the ticks
+ *          from step() to the worker and one carrying the results back. A worker only takes a new tick
+ *          once it answered the previous one, so both rings hold a single entry and a push() that fails
+ *          on a full ring is a broken handshake, which is asserted against.
+ */
+class StageScheduler : public acalsim::CPPSimBase {
+public:
+	/**
+	 * @param _name Simulator name
+	 * @param _numThreads Host threads stepping the lanes, including the caller of step()
+	 */
+	StageScheduler(const std::string& _name, uint32_t _numThreads);
+	~StageScheduler() { this->stopWorkers(); }
+
+	/**
+	 * @brief Initializes the stages and starts the worker threads
+	 */
+	void init() override;
+
+	/**
+	 * @brief Steps every lane with an inbound instruction and waits for all threads
+	 */
+	void step() override;
+
+	/**
+	 * @brief Stops the worker threads and cleans up the stages
+	 */
+	void cleanup() override;
+
+	/**
+	 * @brief Adds the stages of the next core, before the simulation starts
+	 * @details The IF stage takes the instructions of the SOC from getSlavePortName() of this core.
+	 */
+	void addLane(IFStage* _sIF, EXEStage* _sEXE, WBStage* _sWB);
+
+	/** @return The name of the slave port receiving the instructions the SOC sends to a core */
+	static std::string getSlavePortName(uint32_t _hartId) { return "soc-s" + std::to_string(_hartId); }
+
+private:
+	/// Stage models of one core
+	struct Lane {
+		IFStage*  sIF;
+		EXEStage* sEXE;
+		WBStage*  sWB;
+	};
+
+	/// Worker thread and its channels to step()
+	struct Worker {
+		uint32_t          threadId;  ///< Thread ID, selects the lanes
+		SPSCRing<bool, 1> ticks;     ///< true to step the lanes once, false to exit
+		SPSCRing<bool, 1> results;   ///< Whether the lanes have work in the next tick
+		std::thread       thread;    ///< Runs workerLoop()
+	};
+
+	/**
+	 * @brief Steps the lanes of one thread
+	 * @return Whether one of the lanes may have work in the next tick
+	 */
+	static bool stepLanes(const std::vector<Lane>& _lanes);
+
+	/**
+	 * @brief Body of a worker thread, steps its lanes once per tick it receives until stopped
+	 */
+	void workerLoop(Worker* _worker);
+
+	/**
+	 * @brief Stops and joins the worker threads, if they are running
+	 */
+	void stopWorkers();
+
+	uint32_t                             numThreads;  ///< Threads stepping the lanes, including the caller
+	std::vector<std::vector<Lane>>       lanes;       ///< Lanes of every thread, indexed by thread ID
+	std::vector<std::unique_ptr<Worker>> workers;     ///< Threads of the IDs above 0 that have lanes
+};
+
+#endif  // SOC_INCLUDE_STAGESCHEDULER_HH_
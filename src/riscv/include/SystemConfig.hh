@@ -42,6 +42,8 @@ public:
 	 *          - max_label_count: Maximum number of labels supported (default: 128)
 	 *          - max_src_len: Maximum source code length in bytes (default: 1048576)
 	 *          - asm_file_path: Path to the assembly source file (default: empty)
+	 *          - entry_points: Comma-separated labels where the cores start, one per hart ID; cores
+	 *            without an entry start at the first instruction (default: empty)
 	 */
 	EmulatorConfig(const std::string& _name) : acalsim::SimConfig(_name) {
 		this->addParameter<int>("memory_size", 65536, acalsim::ParamType::INT);
@@ -50,6 +52,7 @@ public:
 		this->addParameter<int>("max_label_count", 128, acalsim::ParamType::INT);
 		this->addParameter<int>("max_src_len", 1048576, acalsim::ParamType::INT);
 		this->addParameter<std::string>("asm_file_path", "", acalsim::ParamType::STRING);
+		this->addParameter<std::string>("entry_points", "", acalsim::ParamType::STRING);
 	}
 
 	/**
@@ -72,10 +75,55 @@ public:
 	 * @details Sets up the following parameters:
 	 *          - memory_read_latency: Clock cycles for memory read operations (default: 1)
 	 *          - memory_write_latency: Clock cycles for memory write operations (default: 1)
+	 *          - idle_loop_skip: Fast-forward loops that only poll device status registers (default: 0)
+	 *          - buffer_addr: Base address of the accelerator internal buffer (default: 0x200000)
+	 *          - buffer_size: Size of the accelerator internal buffer in bytes (default: 256 KiB)
+	 *          - num_cores: Number of CPU cores sharing the data memory through the bus (default: 1)
+	 *          - cpu_max_outstanding: Uncached requests a core may have in flight on the bus, which
+	 *            only matters with a data cache since the core blocks without one (default: 4)
+	 *          - atomic_location: Where atomic memory operations are performed with a data cache,
+	 *            "cache" (near the core) or "memory" (at the data memory); always "memory" without
+	 *            a data cache (default: "cache")
+	 *          - pipeline_models: Give every core IF/EXE/WB stage simulators that model its pipeline
+	 *            hazards (default: 1)
+	 *          - quantum: Cycles a core may execute ahead of the global tick over instructions that
+	 *            only touch its own registers; needs pipeline_models = 0 (default: 1, in lockstep)
+	 *          - stage_threads: Host threads stepping the stage simulators of pipeline_models through a
+	 *            StageScheduler, 0 to let the framework step them like any other simulator; results do
+	 *            not depend on the number (default: 0)
+	 *          - binary_trace: File receiving the binary trace of the cores and their pipeline stages,
+	 *            empty to disable it (default: "")
+	 *          - konata_trace: File receiving the pipeline occupancy trace of the stage models in the
+	 *            Kanata format of the Konata viewer, empty to disable it (default: "")
+	 *          - cpi_stack: File receiving the CPI stack of every core at the end of the simulation, CSV
+	 *            if the name ends with .csv and JSON otherwise, empty to disable it (default: "")
+	 *          - pc_profile: File receiving the execution count, cycles and stall cycles of every
+	 *            instruction as a top-N report and an annotated listing of the assembly source,
+	 *            empty to disable it (default: "")
+	 *          - pc_profile_top: Number of instructions in the top-N report (default: 20)
+	 *          - stats_interval: Ticks between two samples of the interval statistics, 0 to disable
+	 *            them (default: 0)
+	 *          - stats_file: CSV file receiving the interval statistics (default: "interval_stats.csv")
 	 */
 	SOCConfig(const std::string& _name) : acalsim::SimConfig(_name) {
 		this->addParameter<acalsim::Tick>("memory_read_latency", 1, acalsim::ParamType::TICK);
 		this->addParameter<acalsim::Tick>("memory_write_latency", 1, acalsim::ParamType::TICK);
+		this->addParameter<int>("idle_loop_skip", 0, acalsim::ParamType::INT);
+		this->addParameter<int>("buffer_addr", 0x200000, acalsim::ParamType::INT);
+		this->addParameter<int>("buffer_size", 0x40000, acalsim::ParamType::INT);
+		this->addParameter<int>("num_cores", 1, acalsim::ParamType::INT);
+		this->addParameter<int>("cpu_max_outstanding", 4, acalsim::ParamType::INT);
+		this->addParameter<std::string>("atomic_location", "cache", acalsim::ParamType::STRING);
+		this->addParameter<int>("pipeline_models", 1, acalsim::ParamType::INT);
+		this->addParameter<int>("quantum", 1, acalsim::ParamType::INT);
+		this->addParameter<int>("stage_threads", 0, acalsim::ParamType::INT);
+		this->addParameter<std::string>("binary_trace", "", acalsim::ParamType::STRING);
+		this->addParameter<std::string>("konata_trace", "", acalsim::ParamType::STRING);
+		this->addParameter<std::string>("cpi_stack", "", acalsim::ParamType::STRING);
+		this->addParameter<std::string>("pc_profile", "", acalsim::ParamType::STRING);
+		this->addParameter<int>("pc_profile_top", 20, acalsim::ParamType::INT);
+		this->addParameter<int>("stats_interval", 0, acalsim::ParamType::INT);
+		this->addParameter<std::string>("stats_file", "interval_stats.csv", acalsim::ParamType::STRING);
 	}
 
 	/**
@@ -84,4 +132,229 @@ public:
 	~SOCConfig() {}
 };
 
+/**
+ * @class DataCacheConfig
+ * @brief Configuration class for the non-blocking L1 data cache
+ * @details Inherits from SimConfig and defines the geometry, hit latency, miss-handling resources
+ *          and coherence protocol of the data caches placed between the cores and DataMemory
+ */
+class DataCacheConfig : public acalsim::SimConfig {
+public:
+	/**
+	 * @brief Constructor that initializes data cache parameters
+	 * @param _name Name identifier for the configuration instance
+	 * @details Sets up the following parameters:
+	 *          - enable: Place the data cache in front of DataMemory (default: 0)
+	 *          - size: Cache capacity in bytes (default: 4096)
+	 *          - line_size: Cache line size in bytes (default: 32)
+	 *          - associativity: Number of ways per set (default: 2)
+	 *          - hit_latency: Clock cycles for a cache hit (default: 1)
+	 *          - mshr_count: Number of miss status holding registers (default: 4)
+	 *          - mshr_targets: Maximum number of requests merged into one MSHR (default: 4)
+	 *          - prefetcher: Hardware prefetcher, "none", "next_line", "stride" or "stream" (default: "none")
+	 *          - prefetch_degree: Number of lines prefetched per trigger (default: 1)
+	 *          - prefetch_distance: Lookahead of the first prefetch in lines or strides (default: 1)
+	 *          - prefetch_table_size: Stride table entries or number of stream buffers (default: 16)
+	 *          - coherence: Protocol among the private caches of multiple cores, "msi" or "mesi" (default: "mesi")
+	 */
+	DataCacheConfig(const std::string& _name) : acalsim::SimConfig(_name) {
+		this->addParameter<int>("enable", 0, acalsim::ParamType::INT);
+		this->addParameter<int>("size", 4096, acalsim::ParamType::INT);
+		this->addParameter<int>("line_size", 32, acalsim::ParamType::INT);
+		this->addParameter<int>("associativity", 2, acalsim::ParamType::INT);
+		this->addParameter<acalsim::Tick>("hit_latency", 1, acalsim::ParamType::TICK);
+		this->addParameter<int>("mshr_count", 4, acalsim::ParamType::INT);
+		this->addParameter<int>("mshr_targets", 4, acalsim::ParamType::INT);
+		this->addParameter<std::string>("prefetcher", "none", acalsim::ParamType::STRING);
+		this->addParameter<int>("prefetch_degree", 1, acalsim::ParamType::INT);
+		this->addParameter<int>("prefetch_distance", 1, acalsim::ParamType::INT);
+		this->addParameter<int>("prefetch_table_size", 16, acalsim::ParamType::INT);
+		this->addParameter<std::string>("coherence", "mesi", acalsim::ParamType::STRING);
+	}
+
+	/**
+	 * @brief Default destructor
+	 */
+	~DataCacheConfig() {}
+};
+
+/**
+ * @class DRAMConfig
+ * @brief Configuration class for the DRAM timing backend of DataMemory
+ * @details Inherits from SimConfig and defines the organization, page policy and
+ *          timing constraints of the DRAM controller model. All timings are in clock cycles.
+ */
+class DRAMConfig : public acalsim::SimConfig {
+public:
+	/**
+	 * @brief Constructor that initializes DRAM parameters
+	 * @param _name Name identifier for the configuration instance
+	 * @details Sets up the following parameters:
+	 *          - enable: Model DRAM timing behind DataMemory (default: 0)
+	 *          - channels: Number of independent channels (default: 1)
+	 *          - banks: Number of banks per channel (default: 8)
+	 *          - row_size: Row buffer size in bytes (default: 2048)
+	 *          - burst_size: Bytes transferred by one burst (default: 64)
+	 *          - page_policy: Row buffer management policy, "open" or "closed" (default: "open")
+	 *          - t_rcd: ACTIVATE to column command delay (default: 14)
+	 *          - t_cas: Column command to data delay (default: 14)
+	 *          - t_rp: PRECHARGE to ACTIVATE delay (default: 14)
+	 *          - t_burst: Data bus cycles of one burst (default: 4)
+	 */
+	DRAMConfig(const std::string& _name) : acalsim::SimConfig(_name) {
+		this->addParameter<int>("enable", 0, acalsim::ParamType::INT);
+		this->addParameter<int>("channels", 1, acalsim::ParamType::INT);
+		this->addParameter<int>("banks", 8, acalsim::ParamType::INT);
+		this->addParameter<int>("row_size", 2048, acalsim::ParamType::INT);
+		this->addParameter<int>("burst_size", 64, acalsim::ParamType::INT);
+		this->addParameter<std::string>("page_policy", "open", acalsim::ParamType::STRING);
+		this->addParameter<acalsim::Tick>("t_rcd", 14, acalsim::ParamType::TICK);
+		this->addParameter<acalsim::Tick>("t_cas", 14, acalsim::ParamType::TICK);
+		this->addParameter<acalsim::Tick>("t_rp", 14, acalsim::ParamType::TICK);
+		this->addParameter<acalsim::Tick>("t_burst", 4, acalsim::ParamType::TICK);
+	}
+
+	/**
+	 * @brief Default destructor
+	 */
+	~DRAMConfig() {}
+};
+
+/**
+ * @class DMAConfig
+ * @brief Configuration class for the memory-mapped DMA engine
+ * @details Inherits from SimConfig and defines the register window and the bus timing of the DMA engine
+ */
+class DMAConfig : public acalsim::SimConfig {
+public:
+	/**
+	 * @brief Constructor that initializes DMA parameters
+	 * @param _name Name identifier for the configuration instance
+	 * @details Sets up the following parameters:
+	 *          - enable: Map the DMA engine into the address space (default: 1)
+	 *          - base_addr: Base address of the register window (default: 0x300000)
+	 *          - bus_width: Bytes transferred per bus beat (default: 8)
+	 *          - max_burst_beats: Maximum number of beats of one burst (default: 16)
+	 *          - burst_latency: Clock cycles from a burst request to its first beat (default: 4)
+	 *          - timing_model: "cycle", "analytical" or "validate" (default: "cycle")
+	 *          - queue_depth: Transfers that may wait behind the running one (default: 8)
+	 *          - max_outstanding: Bus requests the engine may have in flight (default: 2)
+	 */
+	DMAConfig(const std::string& _name) : acalsim::SimConfig(_name) {
+		this->addParameter<int>("enable", 1, acalsim::ParamType::INT);
+		this->addParameter<int>("base_addr", 0x300000, acalsim::ParamType::INT);
+		this->addParameter<int>("bus_width", 8, acalsim::ParamType::INT);
+		this->addParameter<int>("max_burst_beats", 16, acalsim::ParamType::INT);
+		this->addParameter<acalsim::Tick>("burst_latency", 4, acalsim::ParamType::TICK);
+		this->addParameter<std::string>("timing_model", "cycle", acalsim::ParamType::STRING);
+		this->addParameter<int>("queue_depth", 8, acalsim::ParamType::INT);
+		this->addParameter<int>("max_outstanding", 2, acalsim::ParamType::INT);
+	}
+
+	/**
+	 * @brief Default destructor
+	 */
+	~DMAConfig() {}
+};
+
+/**
+ * @class SystolicArrayConfig
+ * @brief Configuration class for the memory-mapped systolic array
+ * @details Inherits from SimConfig and defines the register window, the PE array size and the dataflow
+ */
+class SystolicArrayConfig : public acalsim::SimConfig {
+public:
+	/**
+	 * @brief Constructor that initializes systolic array parameters
+	 * @param _name Name identifier for the configuration instance
+	 * @details Sets up the following parameters:
+	 *          - enable: Map the systolic array into the address space (default: 1)
+	 *          - base_addr: Base address of the register window (default: 0x100000)
+	 *          - array_rows: Number of PE rows (default: 4)
+	 *          - array_cols: Number of PE columns (default: 4)
+	 *          - dataflow: "os" (output stationary) or "ws" (weight stationary) (default: "os")
+	 *          - drain_latency: Clock cycles to drain an output stationary tile from the PEs into the
+	 *            buffer, -1 for the array width (default: -1)
+	 *          - timing_model: "cycle", "analytical" or "validate" (default: "cycle")
+	 *          - queue_depth: Computations that may wait behind the running one (default: 8)
+	 */
+	SystolicArrayConfig(const std::string& _name) : acalsim::SimConfig(_name) {
+		this->addParameter<int>("enable", 1, acalsim::ParamType::INT);
+		this->addParameter<int>("base_addr", 0x100000, acalsim::ParamType::INT);
+		this->addParameter<int>("array_rows", 4, acalsim::ParamType::INT);
+		this->addParameter<int>("array_cols", 4, acalsim::ParamType::INT);
+		this->addParameter<std::string>("dataflow", "os", acalsim::ParamType::STRING);
+		this->addParameter<int>("drain_latency", -1, acalsim::ParamType::INT);
+		this->addParameter<std::string>("timing_model", "cycle", acalsim::ParamType::STRING);
+		this->addParameter<int>("queue_depth", 8, acalsim::ParamType::INT);
+	}
+
+	/**
+	 * @brief Default destructor
+	 */
+	~SystolicArrayConfig() {}
+};
+
+/**
+ * @class ScratchpadConfig
+ * @brief Configuration class for the banked internal buffer of the accelerators
+ * @details Inherits from SimConfig and defines the bank organization of the scratchpad. Its address
+ *          range is set by SOC.buffer_addr and SOC.buffer_size.
+ */
+class ScratchpadConfig : public acalsim::SimConfig {
+public:
+	/**
+	 * @brief Constructor that initializes scratchpad parameters
+	 * @param _name Name identifier for the configuration instance
+	 * @details Sets up the following parameters:
+	 *          - banks: Number of banks (default: 8)
+	 *          - bank_width: Bytes served by a bank per cycle (default: 4)
+	 *          - ports: Number of ports; the DMA engine uses port 0 and the systolic array port 1
+	 *            (default: 2)
+	 *          - interleave: Bank interleaving function, "word", "xor" or "block" (default: "word")
+	 *          - latency: Clock cycles from issuing a word to its data (default: 1)
+	 */
+	ScratchpadConfig(const std::string& _name) : acalsim::SimConfig(_name) {
+		this->addParameter<int>("banks", 8, acalsim::ParamType::INT);
+		this->addParameter<int>("bank_width", 4, acalsim::ParamType::INT);
+		this->addParameter<int>("ports", 2, acalsim::ParamType::INT);
+		this->addParameter<std::string>("interleave", "word", acalsim::ParamType::STRING);
+		this->addParameter<acalsim::Tick>("latency", 1, acalsim::ParamType::TICK);
+	}
+
+	/**
+	 * @brief Default destructor
+	 */
+	~ScratchpadConfig() {}
+};
+
+/**
+ * @class BusConfig
+ * @brief Configuration class for the system bus
+ * @details Inherits from SimConfig and defines the timing and the arbitration of the bus between the
+ *          masters and the data memory and devices
+ */
+class BusConfig : public acalsim::SimConfig {
+public:
+	/**
+	 * @brief Constructor that initializes bus parameters
+	 * @param _name Name identifier for the configuration instance
+	 * @details Sets up the following parameters:
+	 *          - hop_latency: Clock cycles to cross the bus (default: 0)
+	 *          - data_width: Bytes per beat of the read and write channels (default: 8)
+	 *          - arbitration: "round_robin" or "priority" among the masters (cores, data cache, DMA)
+	 *            (default: "round_robin")
+	 */
+	BusConfig(const std::string& _name) : acalsim::SimConfig(_name) {
+		this->addParameter<acalsim::Tick>("hop_latency", 0, acalsim::ParamType::TICK);
+		this->addParameter<int>("data_width", 8, acalsim::ParamType::INT);
+		this->addParameter<std::string>("arbitration", "round_robin", acalsim::ParamType::STRING);
+	}
+
+	/**
+	 * @brief Default destructor
+	 */
+	~BusConfig() {}
+};
+
 #endif  // SOC_INCLUDE_SYSTEMCONFIG_HH_
@@ -0,0 +1,213 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOC_INCLUDE_SYSTOLICARRAY_HH_
+#define SOC_INCLUDE_SYSTOLICARRAY_HH_
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "ACALSim.hh"
+#include "IntervalStats.hh"
+#include "MMIODevice.hh"
+
+/**
+ * @class SystolicArray
+ * @brief Memory-mapped systolic array computing C = A x B on int32 matrices in the internal buffer
+ * @details Register map (offsets from the base address):
+ *          - 0x00 CTRL:    bit 0 starts the computation, bit 1 enables the completion interrupt
+ *          - 0x04 STATUS:  bit 0 done (cleared by writing 0), bit 1 busy, bit 2 invalid dimensions,
+ *                          bit 3 command queue full
+ *          - 0x08 A_DIMS, 0x0C B_DIMS, 0x10 C_DIMS: [23:12] rows - 1 and [11:0] columns - 1
+ *          - 0x14 A_ADDR, 0x18 B_ADDR, 0x1C C_ADDR: base addresses of the row-major matrices
+ *          - 0x20 STRIDES: row strides in bytes, [23:16] A, [15:8] B and [7:0] C
+ *          - 0x24 DONE_CNT: number of completed commands (read-only)
+ *
+ *          Starting a computation while the array is busy queues it, up to `queue_depth` commands.
+ *          Like the DMA engine, the array captures the registers when a command is queued and runs
+ *          the queue in order as the command scoreboard clears the hazards on A, B and C.
+ *
+ *          Matrices larger than the PE array are tiled automatically. With an R x W array:
+ *          - Output stationary (OS): every R x W tile of C is accumulated in the PEs over the whole
+ *            inner dimension K and drained afterwards. A tile of r x w outputs takes r + w + K - 2
+ *            cycles to compute plus `drain_latency` cycles to drain the PEs into the buffer, W by
+ *            default.
+ *          - Weight stationary (WS): every R x W tile of B is preloaded in k cycles (one row per
+ *            cycle) and all M rows of A stream through it in M + k + w - 2 cycles, accumulating the
+ *            partial sums of C in the buffer.
+ *
+ *          A tile reads its operands through the scratchpad when it starts and writes its results
+ *          once all operands are in, so bank conflicts can stretch a tile beyond the PE timing.
+ *
+ *          Each tile result is computed functionally when the tile completes, using packed operands
+ *          and a MAC kernel whose inner loop is contiguous so that the compiler vectorizes it.
+ *
+ *          The analytical timing model sums the tile latencies above over the tile grid in closed form
+ *          (the README estimate N^2/n^2 * ((2n + N - 2) + n) generalized to partial tiles) and computes
+ *          all tiles when the command completes.
+ */
+class SystolicArray : public MMIODevice {
+public:
+	enum Reg : uint32_t {
+		CTRL     = 0x00,
+		STATUS   = 0x04,
+		A_DIMS   = 0x08,
+		B_DIMS   = 0x0c,
+		C_DIMS   = 0x10,
+		A_ADDR   = 0x14,
+		B_ADDR   = 0x18,
+		C_ADDR   = 0x1c,
+		STRIDES  = 0x20,
+		DONE_CNT = 0x24
+	};
+	enum Ctrl : uint32_t { CTRL_START = 1u << 0, CTRL_IRQ_EN = 1u << 1 };
+	enum Status : uint32_t {
+		STATUS_DONE       = 1u << 0,
+		STATUS_BUSY       = 1u << 1,
+		STATUS_ERROR      = 1u << 2,
+		STATUS_QUEUE_FULL = 1u << 3
+	};
+	enum class Dataflow { WS, OS };
+
+	/**
+	 * @brief Constructor for SystolicArray
+	 * @param _name Name identifier for the systolic array
+	 * @param _baseAddr Base address of the register window
+	 * @details The PE array size and the dataflow are read from the "SystolicArray" configuration.
+	 */
+	SystolicArray(std::string _name, uint32_t _baseAddr);
+
+	/**
+	 * @brief Virtual destructor
+	 */
+	virtual ~SystolicArray() {}
+
+	/**
+	 * @brief Completes the tile in flight and starts the next one
+	 * @param _when Current simulation tick
+	 */
+	void advance(acalsim::Tick _when);
+
+	void          issueCommands(acalsim::Tick _when) override;
+	acalsim::Tick getNextStatusChangeTick(acalsim::Tick _when) const override;
+
+	/**
+	 * @brief Prints the computation statistics of the systolic array
+	 */
+	void printStats() const;
+
+	/**
+	 * @brief Registers the computation counters for the interval statistics
+	 * @param _prefix Column name prefix, e.g. "sa."
+	 */
+	void addIntervalStats(IntervalStats& _stats, const std::string& _prefix) const;
+
+protected:
+	uint32_t readReg(acalsim::Tick _when, uint32_t _offset) override;
+	void     writeReg(acalsim::Tick _when, uint32_t _offset, uint32_t _data) override;
+
+	/**
+	 * @brief One pass of the PE array
+	 * @details OS: rows x cols outputs starting at (row, col) over the whole inner dimension.
+	 *          WS: depth x cols weights starting at (depth, col) applied to all rows of A.
+	 */
+	struct Tile {
+		uint32_t row      = 0;
+		uint32_t col      = 0;
+		uint32_t depth    = 0;
+		uint32_t rows     = 0;
+		uint32_t cols     = 0;
+		uint32_t depthLen = 0;
+	};
+
+	/**
+	 * @brief Registers captured when software starts a computation
+	 */
+	struct Command {
+		uint64_t id      = 0;  ///< Scoreboard ID
+		uint32_t ctrl    = 0;
+		uint32_t aAddr   = 0;
+		uint32_t bAddr   = 0;
+		uint32_t cAddr   = 0;
+		uint32_t strides = 0;
+		uint32_t M       = 0;
+		uint32_t K       = 0;
+		uint32_t N       = 0;
+	};
+
+	void                         submit(acalsim::Tick _when);
+	CommandScoreboard::Footprint getFootprint(const Command& _cmd) const;
+	void                         updateStatus();
+
+	void          start(acalsim::Tick _when);
+	void          finish(acalsim::Tick _when);
+	Tile          makeTile(uint32_t _index) const;
+	uint32_t      getTileCount() const;
+	acalsim::Tick getTileCycles(const Tile& _tile) const;
+	acalsim::Tick estimateCycles() const;  ///< Analytical latency of the running command, O(1)
+	void          computeTile(const Tile& _tile);
+	void          issueTile(acalsim::Tick _when);  ///< Starts the tile at tileIdx
+	void          schedule(acalsim::Tick _when);
+
+private:
+	uint32_t      arrayRows;
+	uint32_t      arrayCols;
+	Dataflow      dataflow;
+	acalsim::Tick drainLatency;  ///< Cycles to move an OS tile from the PEs to the buffer
+	uint32_t      queueDepth;    ///< Commands that may wait behind the running one
+
+	// Registers
+	uint32_t ctrl    = 0;
+	uint32_t status  = 0;
+	uint32_t aDims   = 0;
+	uint32_t bDims   = 0;
+	uint32_t cDims   = 0;
+	uint32_t aAddr   = 0;
+	uint32_t bAddr   = 0;
+	uint32_t cAddr   = 0;
+	uint32_t strides = 0;
+
+	std::deque<Command> queue;            ///< Commands waiting to start
+	Command             cmd;              ///< Running command
+	bool                running = false;  ///< A command is running
+	uint32_t            doneCnt = 0;      ///< Completed commands
+
+	// Current computation
+	uint32_t      M               = 0;  ///< Rows of A and C
+	uint32_t      K               = 0;  ///< Columns of A, rows of B
+	uint32_t      N               = 0;  ///< Columns of B and C
+	uint32_t      tileIdx         = 0;
+	acalsim::Tick startTick       = 0;
+	acalsim::Tick estimate        = 0;  ///< Analytical latency of the command in flight
+	acalsim::Tick endTick         = 0;
+	acalsim::Tick remainingCycles = 0;  ///< PE cycles of the tiles not issued yet
+
+	std::vector<int32_t> aTile;  ///< Packed A operands of a tile
+	std::vector<int32_t> bTile;  ///< Packed B operands of a tile
+	std::vector<int32_t> cTile;  ///< Packed C results of a tile
+
+	// Statistics
+	uint64_t      runs           = 0;
+	uint64_t      tiles          = 0;
+	uint64_t      macs           = 0;
+	uint64_t      interrupts     = 0;
+	acalsim::Tick busyCycles     = 0;
+	acalsim::Tick drainCycles    = 0;
+	acalsim::Tick spmStallCycles = 0;  ///< Cycles tiles waited for the scratchpad beyond the PE timing
+};
+
+#endif  // SOC_INCLUDE_SYSTOLICARRAY_HH_
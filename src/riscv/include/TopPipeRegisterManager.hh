@@ -16,6 +16,7 @@
 #ifndef RISCV_INCLUDE_TOPPIPEREGISTERMANAGER_HH_
 #define RISCV_INCLUDE_TOPPIPEREGISTERMANAGER_HH_
 
+#include <map>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -25,6 +26,10 @@
 /**
  * @class TopPipeRegisterManager
  * @brief Concrete implementation of the pipe register manager
+ * @details The registers are synchronized in the serial phase of every tick, after all simulators
+ *          have stepped. They are visited in the order of their names rather than in the hash order
+ *          of the register table, so that a run never depends on how the table is laid out and the
+ *          simulators may step on any number of worker threads with bit-identical results.
  */
 class TopPipeRegisterManager : public acalsim::PipeRegisterManagerBase, virtual public acalsim::HashableType {
 public:
@@ -47,6 +52,9 @@ public:
 	 * @brief Implementation of the pipe register synchronization
 	 */
 	void runSyncPipeRegister();
+
+private:
+	std::vector<acalsim::SimPipeRegister*> syncOrder;  ///< Registers sorted by name
 };
 
 #endif
@@ -18,35 +18,61 @@
 #define SRC_RISCV_INCLUDE_WBSTAGE_HH_
 
 #include <string>
+#include <vector>
 
 #include "ACALSim.hh"
+#include "BinaryTrace.hh"
 #include "InstPacket.hh"
+#include "KonataTrace.hh"
 #include "SOC.hh"
 
 class WBStage : public acalsim::CPPSimBase {
 public:
-	WBStage(std::string name) : acalsim::CPPSimBase(name) {}
+	WBStage(std::string name, uint32_t _hartId = 0) : acalsim::CPPSimBase(name), hartId(_hartId) {}
 	~WBStage() {}
 
 	void init() override {}
 
 	void step() override {
-		if (this->getPipeRegister("prEXE2WB-out")->isValid()) {
-			SimPacket* pkt = this->getPipeRegister("prEXE2WB-out")->pop();
-			this->accept(top->getGlobalTick(), *pkt);
-			CLASS_INFO << "   WBStage step() pop an InstPacket @PC=" << ((InstPacket*)pkt)->pc;
+		if (this->prEXE2WB->isValid()) {
+			InstPacket* pkt = static_cast<InstPacket*>(this->prEXE2WB->pop());
+			pkt->visit(top->getGlobalTick(), *this);
+			SOC_TRACE(2, top->getGlobalTick(), TraceStage::WB, TraceEvent::WB_POP, this->hartId, pkt->pc, pkt->inst.op);
 		}
 	}
 
 	void cleanup() override {}
 
+	/**
+	 * @brief Resolves the pipe register handle used by step(), see IFStage::bindHandles()
+	 */
+	void bindHandles() { this->prEXE2WB = this->getPipeRegister("prEXE2WB-out"); }
+
+	/** @return Whether an instruction of the EXE stage is waiting */
+	bool hasWork() { return this->prEXE2WB->isValid(); }
+
 	void instPacketHandler(Tick when, InstPacket* pkt) {
-		CLASS_INFO << "   WBStage::instPacketHandler(()  has received from prEXE2WB-out and recycled inst@PC="
-		           << pkt->pc;
-		acalsim::top->getRecycleContainer()->recycle(pkt);
+		SOC_TRACE(2, when, TraceStage::WB, TraceEvent::WB_RETIRE, this->hartId, pkt->pc, pkt->inst.op);
+		SOC_KONATA(KonataTrace::retire(KonataTrace::WB, when, pkt->traceId, "WB"));
+		this->retired.push_back(pkt);
+	}
+
+	/**
+	 * @brief Returns the instruction packets retired in this tick to the recycle container
+	 * @details Called by SOCTop in the serial phase of the tick. The SOC acquires instruction packets
+	 *          while the stages step, possibly on another worker thread, so the stage never touches
+	 *          the shared recycle container itself.
+	 */
+	void recycleRetired() {
+		auto rc = acalsim::top->getRecycleContainer();
+		for (auto pkt : this->retired) { rc->recycle(pkt); }
+		this->retired.clear();
 	}
 
 private:
+	uint32_t                 hartId;              ///< Core the stage belongs to
+	SimPipeRegister*         prEXE2WB = nullptr;  ///< Pipe register from the EXE stage
+	std::vector<InstPacket*> retired;             ///< Packets retired in the current tick
 };
 
 #endif  // SRC_RISCV_INCLUDE_WBSTAGE_HH_
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOC_INCLUDE_EVENT_BUSEVENT_HH_
+#define SOC_INCLUDE_EVENT_BUSEVENT_HH_
+
+#include "ACALSim.hh"
+#include "Bus.hh"
+
+/**
+ * @class BusEvent
+ * @brief Arbitrates a channel of the bus or lets a blocked master retry
+ */
+class BusEvent : public acalsim::SimEvent {
+public:
+	enum Kind { ARBITRATE, RETRY };
+
+	BusEvent() = default;
+	BusEvent(Bus* _callee, Kind _kind, uint32_t _index);
+	virtual ~BusEvent() = default;
+
+	void renew(Bus* _callee, Kind _kind, uint32_t _index);
+	void process() override;
+
+private:
+	Bus*     callee;
+	Kind     kind;
+	uint32_t index;  ///< Channel to arbitrate or master to retry
+};
+
+#endif
@@ -0,0 +1,41 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOC_INCLUDE_EVENT_DRAMISSUEEVENT_HH_
+#define SOC_INCLUDE_EVENT_DRAMISSUEEVENT_HH_
+
+#include "ACALSim.hh"
+
+class DataMemory;
+
+/**
+ * @class DRAMIssueEvent
+ * @brief Wakes up the DRAM scheduler of DataMemory when a queued request may become issuable
+ */
+class DRAMIssueEvent : public acalsim::SimEvent {
+public:
+	DRAMIssueEvent() = default;
+	DRAMIssueEvent(DataMemory* _callee);
+	virtual ~DRAMIssueEvent() = default;
+
+	void renew(DataMemory* _callee);
+	void process() override;
+
+private:
+	DataMemory* callee;
+};
+
+#endif
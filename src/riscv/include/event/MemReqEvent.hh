@@ -18,21 +18,22 @@
 #define SOC_INCLUDE_EVENT_MEMREQEVENT_HH_
 
 #include "ACALSim.hh"
-
-class DataMemory;
+#include "PacketTarget.hh"
 
 class MemReqEvent : public acalsim::SimEvent {
 public:
 	MemReqEvent() = default;
-	MemReqEvent(DataMemory* _callee, acalsim::SimPacket* _memReqPkt);
+	MemReqEvent(acalsim::SimModule* _callee, MemoryTarget _kind, acalsim::SimPacket* _memReqPkt, bool _isWrite);
 	virtual ~MemReqEvent() = default;
 
-	void renew(DataMemory* _callee, acalsim::SimPacket* _memReqPkt);
+	void renew(acalsim::SimModule* _callee, MemoryTarget _kind, acalsim::SimPacket* _memReqPkt, bool _isWrite);
 	void process() override;
 
 private:
-	DataMemory*         callee;
+	acalsim::SimModule* callee;
+	MemoryTarget        kind;     ///< Type of the callee
 	acalsim::SimPacket* memReqPkt;
+	bool                isWrite;  ///< The packet is a MemWriteReqPacket
 };
 
 #endif
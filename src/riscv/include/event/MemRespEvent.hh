@@ -0,0 +1,43 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOC_INCLUDE_EVENT_MEMRESPEVENT_HH_
+#define SOC_INCLUDE_EVENT_MEMRESPEVENT_HH_
+
+#include <functional>
+
+#include "ACALSim.hh"
+
+/**
+ * @class MemRespEvent
+ * @brief Delivers a memory response to its requester after the access latency
+ * @details The callback is usually a bound request callback that hands a response packet back
+ *          to the requester.
+ */
+class MemRespEvent : public acalsim::SimEvent {
+public:
+	MemRespEvent() = default;
+	MemRespEvent(std::function<void()> _callback);
+	virtual ~MemRespEvent() = default;
+
+	void renew(std::function<void()> _callback);
+	void process() override;
+
+private:
+	std::function<void()> callback;
+};
+
+#endif
@@ -0,0 +1,41 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOC_INCLUDE_EVENT_SAEVENT_HH_
+#define SOC_INCLUDE_EVENT_SAEVENT_HH_
+
+#include "ACALSim.hh"
+
+class SystolicArray;
+
+/**
+ * @class SAEvent
+ * @brief Completes a tile pass of the systolic array
+ */
+class SAEvent : public acalsim::SimEvent {
+public:
+	SAEvent() = default;
+	SAEvent(SystolicArray* _callee);
+	virtual ~SAEvent() = default;
+
+	void renew(SystolicArray* _callee);
+	void process() override;
+
+private:
+	SystolicArray* callee;
+};
+
+#endif
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BinaryTrace.hh"
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+constexpr size_t kBufferRecords = 4096;
+constexpr size_t kMaxBuffers    = 64;  ///< Buffers allocated at most, about 6 MiB of records
+
+/// Records of one thread, written to the file as a whole
+struct Buffer {
+	TraceRecord records[kBufferRecords];
+	size_t      count = 0;
+};
+
+/// State shared by the recording threads and the writer, guarded by `mutex`
+struct Writer {
+	std::mutex              mutex;
+	std::condition_variable wakeup;
+	std::condition_variable returned;  ///< Signaled when the writer hands a buffer back to `spare`
+	std::deque<Buffer*>     full;     ///< Buffers waiting to be written
+	std::vector<Buffer*>    spare;    ///< Written buffers, reused by the recording threads
+	std::vector<Buffer*>    owned;    ///< Buffer currently used by each thread
+	bool                    stop = false;
+	FILE*                   file = nullptr;
+	std::thread             thread;
+	uint32_t                generation = 0;  ///< Incremented by every open(), invalidates the thread buffers
+	size_t                  allocated  = 0;  ///< Buffers in the pool, owned, full or spare
+};
+
+Writer writer;
+
+thread_local Buffer*  threadBuffer     = nullptr;
+thread_local uint32_t threadGeneration = 0;
+
+/// Takes a buffer from the pool; once kMaxBuffers are allocated a caller that queued a full buffer waits for it
+Buffer* takeSpare(std::unique_lock<std::mutex>& _lock, bool _queued) {
+	if (writer.spare.empty() && (writer.allocated < kMaxBuffers || !_queued)) {
+		writer.allocated++;
+		return new Buffer();
+	}
+
+	// The writer has at least the buffer of the caller to hand back
+	writer.returned.wait(_lock, [] { return !writer.spare.empty(); });
+	Buffer* buffer = writer.spare.back();
+	writer.spare.pop_back();
+	buffer->count = 0;
+	return buffer;
+}
+
+void writeLoop() {
+	std::unique_lock<std::mutex> lock(writer.mutex);
+	while (true) {
+		writer.wakeup.wait(lock, [] { return writer.stop || !writer.full.empty(); });
+		if (writer.full.empty()) return;
+		Buffer* buffer = writer.full.front();
+		writer.full.pop_front();
+
+		// Write without holding the lock, the recording threads only take it to swap buffers
+		lock.unlock();
+		std::fwrite(buffer->records, sizeof(TraceRecord), buffer->count, writer.file);
+		lock.lock();
+		writer.spare.push_back(buffer);
+		writer.returned.notify_all();
+	}
+}
+
+}  // namespace
+
+std::atomic<bool> BinaryTrace::enabled{false};
+
+void BinaryTrace::open(const std::string& _path, const std::vector<std::string>& _opNames) {
+	ASSERT_MSG(!isEnabled(), "The binary trace is already open.");
+	writer.file = std::fopen(_path.c_str(), "wb");
+	ASSERT_MSG(writer.file, "Cannot open the binary trace file.");
+
+	const char magic[8]  = {'S', 'O', 'C', 'T', 'R', 'C', '0', '1'};
+	uint32_t   header[2] = {sizeof(TraceRecord), (uint32_t)_opNames.size()};
+	std::fwrite(magic, 1, sizeof(magic), writer.file);
+	std::fwrite(header, sizeof(uint32_t), 2, writer.file);
+	for (auto& name : _opNames) { std::fwrite(name.c_str(), 1, name.size() + 1, writer.file); }
+
+	writer.stop = false;
+	writer.generation++;
+	writer.thread = std::thread(writeLoop);
+	enabled.store(true, std::memory_order_release);
+}
+
+void BinaryTrace::close() {
+	if (!isEnabled()) return;
+	enabled.store(false, std::memory_order_release);
+	{
+		std::lock_guard<std::mutex> lock(writer.mutex);
+		for (auto buffer : writer.owned) {
+			if (buffer->count) {
+				writer.full.push_back(buffer);
+			} else {
+				writer.spare.push_back(buffer);
+			}
+		}
+		writer.owned.clear();
+		writer.stop = true;
+	}
+	writer.wakeup.notify_one();
+	writer.thread.join();
+	std::fclose(writer.file);
+	writer.file = nullptr;
+	for (auto buffer : writer.spare) { delete buffer; }
+	writer.spare.clear();
+	writer.allocated = 0;
+}
+
+void BinaryTrace::record(acalsim::Tick _tick, TraceStage _stage, TraceEvent _kind, uint32_t _hartId, uint32_t _pc,
+                         uint32_t _op, uint32_t _arg) {
+	if (!threadBuffer || threadGeneration != writer.generation || threadBuffer->count == kBufferRecords) {
+		std::unique_lock<std::mutex> lock(writer.mutex);
+		bool                         queued = threadBuffer && threadGeneration == writer.generation;
+		if (queued) {
+			// Hand the full buffer to the writer
+			std::erase(writer.owned, threadBuffer);
+			writer.full.push_back(threadBuffer);
+			writer.wakeup.notify_one();
+		}
+		threadBuffer     = takeSpare(lock, queued);
+		threadGeneration = writer.generation;
+		writer.owned.push_back(threadBuffer);
+	}
+
+	TraceRecord& rec = threadBuffer->records[threadBuffer->count++];
+	rec.tick         = _tick;
+	rec.pc           = _pc;
+	rec.arg          = _arg;
+	rec.hartId       = _hartId;
+	rec.stage        = (uint8_t)_stage;
+	rec.op           = _op;
+	rec.kind         = (uint8_t)_kind;
+}
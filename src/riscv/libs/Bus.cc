@@ -0,0 +1,282 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Bus.hh"
+
+#include <algorithm>
+#include <bit>
+#include <sstream>
+
+#include "MemPacket.hh"
+#include "event/BusEvent.hh"
+#include "event/MemReqEvent.hh"
+
+Bus::Bus(std::string _name) : acalsim::SimModule(_name), lastHit(0) {
+	this->hopLatency = acalsim::top->getParameter<acalsim::Tick>("Bus", "hop_latency");
+	this->dataWidth  = acalsim::top->getParameter<int>("Bus", "data_width");
+	ASSERT_MSG(this->dataWidth > 0, "The bus must transfer at least one byte per beat.");
+
+	std::string arbitration = acalsim::top->getParameter<std::string>("Bus", "arbitration");
+	ASSERT_MSG(arbitration == "round_robin" || arbitration == "priority",
+	           "The bus arbitration must be \"round_robin\" or \"priority\".");
+	this->arbitration = arbitration == "priority" ? Arbitration::PRIORITY : Arbitration::ROUND_ROBIN;
+}
+
+void Bus::addTarget(const std::string& _name, uint32_t _baseAddr, uint32_t _size, acalsim::SimModule* _module,
+                    MemoryTarget _kind, MMIODevice* _device) {
+	Target target;
+	target.name     = _name;
+	target.baseAddr = _baseAddr;
+	target.size     = _size;
+	target.module   = _module;
+	target.kind     = _kind;
+	target.device   = _device;
+
+	auto it = std::upper_bound(this->targets.begin(), this->targets.end(), _baseAddr,
+	                           [](uint32_t _addr, const Target& _t) { return _addr < _t.baseAddr; });
+	ASSERT_MSG(it == this->targets.end() || (uint64_t)_baseAddr + _size <= it->baseAddr,
+	           "The address ranges of two bus targets overlap.");
+	ASSERT_MSG(it == this->targets.begin() || (uint64_t)(it - 1)->baseAddr + (it - 1)->size <= _baseAddr,
+	           "The address ranges of two bus targets overlap.");
+	this->targets.insert(it, target);
+	this->lastHit = 0;
+}
+
+uint32_t Bus::addMaster(const std::string& _name, const std::string& _port, uint32_t _maxOutstanding) {
+	ASSERT_MSG(_maxOutstanding > 0, "A bus master must be allowed at least one outstanding request.");
+
+	Master master;
+	master.name           = _name;
+	master.port           = _port;
+	master.maxOutstanding = _maxOutstanding;
+	this->masters.push_back(std::move(master));
+	return this->masters.size() - 1;
+}
+
+const Bus::Target* Bus::decode(uint32_t _addr) const {
+	size_t index = this->findTarget(_addr);
+	return index < this->targets.size() ? &this->targets[index] : nullptr;
+}
+
+size_t Bus::findTarget(uint32_t _addr) const {
+	if (this->lastHit < this->targets.size() && this->targets[this->lastHit].contains(_addr)) return this->lastHit;
+
+	// The last target whose base address is not above the address is the only candidate
+	auto it = std::upper_bound(this->targets.begin(), this->targets.end(), _addr,
+	                           [](uint32_t _addr, const Target& _t) { return _addr < _t.baseAddr; });
+	if (it == this->targets.begin() || !(it - 1)->contains(_addr)) return this->targets.size();
+
+	this->lastHit = it - 1 - this->targets.begin();
+	return this->lastHit;
+}
+
+bool Bus::send(acalsim::Tick _when, uint32_t _master, acalsim::SimPacket* _memReqPkt, uint32_t _addr, uint32_t _bytes,
+               bool _isWrite, acalsim::Tick _latency) {
+	Request req;
+	req.bytes   = _bytes;
+	req.pkt     = _memReqPkt;
+	req.isWrite = _isWrite;
+	req.latency = _latency;
+	return this->enqueue(_when, _master, _addr, _isWrite, std::move(req));
+}
+
+bool Bus::transfer(acalsim::Tick _when, uint32_t _master, uint32_t _addr, uint32_t _bytes, bool _isWrite,
+                   std::function<void(acalsim::Tick)> _callback) {
+	Request req;
+	req.bytes    = _bytes;
+	req.callback = std::move(_callback);
+	return this->enqueue(_when, _master, _addr, _isWrite, std::move(req));
+}
+
+bool Bus::enqueue(acalsim::Tick _when, uint32_t _master, uint32_t _addr, bool _isWrite, Request&& _req) {
+	Master& master = this->masters[_master];
+	if (this->getOutstanding(_when, master) >= master.maxOutstanding) {
+		master.refused++;
+		master.blocked = true;
+		this->scheduleRetry(_master);
+		return false;
+	}
+
+	size_t index = this->findTarget(_addr);
+	ASSERT_MSG(index < this->targets.size(), "The bus request targets an unmapped address.");
+	Target* target = &this->targets[index];
+	target->requests++;
+
+	Channel channel = _isWrite ? WRITE : READ;
+	_req.issue      = _when;
+	_req.arrival    = _when + this->hopLatency;
+	_req.target     = target;
+	master.requests[channel]++;
+	master.bytes[channel] += _req.bytes;
+	master.queues[channel].push_back(std::move(_req));
+
+	this->arbitrate(_when, channel);
+	return true;
+}
+
+uint32_t Bus::getOutstanding(acalsim::Tick _when, Master& _master) {
+	while (!_master.retireTicks.empty() && _master.retireTicks.top() <= _when) _master.retireTicks.pop();
+	return _master.retireTicks.size() + _master.queues[READ].size() + _master.queues[WRITE].size();
+}
+
+void Bus::arbitrate(acalsim::Tick _when, Channel _channel) {
+	ChannelState& state = this->channels[_channel];
+	if (state.nextArbitrate <= _when) state.nextArbitrate = 0;
+
+	// At most one request is granted per cycle, the channel stays busy for its beats
+	if (state.freeTick <= _when) {
+		size_t count = this->masters.size();
+		for (size_t i = 0; i < count; i++) {
+			size_t index = this->arbitration == Arbitration::ROUND_ROBIN ? (state.rrNext + i) % count : i;
+			auto&  queue = this->masters[index].queues[_channel];
+			if (queue.empty() || queue.front().arrival > _when) continue;
+
+			state.rrNext = (index + 1) % count;
+			this->grant(_when, _channel, index);
+			break;
+		}
+	}
+
+	// Arbitrate again once the channel is free and a waiting request has crossed the bus
+	bool          waiting = false;
+	acalsim::Tick next    = 0;
+	for (const auto& master : this->masters) {
+		if (master.queues[_channel].empty()) continue;
+		acalsim::Tick tick = std::max(state.freeTick, master.queues[_channel].front().arrival);
+		next               = waiting ? std::min(next, tick) : tick;
+		waiting            = true;
+	}
+	if (waiting) this->scheduleArbitration(_channel, next);
+}
+
+void Bus::grant(acalsim::Tick _when, Channel _channel, uint32_t _master) {
+	Master&       master = this->masters[_master];
+	ChannelState& state  = this->channels[_channel];
+	Request       req    = std::move(master.queues[_channel].front());
+	master.queues[_channel].pop_front();
+
+	acalsim::Tick beats = std::max<acalsim::Tick>((req.bytes + this->dataWidth - 1) / this->dataWidth, 1);
+	state.freeTick      = _when + beats;
+	state.busyCycles += beats;
+	master.waitCycles += _when - req.arrival;
+
+	// A packet request retires when it reaches its target, a transfer with its last beat
+	acalsim::Tick retire = req.pkt ? _when + std::max<acalsim::Tick>(req.latency, 1) - 1 : _when + beats;
+	master.retireTicks.push(retire);
+
+	acalsim::Tick latency = retire - req.issue;
+	size_t        bucket  = std::bit_width(latency);
+	if (master.latencyHist.size() <= bucket) master.latencyHist.resize(bucket + 1, 0);
+	master.latencyHist[bucket]++;
+	master.latencySum += latency;
+
+	if (master.blocked) this->scheduleRetry(_master);
+
+	// The bus state is final, the target or the callback may send new requests
+	if (!req.pkt) {
+		req.callback(retire);
+	} else if (retire == _when) {
+		visitMemoryTarget(_when, *req.pkt, req.isWrite, req.target->kind, *req.target->module);
+	} else {
+		auto         rc    = acalsim::top->getRecycleContainer();
+		MemReqEvent* event = rc->acquire<MemReqEvent>(&MemReqEvent::renew, req.target->module, req.target->kind,
+		                                              req.pkt, req.isWrite);
+		this->scheduleEvent(event, retire);
+	}
+}
+
+void Bus::scheduleArbitration(Channel _channel, acalsim::Tick _when) {
+	ChannelState& state = this->channels[_channel];
+	// An earlier arbitration schedules the following ones itself
+	if (state.nextArbitrate && state.nextArbitrate <= _when) return;
+
+	state.nextArbitrate = _when;
+	auto      rc        = acalsim::top->getRecycleContainer();
+	BusEvent* event     = rc->acquire<BusEvent>(&BusEvent::renew, this, BusEvent::ARBITRATE, (uint32_t)_channel);
+	this->scheduleEvent(event, _when);
+}
+
+void Bus::scheduleRetry(uint32_t _master) {
+	Master& master = this->masters[_master];
+	// Requests still waiting for a grant schedule the retry when they are granted
+	if (master.retryPending || master.retireTicks.empty()) return;
+
+	master.retryPending = true;
+	acalsim::Tick when  = std::max(master.retireTicks.top(), acalsim::top->getGlobalTick() + 1);
+	auto          rc    = acalsim::top->getRecycleContainer();
+	BusEvent*     event = rc->acquire<BusEvent>(&BusEvent::renew, this, BusEvent::RETRY, _master);
+	this->scheduleEvent(event, when);
+}
+
+void Bus::retry(acalsim::Tick _when, uint32_t _master) {
+	Master& master      = this->masters[_master];
+	master.retryPending = false;
+	if (!master.blocked) return;
+
+	master.blocked = false;
+	if (this->retryHandler) this->retryHandler(master.port);
+}
+
+void Bus::printStats() const {
+	acalsim::Tick ticks = std::max<acalsim::Tick>(acalsim::top->getGlobalTick(), 1);
+
+	for (uint32_t channel = 0; channel < NUM_CHANNELS; channel++) {
+		acalsim::Tick busy = this->channels[channel].busyCycles;
+		CLASS_INFO << "Bus " << (channel == READ ? "read" : "write") << " channel: " << busy << " busy cycles ("
+		           << 100.0 * busy / ticks << "% utilization)";
+	}
+
+	for (const auto& master : this->masters) {
+		uint64_t requests = master.requests[READ] + master.requests[WRITE];
+		if (!requests) continue;
+
+		double avgLatency = (double)master.latencySum / requests;
+		CLASS_INFO << "Bus master " << master.name << ": " << master.requests[READ] << " reads ("
+		           << (double)master.bytes[READ] / ticks << " bytes/cycle) | " << master.requests[WRITE] << " writes ("
+		           << (double)master.bytes[WRITE] / ticks << " bytes/cycle) | " << master.waitCycles
+		           << " cycles waiting for a grant | average latency " << avgLatency << " | " << master.refused
+		           << " sends refused";
+
+		std::ostringstream oss;
+		for (size_t bucket = 0; bucket < master.latencyHist.size(); bucket++) {
+			if (!master.latencyHist[bucket]) continue;
+			if (bucket) {
+				oss << " [" << (1ull << (bucket - 1)) << ", " << (1ull << bucket) << "): ";
+			} else {
+				oss << " [0]: ";
+			}
+			oss << master.latencyHist[bucket];
+		}
+		CLASS_INFO << "Bus master " << master.name << " latency histogram:" << oss.str();
+	}
+
+	for (const auto& target : this->targets) {
+		if (target.requests) CLASS_INFO << "Bus target " << target.name << ": " << target.requests << " requests";
+	}
+}
+
+void Bus::addIntervalStats(IntervalStats& _stats, const std::string& _prefix) const {
+	for (uint32_t channel = 0; channel < NUM_CHANNELS; channel++) {
+		std::string name = _prefix + (channel == READ ? "read_" : "write_");
+		_stats.addCounter(name + "busy_cycles", [this, channel] { return this->channels[channel].busyCycles; });
+		_stats.addCounter(name + "bytes", [this, channel] {
+			uint64_t bytes = 0;
+			for (const auto& master : this->masters) { bytes += master.bytes[channel]; }
+			return bytes;
+		});
+		_stats.addRatio(name + "bandwidth", name + "bytes", "cycles");
+	}
+}
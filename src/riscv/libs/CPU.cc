@@ -16,17 +16,52 @@
 
 #include "CPU.hh"
 
+#include <algorithm>
 #include <iomanip>
+#include <iterator>
 #include <sstream>
 
+#include "BinaryTrace.hh"
 #include "DataMemory.hh"
 #include "InstPacket.hh"
+#include "KonataTrace.hh"
 #include "SOC.hh"
 #include "event/ExecOneInstrEvent.hh"
-#include "event/MemReqEvent.hh"
 
-CPU::CPU(std::string _name, SOC* _soc)
-    : acalsim::SimModule(_name), pc(0), inst_cnt(0), soc(_soc), pendingInstPacket(nullptr) {
+CPU::CPU(std::string _name, SOC* _soc, uint32_t _hartId)
+    : acalsim::SimModule(_name),
+      pc(0),
+      inst_cnt(0),
+      hartId(_hartId),
+      ifPort(SOC::getIFPortName(_hartId)),
+      ifMasterPort(nullptr),
+      halted(false),
+      soc(_soc),
+      bus(nullptr),
+      busMaster(0),
+      pendingInstPacket(nullptr),
+      memInstPacket(nullptr),
+      memReqTick(0),
+      memAccessCnt(0),
+      memStallCycles(0),
+      dcache(nullptr),
+      pendingLoadRegs(0),
+      loadUseStalled(false),
+      loadUseStallTick(0) {
+	this->memReadLatency  = acalsim::top->getParameter<acalsim::Tick>("SOC", "memory_read_latency");
+	this->memWriteLatency = acalsim::top->getParameter<acalsim::Tick>("SOC", "memory_write_latency");
+	this->idleLoopSkip    = acalsim::top->getParameter<int>("SOC", "idle_loop_skip");
+	this->pipelineModel   = acalsim::top->getParameter<int>("SOC", "pipeline_models");
+	this->quantum         = acalsim::top->getParameter<int>("SOC", "quantum");
+	ASSERT_MSG(this->quantum > 0, "The quantum must be at least one cycle.");
+	ASSERT_MSG(this->quantum == 1 || !this->pipelineModel,
+	           "Running ahead needs SOC.pipeline_models = 0, the IF stage takes one instruction per cycle.");
+
+	std::string atomicLocation = acalsim::top->getParameter<std::string>("SOC", "atomic_location");
+	ASSERT_MSG(atomicLocation == "cache" || atomicLocation == "memory",
+	           "Unknown atomic location, expected \"cache\" or \"memory\".");
+	this->atomicsAtMemory = atomicLocation == "memory";
+
 	auto data_offset = acalsim::top->getParameter<int>("Emulator", "data_offset");
 	this->imem       = new instr[data_offset / 4];
 	for (int i = 0; i < data_offset / 4; i++) {
@@ -35,7 +70,13 @@ CPU::CPU(std::string _name, SOC* _soc)
 		this->imem[i].a2.type = OPTYPE_NONE;
 		this->imem[i].a3.type = OPTYPE_NONE;
 	}
+	if (!acalsim::top->getParameter<std::string>("SOC", "pc_profile").empty()) {
+		this->profiler = new PCProfiler(data_offset / 4);
+	}
+
 	for (int i = 0; i < 32; i++) { this->rf[i] = 0; }
+	// As on RISC-V boot, a0 holds the hart ID so that software can tell the cores apart
+	this->rf[10] = _hartId;
 }
 
 void CPU::execOneInstr() {
@@ -43,18 +84,71 @@ void CPU::execOneInstr() {
 	// Fetch instrucion
 	instr i = this->fetchInstr(this->pc);
 
+	if (this->dcache) {
+		// Stall on use: wait until every outstanding load this instruction depends on has returned
+		if (this->getRegMask(i) & this->pendingLoadRegs) {
+			this->loadUseStalled   = true;
+			this->loadUseStallTick = acalsim::top->getGlobalTick();
+			if (this->profiler) this->profiler->hold();
+			return;
+		}
+		// Retry in the next cycle if the data cache runs out of MSHRs or the bus refuses more uncached
+		// requests of the CPU
+		if (this->isMemInstr(i.op)) {
+			uint32_t      addr     = this->rf[i.a2.reg] + i.a3.imm;
+			bool          isWrite  = i.op == SB || i.op == SH || i.op == SW || (isAtomicOp(i.op) && i.op != LR_W);
+			bool          uncached = this->soc->findDevice(addr) || (isAtomicOp(i.op) && this->atomicsAtMemory);
+			acalsim::Tick now      = acalsim::top->getGlobalTick();
+			bool          accepted = uncached ? this->bus->isReqAcceptable(now, this->busMaster)
+			                                  : this->dcache->isReqAcceptable(addr, isWrite);
+			if (!accepted) {
+				if (this->profiler) this->profiler->hold();
+				this->scheduleExecOneInstr(now + 1);
+				return;
+			}
+		}
+	}
+
+	if (this->idleLoopSkip && this->skipIdleLoop()) return;
+
 	// Prepare instruction packet
 	auto        rc         = top->getRecycleContainer();
 	InstPacket* instPacket = rc->acquire<InstPacket>(&InstPacket::renew, i);
 	instPacket->pc         = this->pc;
 
-	// Execute the instruction in the same cycle
+	if (this->quantum == 1) {
+		// Execute the instruction in the same cycle
+		processInstr(i, instPacket);
+		return;
+	}
+
+	// Run ahead: scheduleExecOneInstr() only records the tick of the next instruction, which is executed
+	// right away as long as it stays inside the core and the quantum
+	acalsim::Tick now  = acalsim::top->getGlobalTick();
+	uint64_t      done = this->runAheadInstrs;
+	this->runAhead     = true;
+	this->runAheadTick = now;
+	this->runAheadNext = 0;
 	processInstr(i, instPacket);
+	while (this->runAheadNext && this->runAheadNext - now < this->quantum) {
+		instr next = this->fetchInstr(this->pc);
+		if (!this->isCoreLocal(next)) break;
+		this->runAheadTick = this->runAheadNext;
+		this->runAheadNext = 0;
+		instPacket         = rc->acquire<InstPacket>(&InstPacket::renew, next);
+		instPacket->pc     = this->pc;
+		processInstr(next, instPacket);
+		this->runAheadInstrs++;
+	}
+	this->runAhead = false;
+	if (this->runAheadInstrs != done) this->runAheadEvents++;
+	if (this->runAheadNext) this->scheduleExecOneInstr(this->runAheadNext);
 }
 
 void CPU::processInstr(const instr& _i, InstPacket* instPacket) {
-	bool  done   = false;
 	auto& rf_ref = this->rf;
+	if (this->idleLoopSkip) this->trackIdleLoop(_i);
+	if (this->profiler) this->profiler->issue(this->pc, this->getLocalTick());
 	this->incrementInstCount();
 	int pc_next = this->pc + 4;
 
@@ -110,14 +204,36 @@ void CPU::processInstr(const instr& _i, InstPacket* instPacket) {
 		case AUIPC: rf_ref[_i.a1.reg] = this->pc + (_i.a2.imm << 12); break;
 		case LUI: rf_ref[_i.a1.reg] = (_i.a2.imm << 12); break;
 
+		// Without a data cache, memory instructions stall the CPU until the response comes back
+		// and are committed in the response handlers instead of here.
 		case LB:
 		case LBU:
 		case LH:
 		case LHU:
-		case LW: this->memRead(_i, _i.op, this->rf[_i.a2.reg] + _i.a3.imm, _i.a1, instPacket); break;
+		case LW:
+			this->memRead(_i, _i.op, this->rf[_i.a2.reg] + _i.a3.imm, _i.a1, instPacket);
+			if (!this->dcache) return;
+			break;
 		case SB:
 		case SH:
-		case SW: this->memWrite(_i, _i.op, this->rf[_i.a2.reg] + _i.a3.imm, this->rf[_i.a1.reg], instPacket); break;
+		case SW:
+			this->memWrite(_i, _i.op, this->rf[_i.a2.reg] + _i.a3.imm, this->rf[_i.a1.reg], instPacket);
+			if (!this->dcache) return;
+			break;
+		case LR_W:
+		case SC_W:
+		case AMOSWAP_W:
+		case AMOADD_W:
+		case AMOXOR_W:
+		case AMOAND_W:
+		case AMOOR_W:
+		case AMOMIN_W:
+		case AMOMAX_W:
+		case AMOMINU_W:
+		case AMOMAXU_W:
+			this->memAtomic(_i, this->rf[_i.a2.reg], this->rf[_i.a3.reg], instPacket);
+			if (!this->dcache) return;
+			break;
 
 		case HCF: break;
 		case UNIMPL:
@@ -127,55 +243,73 @@ void CPU::processInstr(const instr& _i, InstPacket* instPacket) {
 			break;
 	}
 
-	this->commitInstr(_i, instPacket);
+	if (this->idleLoopSkip && (uint32_t)pc_next < this->pc) this->updateIdleLoopCandidate(this->pc, pc_next);
+
 	if (pc_next != pc + 4) instPacket->isTakenBranch = true;
+	this->commitInstr(_i, instPacket);
 	this->pc = pc_next;
 }
 
 void CPU::commitInstr(const instr& _i, InstPacket* instPacket) {
+	if (!this->pipelineModel) {
+		// No stage simulators to send the packet to, the instruction retires here
+		SOC_TRACE(1, this->getLocalTick(), TraceStage::CPU, TraceEvent::COMMIT, this->hartId, this->pc, _i.op);
+		acalsim::top->getRecycleContainer()->recycle(instPacket);
+		if (_i.op == HCF) {
+			this->halted   = true;
+			this->haltTick = this->getLocalTick();
+			return;
+		}
+		this->scheduleExecOneInstr(this->getLocalTick() + 1);
+		return;
+	}
+
+	// The instruction enters the pipeline trace when it is first offered to the IF stage
+	acalsim::Tick now = acalsim::top->getGlobalTick();
+	SOC_KONATA(instPacket->traceId = KonataTrace::fetch(now, this->hartId, instPacket->pc, instrToString(_i.op)));
+
 	if (_i.op == HCF) {
 		// end of simulation.
 		// Stop scheduling new events to process instructions.
 		// There might be pending events in the simulator.
-		if (!this->soc->getMasterPort("sIF-m")->push(instPacket)) {
+		this->halted   = true;
+		this->haltTick = now;
+		if (!this->ifMasterPort->push(instPacket)) {
 			pendingInstPacket = instPacket;
+			SOC_KONATA(KonataTrace::stall(KonataTrace::CPU, now, instPacket->traceId, "Bp"));
 		} else {
-			CLASS_INFO << "Instruction " << this->instrToString(_i.op)
-			           << " is completed at Tick = " << acalsim::top->getGlobalTick() << " | PC = " << this->pc;
+			SOC_TRACE(1, now, TraceStage::CPU, TraceEvent::COMMIT, this->hartId, this->pc, _i.op);
 		}
 		return;
 	}
 
 	// send the packet to the IF stage
-	if (this->soc->getMasterPort("sIF-m")->push(instPacket)) {
+	if (this->ifMasterPort->push(instPacket)) {
 		// send the instruction packet to the IF stage successfully
 		// schedule the next trigger event
-		CLASS_INFO << "Instruction " << this->instrToString(_i.op)
-		           << " is completed at Tick = " << acalsim::top->getGlobalTick() << " | PC = " << this->pc;
-		CLASS_INFO << "send " + this->instrToString(instPacket->inst.op) << "@ PC=" << instPacket->pc
-		           << " to IFStage successfully";
-		auto               rc = acalsim::top->getRecycleContainer();
-		ExecOneInstrEvent* event =
-		    rc->acquire<ExecOneInstrEvent>(&ExecOneInstrEvent::renew, this->getInstCount() /*id*/, this);
-		this->scheduleEvent(event, acalsim::top->getGlobalTick() + 1);
+		SOC_TRACE(1, now, TraceStage::CPU, TraceEvent::COMMIT, this->hartId, this->pc, _i.op);
+		SOC_TRACE(1, now, TraceStage::CPU, TraceEvent::SEND_IF, this->hartId, instPacket->pc, instPacket->inst.op);
+		this->scheduleExecOneInstr(now + 1);
 	} else {
 		// get backpressure from the IF stage
 		// Wait until the master port pops out the entry and retry
 		// This case, we need to store the instruction packet locally
 		pendingInstPacket = instPacket;
-		CLASS_INFO << "send " + this->instrToString(instPacket->inst.op) << "@ PC=" << instPacket->pc
-		           << ", Got backpressure";
+		SOC_TRACE(1, now, TraceStage::CPU, TraceEvent::SEND_IF_BLOCKED, this->hartId, instPacket->pc,
+		          instPacket->inst.op);
+		SOC_KONATA(KonataTrace::stall(KonataTrace::CPU, now, instPacket->traceId, "Bp"));
 	}
 }
 
 void CPU::retrySendInstPacket(MasterPort* mp) {
 	if (!pendingInstPacket) return;
 	if (mp->push(pendingInstPacket)) {
-		CLASS_INFO << "resend " + this->instrToString(pendingInstPacket->inst.op) << "@ PC=" << pendingInstPacket->pc
-		           << " to IFStage successfully";
-		CLASS_INFO << "Instruction " << this->instrToString(pendingInstPacket->inst.op)
-		           << " is completed at Tick = " << acalsim::top->getGlobalTick()
-		           << " | PC = " << pendingInstPacket->pc;
+		acalsim::Tick now = acalsim::top->getGlobalTick();
+		uint32_t      pc  = pendingInstPacket->pc;
+		uint32_t      op  = pendingInstPacket->inst.op;
+		SOC_TRACE(1, now, TraceStage::CPU, TraceEvent::RESEND_IF, this->hartId, pc, op);
+		SOC_TRACE(1, now, TraceStage::CPU, TraceEvent::COMMIT, this->hartId, pc, op);
+		SOC_KONATA(KonataTrace::resume(KonataTrace::CPU, now, pendingInstPacket->traceId, "Bp"));
 
 		if (pendingInstPacket->inst.op == HCF) {
 			pendingInstPacket = nullptr;
@@ -184,10 +318,7 @@ void CPU::retrySendInstPacket(MasterPort* mp) {
 
 		// send the instruction packet to the IF stage successfully
 		// schedule the next trigger event
-		auto               rc = acalsim::top->getRecycleContainer();
-		ExecOneInstrEvent* event =
-		    rc->acquire<ExecOneInstrEvent>(&ExecOneInstrEvent::renew, this->getInstCount() /*id*/, this);
-		this->scheduleEvent(event, acalsim::top->getGlobalTick() + 1);
+		this->scheduleExecOneInstr(acalsim::top->getGlobalTick() + 1);
 		pendingInstPacket = nullptr;
 	} else {
 		CLASS_ERROR << " CPU::retrySendInstPacket() failed!";
@@ -195,26 +326,241 @@ void CPU::retrySendInstPacket(MasterPort* mp) {
 }
 
 bool CPU::memRead(const instr& _i, instr_type _op, uint32_t _addr, operand _a1, InstPacket* instPacket) {
-	// If latency is larger than 1, e.g. cache miss or multi-cycle SRAM reads
+	auto callback = [this](MemReadRespPacket* _pkt) { _pkt->visit(acalsim::top->getGlobalTick(), *this); };
 
 	auto              rc  = acalsim::top->getRecycleContainer();
-	MemReadReqPacket* pkt = rc->acquire<MemReadReqPacket>(&MemReadReqPacket::renew, nullptr, _i, _op, _addr, _a1);
-	auto data = ((DataMemory*)this->getDownStream("DSDmem"))->memReadReqHandler(acalsim::top->getGlobalTick(), pkt);
-	this->rf[_i.a1.reg] = data;
-	CLASS_INFO << "handle memRead for " << this->instrToString(instPacket->inst.op) << " @ PC=" << instPacket->pc;
+	MemReadReqPacket* pkt = rc->acquire<MemReadReqPacket>(&MemReadReqPacket::renew, callback, _i, _op, _addr, _a1);
+	pkt->setPC(instPacket->pc);
+
+	if (this->dcache) {
+		if (_a1.reg) this->pendingLoadRegs |= 1u << _a1.reg;
+	} else {
+		this->memInstPacket = instPacket;
+		this->memReqTick    = acalsim::top->getGlobalTick();
+	}
+	SOC_TRACE(1, acalsim::top->getGlobalTick(), TraceStage::CPU, TraceEvent::MEM_READ, this->hartId, instPacket->pc,
+	          instPacket->inst.op);
+	this->sendMemReq(pkt, _addr, false, this->memReadLatency);
 	return true;
 }
 
 bool CPU::memWrite(const instr& _i, instr_type _op, uint32_t _addr, uint32_t _data, InstPacket* instPacket) {
-	auto rc = acalsim::top->getRecycleContainer();
+	auto callback = [this](MemWriteRespPacket* _pkt) { _pkt->visit(acalsim::top->getGlobalTick(), *this); };
 
-	MemWriteReqPacket* pkt = rc->acquire<MemWriteReqPacket>(&MemWriteReqPacket::renew, nullptr, _i, _op, _addr, _data);
-	this->getDownStream("DSDmem")->accept(acalsim::top->getGlobalTick(), *((acalsim::SimPacket*)pkt));
-	CLASS_INFO << "handle memWrite for " << this->instrToString(instPacket->inst.op) << " @ PC=" << instPacket->pc;
+	auto               rc  = acalsim::top->getRecycleContainer();
+	MemWriteReqPacket* pkt = rc->acquire<MemWriteReqPacket>(&MemWriteReqPacket::renew, callback, _i, _op, _addr, _data);
+	pkt->setPC(instPacket->pc);
 
+	if (!this->dcache) {
+		this->memInstPacket = instPacket;
+		this->memReqTick    = acalsim::top->getGlobalTick();
+	}
+	SOC_TRACE(1, acalsim::top->getGlobalTick(), TraceStage::CPU, TraceEvent::MEM_WRITE, this->hartId, instPacket->pc,
+	          instPacket->inst.op);
+	this->sendMemReq(pkt, _addr, true, this->memWriteLatency);
 	return true;
 }
 
+bool CPU::memAtomic(const instr& _i, uint32_t _addr, uint32_t _data, InstPacket* instPacket) {
+	ASSERT_MSG(!this->soc->findDevice(_addr), "Atomic memory operations are not supported on device registers.");
+	auto callback = [this](MemReadRespPacket* _pkt) { _pkt->visit(acalsim::top->getGlobalTick(), *this); };
+
+	auto              rc  = acalsim::top->getRecycleContainer();
+	MemReadReqPacket* pkt = rc->acquire<MemReadReqPacket>(&MemReadReqPacket::renew, callback, _i, _i.op, _addr, _i.a1);
+	pkt->setPC(instPacket->pc);
+	pkt->setAtomic(_data, this->hartId);
+
+	if (_i.op == LR_W) {
+		this->lrCnt++;
+	} else if (_i.op == SC_W) {
+		this->scCnt++;
+	} else {
+		this->amoCnt++;
+	}
+
+	// Like a load, the atomic only blocks the instructions that use its result when there is a data cache
+	if (this->dcache) {
+		if (_i.a1.reg) this->pendingLoadRegs |= 1u << _i.a1.reg;
+	} else {
+		this->memInstPacket = instPacket;
+		this->memReqTick    = acalsim::top->getGlobalTick();
+	}
+
+	// An atomic performed at memory takes the line away from every data cache first
+	bool atMemory = this->dcache && this->atomicsAtMemory;
+	if (atMemory) this->dcache->releaseLine(acalsim::top->getGlobalTick(), _addr);
+
+	SOC_TRACE(1, acalsim::top->getGlobalTick(), TraceStage::CPU, TraceEvent::MEM_ATOMIC, this->hartId, instPacket->pc,
+	          instPacket->inst.op);
+	bool          isWrite = _i.op != LR_W;
+	acalsim::Tick latency = _i.op == SC_W ? this->memWriteLatency : this->memReadLatency;
+	this->sendMemReq(pkt, _addr, isWrite, latency, atMemory);
+	return true;
+}
+
+void CPU::sendMemReq(acalsim::SimPacket* _memReqPkt, uint32_t _addr, bool _isWrite, acalsim::Tick _latency,
+                     bool _uncached) {
+	const Bus::Target* target = this->bus->decode(_addr);
+
+	// The data cache models its own hit latency and the latency of its line fills
+	if (this->dcache && target && !target->device && !_uncached) {
+		visitMemoryTarget(acalsim::top->getGlobalTick(), *_memReqPkt, _isWrite, MemoryTarget::DataCache, *this->dcache);
+		return;
+	}
+
+	// A single-cycle access granted without bus latency completes in the same cycle as in the single-cycle
+	// CPU model. The CPU checks the outstanding limit before it issues a memory instruction.
+	bool sent = this->bus->send(acalsim::top->getGlobalTick(), this->busMaster, _memReqPkt, _addr, sizeof(uint32_t),
+	                            _isWrite, _latency);
+	ASSERT_MSG(sent, "The CPU has more bus requests in flight than the bus allows.");
+}
+
+void CPU::memReadRespHandler(acalsim::Tick _when, MemReadRespPacket* _memRespPkt) {
+	int reg = _memRespPkt->getA1().reg;
+	if (reg) this->rf[reg] = _memRespPkt->getData();
+	if (_memRespPkt->getOP() == SC_W && _memRespPkt->getData()) this->scFailures++;
+	acalsim::top->getRecycleContainer()->recycle(_memRespPkt);
+
+	if (!this->dcache) {
+		this->completeMemInstr(_when);
+		return;
+	}
+
+	// The load has been committed when it was issued. Release its destination register and
+	// resume the CPU if the stalled instruction does not wait for other loads.
+	this->memAccessCnt++;
+	this->pendingLoadRegs &= ~(1u << reg);
+	if (this->loadUseStalled && !(this->getRegMask(this->fetchInstr(this->pc)) & this->pendingLoadRegs)) {
+		this->loadUseStalled = false;
+		this->memStallCycles += _when + 1 - this->loadUseStallTick;
+		this->scheduleExecOneInstr(_when + 1);
+	}
+}
+
+void CPU::memWriteRespHandler(acalsim::Tick _when, MemWriteRespPacket* _memRespPkt) {
+	acalsim::top->getRecycleContainer()->recycle(_memRespPkt);
+
+	// Stores are posted to the data cache
+	if (this->dcache) {
+		this->memAccessCnt++;
+		return;
+	}
+	this->completeMemInstr(_when);
+}
+
+void CPU::scheduleExecOneInstr(acalsim::Tick _when) {
+	if (this->runAhead) {
+		this->runAheadNext = _when;
+		return;
+	}
+	auto               rc    = acalsim::top->getRecycleContainer();
+	ExecOneInstrEvent* event =
+	    rc->acquire<ExecOneInstrEvent>(&ExecOneInstrEvent::renew, this->getInstCount() /*id*/, this);
+	this->scheduleEvent(event, _when);
+}
+
+uint32_t CPU::getRegMask(const instr& _i) const {
+	uint32_t mask = 0;
+	switch (_i.op) {
+		// rd, rs1, rs2
+		case ADD:
+		case SUB:
+		case SLT:
+		case SLTU:
+		case AND:
+		case OR:
+		case XOR:
+		case SLL:
+		case SRL:
+		case SRA: mask = (1u << _i.a1.reg) | (1u << _i.a2.reg) | (1u << _i.a3.reg); break;
+
+		// rd, rs1
+		case ADDI:
+		case SLTI:
+		case SLTIU:
+		case ANDI:
+		case ORI:
+		case XORI:
+		case SLLI:
+		case SRLI:
+		case SRAI:
+		case JALR:
+		case LB:
+		case LBU:
+		case LH:
+		case LHU:
+		case LW:
+		case LR_W: mask = (1u << _i.a1.reg) | (1u << _i.a2.reg); break;
+
+		// rd, rs1 (address), rs2
+		case SC_W:
+		case AMOSWAP_W:
+		case AMOADD_W:
+		case AMOXOR_W:
+		case AMOAND_W:
+		case AMOOR_W:
+		case AMOMIN_W:
+		case AMOMAX_W:
+		case AMOMINU_W:
+		case AMOMAXU_W: mask = (1u << _i.a1.reg) | (1u << _i.a2.reg) | (1u << _i.a3.reg); break;
+
+		// rs2 (data), rs1 (base) / rs1, rs2
+		case SB:
+		case SH:
+		case SW:
+		case BEQ:
+		case BGE:
+		case BGEU:
+		case BLT:
+		case BLTU:
+		case BNE: mask = (1u << _i.a1.reg) | (1u << _i.a2.reg); break;
+
+		// rd
+		case JAL:
+		case AUIPC:
+		case LUI: mask = 1u << _i.a1.reg; break;
+
+		default: break;
+	}
+	return mask & ~1u;
+}
+
+bool CPU::isCoreLocal(const instr& _i) const {
+	if (this->isMemInstr(_i.op) || _i.op == HCF || _i.op == UNIMPL) return false;
+	if (this->getRegMask(_i) & this->pendingLoadRegs) return false;
+	return !(this->idleLoopSkip && this->idleLoop.candidate && this->pc == this->idleLoop.head);
+}
+
+bool CPU::isMemInstr(instr_type _op) const {
+	if (isAtomicOp(_op)) return true;
+	switch (_op) {
+		case LB:
+		case LBU:
+		case LH:
+		case LHU:
+		case LW:
+		case SB:
+		case SH:
+		case SW: return true;
+		default: return false;
+	}
+}
+
+void CPU::completeMemInstr(acalsim::Tick _when) {
+	InstPacket* instPacket = this->memInstPacket;
+	ASSERT_MSG(instPacket, "Received a memory response without an outstanding memory instruction.");
+	this->memInstPacket = nullptr;
+
+	this->memAccessCnt++;
+	this->memStallCycles += _when - this->memReqTick;
+	SOC_TRACE(1, _when, TraceStage::CPU, TraceEvent::MEM_RESP, this->hartId, instPacket->pc, instPacket->inst.op,
+	          _when - this->memReqTick);
+
+	// Memory instructions never redirect the control flow
+	this->commitInstr(instPacket->inst, instPacket);
+	this->pc += 4;
+}
+
 void CPU::printRegfile() const {
 	std::ostringstream oss;
 
@@ -232,12 +578,165 @@ void CPU::printRegfile() const {
 	CLASS_INFO << oss.str();
 }
 
+void CPU::trackIdleLoop(const instr& _i) {
+	auto&         loop = this->idleLoop;
+	acalsim::Tick now  = this->getLocalTick();
+
+	if (loop.candidate && this->pc == loop.head) {
+		// Start observing a new iteration
+		loop.iterValid   = true;
+		loop.iterPure    = true;
+		loop.iterStart   = now;
+		loop.pollOffset  = 0;
+		loop.instCnt     = this->inst_cnt;
+		loop.memAccesses = this->memAccessCnt;
+		loop.memStalls   = this->memStallCycles;
+		loop.devices.clear();
+		std::copy(std::begin(this->rf), std::end(this->rf), std::begin(loop.rf));
+	} else if (!loop.candidate || this->pc < loop.head || this->pc > loop.tail) {
+		loop.iterValid = false;
+		loop.period    = 0;
+	}
+	if (!loop.iterValid) return;
+
+	switch (_i.op) {
+		case LB:
+		case LBU:
+		case LH:
+		case LHU:
+		case LW: {
+			MMIODevice* device = this->soc->findDevice(this->rf[_i.a2.reg] + _i.a3.imm);
+			if (!device) {
+				// Plain memory may be changed by devices at any time
+				loop.iterPure = false;
+				break;
+			}
+			if (std::find(loop.devices.begin(), loop.devices.end(), device) == loop.devices.end()) {
+				loop.devices.push_back(device);
+			}
+			acalsim::Tick latency  = this->bus->getHopLatency() + std::max<acalsim::Tick>(this->memReadLatency, 1);
+			acalsim::Tick readTick = now + latency - 1;
+			loop.pollOffset        = std::max(loop.pollOffset, readTick - loop.iterStart);
+			break;
+		}
+		case SB:
+		case SH:
+		case SW:
+		case HCF:
+		case UNIMPL: loop.iterPure = false; break;
+		default:
+			if (isAtomicOp(_i.op)) loop.iterPure = false;
+			break;
+	}
+}
+
+void CPU::updateIdleLoopCandidate(uint32_t _pc, uint32_t _target) {
+	auto& loop = this->idleLoop;
+	if (loop.candidate && loop.head == _target && loop.tail == _pc) return;
+
+	loop.candidate = true;
+	loop.head      = _target;
+	loop.tail      = _pc;
+	loop.iterValid = false;
+	loop.period    = 0;
+}
+
+bool CPU::skipIdleLoop() {
+	auto& loop = this->idleLoop;
+	if (!loop.iterValid || this->pc != loop.head) return false;
+
+	// The previous iteration has just completed. It repeats itself until a device changes if it
+	// only polled devices and ended with the register file it started with.
+	acalsim::Tick now    = acalsim::top->getGlobalTick();
+	acalsim::Tick period = now - loop.iterStart;
+
+	bool fixedPoint = loop.iterPure && !loop.devices.empty() && !this->pendingLoadRegs &&
+	                  std::equal(std::begin(this->rf), std::end(this->rf), std::begin(loop.rf));
+	bool steady     = fixedPoint && period == loop.period;
+	loop.period     = fixedPoint ? period : 0;
+	if (!steady) return false;
+
+	// Skipped polls would no longer compete with the devices and the other cores for the bus
+	if (this->soc->hasBusTraffic(this)) return false;
+
+	acalsim::Tick next = 0;
+	for (auto device : loop.devices) {
+		acalsim::Tick tick = device->getNextStatusChangeTick(now);
+		// Nothing is going to change the polled registers, keep spinning
+		if (!tick) return false;
+		next = next ? std::min(next, tick) : tick;
+	}
+
+	// The m-th upcoming iteration reads the devices at now + m * period + pollOffset. Every iteration
+	// that reads them before the next state change behaves exactly like the previous one.
+	if (next <= now + loop.pollOffset) return false;
+	uint64_t iterations = (next - now - loop.pollOffset + period - 1) / period;
+	uint64_t iterInsts  = this->inst_cnt - loop.instCnt;
+
+	this->inst_cnt += iterations * iterInsts;
+	this->memAccessCnt += iterations * (this->memAccessCnt - loop.memAccesses);
+	this->skippedMemStalls += iterations * (this->memStallCycles - loop.memStalls);
+	this->memStallCycles += iterations * (this->memStallCycles - loop.memStalls);
+	this->idleLoopSkips++;
+	this->skippedIterations += iterations;
+	this->skippedInstrs += iterations * iterInsts;
+	this->skippedCycles += iterations * period;
+	if (this->profiler) this->profiler->skip(iterations * period);
+	CLASS_INFO << "Skip " << iterations << " iterations of the polling loop @ PC=" << loop.head << " ("
+	           << iterations * period << " cycles)";
+
+	// Measure the loop again once it resumes
+	loop.iterValid = false;
+	loop.period    = 0;
+	this->scheduleExecOneInstr(now + iterations * period);
+	return true;
+}
+
+void CPU::printStats() const {
+	CLASS_INFO << "Memory accesses: " << this->memAccessCnt << " | Memory stall cycles: " << this->memStallCycles;
+	if (this->idleLoopSkip) {
+		CLASS_INFO << "Idle loops: " << this->idleLoopSkips << " fast-forwards | " << this->skippedIterations
+		           << " iterations, " << this->skippedInstrs << " instructions and " << this->skippedCycles
+		           << " cycles skipped";
+	}
+	if (this->quantum > 1) {
+		double perEvent = this->runAheadEvents ? (double)this->runAheadInstrs / this->runAheadEvents : 0.0;
+		CLASS_INFO << "Run-ahead: " << this->runAheadInstrs << " instructions executed ahead of the global tick in "
+		           << this->runAheadEvents << " events (" << perEvent << " per event)";
+	}
+	if (this->amoCnt || this->lrCnt || this->scCnt) {
+		double retryRate = this->scCnt ? 100.0 * this->scFailures / this->scCnt : 0.0;
+		CLASS_INFO << "Atomics: " << this->amoCnt << " AMOs, " << this->lrCnt << " LR, " << this->scCnt << " SC ("
+		           << this->scFailures << " failed, retry rate " << retryRate << "%)";
+	}
+}
+
+void CPU::addIntervalStats(IntervalStats& _stats, const std::string& _prefix) const {
+	_stats.addCounter(_prefix + "instructions", [this] { return (uint64_t)this->inst_cnt; });
+	_stats.addCounter(_prefix + "mem_accesses", [this] { return this->memAccessCnt; });
+	_stats.addCounter(_prefix + "mem_stall_cycles", [this] { return this->memStallCycles; });
+	_stats.addRatio(_prefix + "ipc", _prefix + "instructions", "cycles");
+}
+
+void CPU::accountCycles(CycleStack& _stack) const {
+	_stack.cycles       = this->halted ? this->haltTick : acalsim::top->getGlobalTick();
+	_stack.instructions = this->inst_cnt;
+	// The skipped iterations are accounted as idle cycles as a whole
+	_stack.memory = this->memStallCycles - this->skippedMemStalls;
+	_stack.idle   = this->skippedCycles;
+}
+
+PCProfiler* CPU::finishProfile() {
+	if (this->profiler) this->profiler->finish(this->halted ? this->haltTick + 1 : acalsim::top->getGlobalTick());
+	return this->profiler;
+}
+
 instr CPU::fetchInstr(uint32_t _pc) const {
 	uint32_t iid = _pc / 4;
 	return this->imem[iid];
 }
 
-std::string CPU::instrToString(instr_type _op) const {
+std::string CPU::instrToString(instr_type _op) {
 	switch (_op) {
 		case UNIMPL: return "UNIMPL";
 
@@ -292,6 +791,19 @@ std::string CPU::instrToString(instr_type _op) const {
 		case AUIPC: return "AUIPC";
 		case LUI: return "LUI";
 
+		// Atomic
+		case LR_W: return "LR.W";
+		case SC_W: return "SC.W";
+		case AMOSWAP_W: return "AMOSWAP.W";
+		case AMOADD_W: return "AMOADD.W";
+		case AMOXOR_W: return "AMOXOR.W";
+		case AMOAND_W: return "AMOAND.W";
+		case AMOOR_W: return "AMOOR.W";
+		case AMOMIN_W: return "AMOMIN.W";
+		case AMOMAX_W: return "AMOMAX.W";
+		case AMOMINU_W: return "AMOMINU.W";
+		case AMOMAXU_W: return "AMOMAXU.W";
+
 		// Special
 		case HCF: return "HCF";
 
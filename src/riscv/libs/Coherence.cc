@@ -0,0 +1,88 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Coherence.hh"
+
+#include <algorithm>
+
+#include "DataCache.hh"
+
+Coherence::Coherence(const std::string& _protocol) {
+	if (_protocol == "msi") {
+		this->protocol = Protocol::MSI;
+	} else {
+		ASSERT_MSG(_protocol == "mesi", "Unknown coherence protocol, expected \"msi\" or \"mesi\".");
+		this->protocol = Protocol::MESI;
+	}
+}
+
+uint32_t Coherence::addCache(DataCache* _cache) {
+	this->caches.push_back(_cache);
+	return this->caches.size() - 1;
+}
+
+bool Coherence::snoop(acalsim::Tick _when, uint32_t _requester, Request _req, uint32_t _lineAddr,
+                      uint64_t _writeMask) {
+	LineStats& stats = this->lineStats[_lineAddr];
+	bool       found = false;
+
+	this->requests[_req]++;
+	stats.transactions++;
+	for (uint32_t id = 0; id < this->caches.size(); id++) {
+		if (id == _requester) continue;
+
+		SnoopResult result = this->caches[id]->snoop(_when, _req, _lineAddr, _writeMask);
+		found |= result.hadCopy;
+		this->flushes += result.flushed;
+		this->invalidations += result.invalidated;
+		this->falseSharing += result.falseSharing;
+		stats.invalidations += result.invalidated;
+		stats.falseSharing += result.falseSharing;
+	}
+	this->snoopHits += found;
+
+	// Only a read leaves the other copies in place
+	return found && _req == READ;
+}
+
+void Coherence::printStats() const {
+	static constexpr size_t kTopLines = 8;
+
+	uint64_t transactions = this->requests[READ] + this->requests[READ_EXCLUSIVE] + this->requests[UPGRADE];
+	CLASS_INFO << "Coherence (" << (this->protocol == Protocol::MSI ? "MSI" : "MESI") << ", " << this->caches.size()
+	           << " caches): " << transactions << " transactions (" << this->requests[READ] << " BusRd, "
+	           << this->requests[READ_EXCLUSIVE] << " BusRdX, " << this->requests[UPGRADE] << " BusUpgr) | "
+	           << this->snoopHits << " snoop hits, " << this->flushes << " flushes";
+	CLASS_INFO << "Coherence: " << this->invalidations << " invalidations (" << this->falseSharing
+	           << " false sharing) over " << this->lineStats.size() << " lines";
+
+	// Lines ranked by invalidations, the ones that ping-pong between the caches come first
+	std::vector<std::pair<uint32_t, LineStats>> ranked;
+	for (const auto& entry : this->lineStats) {
+		if (entry.second.invalidations) ranked.push_back(entry);
+	}
+	size_t top = std::min(ranked.size(), kTopLines);
+	std::partial_sort(ranked.begin(), ranked.begin() + top, ranked.end(), [](const auto& a, const auto& b) {
+		if (a.second.invalidations != b.second.invalidations) return a.second.invalidations > b.second.invalidations;
+		return a.first < b.first;
+	});
+	for (size_t k = 0; k < top; k++) {
+		const auto& [lineAddr, stats] = ranked[k];
+		CLASS_INFO << "Coherence line 0x" << std::hex << lineAddr << std::dec << ": " << stats.transactions
+		           << " transactions, " << stats.invalidations << " invalidations, " << stats.falseSharing
+		           << " false sharing";
+	}
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CommandScoreboard.hh"
+
+#include <algorithm>
+
+#include "MMIODevice.hh"
+
+namespace {
+
+bool overlaps(const std::vector<CommandScoreboard::Range>& _a, const std::vector<CommandScoreboard::Range>& _b) {
+	for (const auto& a : _a) {
+		for (const auto& b : _b) {
+			if ((uint64_t)a.addr < (uint64_t)b.addr + b.bytes && (uint64_t)b.addr < (uint64_t)a.addr + a.bytes) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+}  // namespace
+
+void CommandScoreboard::addDevice(MMIODevice* _device) {
+	DeviceStats stats;
+	stats.device = _device;
+	this->devices.push_back(stats);
+}
+
+uint64_t CommandScoreboard::submit(MMIODevice* _device, Footprint _footprint, acalsim::Tick _when) {
+	uint64_t id        = this->nextId++;
+	this->commands[id] = Command{_device, std::move(_footprint), _when, false};
+	this->getStats(_device).commands++;
+	return id;
+}
+
+bool CommandScoreboard::isReady(uint64_t _id) const {
+	const Command& cmd = this->commands.at(_id);
+	for (auto it = this->commands.begin(); it != this->commands.end() && it->first < _id; ++it) {
+		if (conflicts(it->second.footprint, cmd.footprint)) return false;
+	}
+	return true;
+}
+
+bool CommandScoreboard::conflicts(const Footprint& _older, const Footprint& _younger) {
+	return overlaps(_older.writes, _younger.reads) || overlaps(_older.writes, _younger.writes) ||
+	       overlaps(_older.reads, _younger.writes);
+}
+
+void CommandScoreboard::start(uint64_t _id, acalsim::Tick _when) {
+	this->accumulate(_when);
+
+	Command& cmd = this->commands.at(_id);
+	cmd.running  = true;
+
+	DeviceStats& stats = this->getStats(cmd.device);
+	stats.running      = true;
+	stats.waiting += _when - cmd.submitTick;
+}
+
+void CommandScoreboard::complete(uint64_t _id, acalsim::Tick _when) {
+	this->accumulate(_when);
+
+	auto it = this->commands.find(_id);
+	this->getStats(it->second.device).running = false;
+	this->commands.erase(it);
+
+	// Completing a command may unblock younger commands on any device, including its own
+	for (auto& stats : this->devices) { stats.device->issueCommands(_when); }
+}
+
+acalsim::Tick CommandScoreboard::getNextCompletionTick(acalsim::Tick _when) const {
+	acalsim::Tick next = 0;
+	for (const auto& stats : this->devices) {
+		if (!stats.running) continue;
+		acalsim::Tick tick = stats.device->getNextStatusChangeTick(_when);
+		if (tick && (!next || tick < next)) next = tick;
+	}
+	return next;
+}
+
+void CommandScoreboard::accumulate(acalsim::Tick _when) {
+	acalsim::Tick elapsed = _when - this->lastTick;
+	this->lastTick        = _when;
+	if (!elapsed) return;
+
+	int running = std::count_if(this->devices.begin(), this->devices.end(), [](const auto& s) { return s.running; });
+	if (running) this->anyBusy += elapsed;
+	for (auto& stats : this->devices) {
+		if (!stats.running) continue;
+		stats.busy += elapsed;
+		if (running > 1) stats.overlapped += elapsed;
+	}
+}
+
+CommandScoreboard::DeviceStats& CommandScoreboard::getStats(MMIODevice* _device) {
+	auto it = std::find_if(this->devices.begin(), this->devices.end(),
+	                       [_device](const auto& s) { return s.device == _device; });
+	ASSERT_MSG(it != this->devices.end(), "The device is not registered to the command scoreboard.");
+	return *it;
+}
+
+void CommandScoreboard::printStats() const {
+	acalsim::Tick serialized = 0;
+	acalsim::Tick longest    = 0;
+	for (const auto& stats : this->devices) {
+		if (!stats.commands) continue;
+		double overlap = stats.busy ? 100.0 * stats.overlapped / stats.busy : 0.0;
+		CLASS_INFO << "Accelerator " << stats.device->getName() << ": " << stats.commands << " commands | "
+		           << stats.busy << " busy cycles, " << overlap << "% overlapped with other devices | "
+		           << stats.waiting << " cycles queued";
+		serialized += stats.busy;
+		longest = std::max(longest, stats.busy);
+	}
+	if (!serialized) return;
+
+	// The hidden cycles relative to the most that could be hidden behind the busiest device
+	acalsim::Tick hidden     = serialized - this->anyBusy;
+	double        efficiency = serialized > longest ? 100.0 * hidden / (serialized - longest) : 0.0;
+	CLASS_INFO << "Accelerator overlap: " << this->anyBusy << " busy cycles vs " << serialized
+	           << " serialized | " << hidden << " cycles hidden | overlap efficiency " << efficiency << "%";
+}
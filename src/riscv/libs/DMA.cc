@@ -0,0 +1,446 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DMA.hh"
+
+#include <algorithm>
+#include <cstring>
+
+#include "event/DMAEvent.hh"
+
+DMA::DMA(std::string _name, uint32_t _baseAddr) : MMIODevice(_name, _baseAddr, 0x100) {
+	this->busWidth      = acalsim::top->getParameter<int>("DMA", "bus_width");
+	this->maxBurstBeats = acalsim::top->getParameter<int>("DMA", "max_burst_beats");
+	this->burstLatency  = acalsim::top->getParameter<acalsim::Tick>("DMA", "burst_latency");
+	ASSERT_MSG(this->busWidth > 0 && this->maxBurstBeats > 0, "The DMA bus must transfer at least one byte per burst.");
+	this->queueDepth    = acalsim::top->getParameter<int>("DMA", "queue_depth");
+	this->setTimingModel(acalsim::top->getParameter<std::string>("DMA", "timing_model"));
+}
+
+uint32_t DMA::readReg(acalsim::Tick _when, uint32_t _offset) {
+	switch (_offset) {
+		case CTRL: return this->ctrl;
+		case SRC: return this->src;
+		case DST: return this->dst;
+		case CFG: return this->cfg;
+		case DESC: return this->desc;
+		case STATUS: return this->status;
+		case DONE_CNT: return this->doneCnt;
+		default: return 0;
+	}
+}
+
+void DMA::writeReg(acalsim::Tick _when, uint32_t _offset, uint32_t _data) {
+	switch (_offset) {
+		case CTRL:
+			this->ctrl = _data & ~CTRL_START;
+			if (_data & CTRL_START) this->submit(_when);
+			break;
+		case SRC: this->src = _data; break;
+		case DST: this->dst = _data; break;
+		case CFG: this->cfg = _data; break;
+		case DESC: this->desc = _data; break;
+		case STATUS:
+			// Software acknowledges a completed transfer by clearing the done bit
+			this->status &= _data | STATUS_BUSY | STATUS_QUEUE_FULL;
+			break;
+		default: CLASS_ERROR << "Write to an undefined DMA register at offset " << _offset; break;
+	}
+}
+
+void DMA::submit(acalsim::Tick _when) {
+	if (this->queue.size() >= this->queueDepth) {
+		CLASS_ERROR << "The DMA command queue is full, the start command is ignored.";
+		return;
+	}
+
+	Command                      command{0, this->ctrl, this->src, this->dst, this->cfg, this->desc};
+	CommandScoreboard::Footprint footprint;
+	if (!this->getFootprint(command, footprint)) {
+		// A rejected command completes right away so that software waiting for it does not hang
+		CLASS_ERROR << "The DMA descriptor chain does not end within " << kMaxDescriptors << " descriptors.";
+		this->status |= STATUS_DONE | STATUS_ERROR;
+		this->doneCnt++;
+		return;
+	}
+
+	command.id = this->getScoreboard()->submit(this, footprint, _when);
+	this->queue.push_back(command);
+	this->issueCommands(_when);
+	this->updateStatus();
+}
+
+void DMA::issueCommands(acalsim::Tick _when) {
+	if (this->running || this->queue.empty() || !this->getScoreboard()->isReady(this->queue.front().id)) return;
+
+	this->cmd     = this->queue.front();
+	this->running = true;
+	this->queue.pop_front();
+	this->getScoreboard()->start(this->cmd.id, _when);
+	this->start(_when);
+	this->updateStatus();
+}
+
+bool DMA::getFootprint(const Command& _cmd, CommandScoreboard::Footprint& _footprint) const {
+	auto addTransfer = [&_footprint](uint32_t _src, uint32_t _dst, uint32_t _cfg) {
+		uint32_t width  = ((_cfg >> 8) & 0xff) + 1;
+		uint32_t height = _cfg & 0xff;
+		_footprint.reads.push_back({_src, height * ((_cfg >> 24) & 0xff) + width});
+		_footprint.writes.push_back({_dst, height * ((_cfg >> 16) & 0xff) + width});
+	};
+
+	if (!(_cmd.ctrl & CTRL_DESC_MODE)) {
+		addTransfer(_cmd.src, _cmd.dst, _cmd.cfg);
+		return true;
+	}
+
+	// Software builds the descriptor chain before it starts the command
+	return this->walkChain(_cmd.desc, [&](uint32_t _addr, const uint32_t* _words) {
+		_footprint.reads.push_back({_addr, 4 * sizeof(uint32_t)});
+		addTransfer(_words[0], _words[1], _words[2]);
+	});
+}
+
+bool DMA::walkChain(uint32_t _desc, const std::function<void(uint32_t, const uint32_t*)>& _visit) const {
+	uint32_t length = 0;
+	for (uint32_t addr = _desc; addr; length++) {
+		if (length == kMaxDescriptors) return false;
+
+		// The visit may overwrite the descriptor, e.g. a transfer copied over its own chain
+		uint32_t words[4];
+		std::memcpy(words, this->translate(addr, sizeof(words)), sizeof(words));
+		_visit(addr, words);
+		addr = words[3];
+	}
+	return true;
+}
+
+void DMA::updateStatus() {
+	this->status &= ~(STATUS_BUSY | STATUS_QUEUE_FULL);
+	if (this->running || !this->queue.empty()) this->status |= STATUS_BUSY;
+	if (this->queue.size() >= this->queueDepth) this->status |= STATUS_QUEUE_FULL;
+}
+
+void DMA::start(acalsim::Tick _when) {
+	this->startTick = _when;
+	this->transfers++;
+
+	this->chainLength = 0;
+
+	// The chain may have been rewritten since the command was queued
+	if (this->getTimingModel() != TimingModel::CYCLE && !this->estimateCommand(this->estimate)) {
+		CLASS_ERROR << "The DMA descriptor chain does not end within " << kMaxDescriptors << " descriptors.";
+		this->finish(_when, true);
+		return;
+	}
+	if (this->getTimingModel() == TimingModel::ANALYTICAL) {
+		this->phaseEndTick = _when + this->estimate;
+		this->schedule(this->phaseEndTick);
+		return;
+	}
+
+	if (this->cmd.ctrl & CTRL_DESC_MODE) {
+		this->fetchDescriptor(_when, this->cmd.desc);
+	} else {
+		this->loadTransfer(this->cmd.src, this->cmd.dst, this->cmd.cfg, 0);
+		this->issueBurst(_when);
+	}
+}
+
+void DMA::fetchDescriptor(acalsim::Tick _when, uint32_t _addr) {
+	this->fetchingDesc = true;
+	this->descAddr     = _addr;
+	this->burstEnd     = _when + this->burstLatency + this->getBeats(_addr, 4 * sizeof(uint32_t));
+
+	// Descriptors placed in the scratchpad also wait for its banks
+	acalsim::Tick spmEnd = this->accessScratchpad(_when, _addr, 4 * sizeof(uint32_t), false);
+	this->burstEnd       = std::max(this->burstEnd, spmEnd);
+	this->phaseEndTick   = this->burstEnd;
+
+	this->requestBus(_addr, 4 * sizeof(uint32_t), false);
+	this->requestDRAM(_when, _addr, 4 * sizeof(uint32_t), false);
+	this->sendBusRequests(_when);
+}
+
+void DMA::loadTransfer(uint32_t _src, uint32_t _dst, uint32_t _cfg, uint32_t _next) {
+	this->xfer           = Transfer();
+	this->xfer.src       = _src;
+	this->xfer.dst       = _dst;
+	this->xfer.srcStride = (_cfg >> 24) & 0xff;
+	this->xfer.dstStride = (_cfg >> 16) & 0xff;
+	this->xfer.width     = ((_cfg >> 8) & 0xff) + 1;
+	this->xfer.height    = (_cfg & 0xff) + 1;
+	this->xfer.next      = _next;
+}
+
+void DMA::issueBurst(acalsim::Tick _when) {
+	uint32_t srcAddr = this->xfer.src + this->xfer.row * this->xfer.srcStride + this->xfer.offset;
+	uint32_t dstAddr = this->xfer.dst + this->xfer.row * this->xfer.dstStride + this->xfer.offset;
+	this->burstBytes = this->getBurstBytes(this->xfer);
+
+	// The read and write channels stream concurrently, the slower side sets the burst length
+	uint32_t beats = std::max(this->getBeats(srcAddr, this->burstBytes), this->getBeats(dstAddr, this->burstBytes));
+	this->bursts++;
+	this->beats += beats;
+
+	// The bus timing of the whole transfer is computed when its first burst is issued
+	if (!this->xfer.row && !this->xfer.offset) {
+		Transfer      probe = this->xfer;
+		acalsim::Tick end   = 0;
+		while (probe.row < probe.height) {
+			uint32_t n = this->getBurstBytes(probe);
+			uint32_t s = probe.src + probe.row * probe.srcStride + probe.offset;
+			uint32_t d = probe.dst + probe.row * probe.dstStride + probe.offset;
+			end += this->burstLatency + std::max(this->getBeats(s, n), this->getBeats(d, n));
+			probe.offset += n;
+			if (probe.offset == probe.width) {
+				probe.offset = 0;
+				probe.row++;
+			}
+		}
+		this->remainingCycles = end;
+	}
+
+	// Scratchpad bank conflicts may hold the burst beyond the bus timing. The bursts left keep their
+	// bus timing, which makes the end of the transfer a lower bound until its last burst is issued.
+	acalsim::Tick busCycles = this->burstLatency + beats;
+	acalsim::Tick spmRead   = this->accessScratchpad(_when, srcAddr, this->burstBytes, false);
+	acalsim::Tick spmWrite  = this->accessScratchpad(_when, dstAddr, this->burstBytes, true);
+	this->burstEnd          = std::max({_when + busCycles, spmRead, spmWrite});
+
+	this->remainingCycles -= busCycles;
+	this->phaseEndTick = this->burstEnd + this->remainingCycles;
+
+	// The read and the write side may wait for the system bus and the DRAM as well
+	this->requestBus(srcAddr, this->burstBytes, false);
+	this->requestBus(dstAddr, this->burstBytes, true);
+	this->requestDRAM(_when, srcAddr, this->burstBytes, false);
+	this->requestDRAM(_when, dstAddr, this->burstBytes, true);
+	this->sendBusRequests(_when);
+}
+
+void DMA::requestBus(uint32_t _addr, uint32_t _bytes, bool _isWrite) {
+	const Bus::Target* target = this->getBus() ? this->getBus()->decode(_addr) : nullptr;
+	if (target && !target->device) this->busRequests.push_back(BusRequest{_addr, _bytes, _isWrite});
+}
+
+void DMA::requestDRAM(acalsim::Tick _when, uint32_t _addr, uint32_t _bytes, bool _isWrite) {
+	if (!this->dmem || !this->dmem->hasDRAM() || _addr >= this->dmem->getSize()) return;
+
+	// DRAM completions lie after the issue tick, so the phase cannot end before its bus transfers are sent
+	this->dramPending++;
+	this->dmem->accessDRAM(_when, _addr, _bytes, _isWrite,
+	                       [this]() { this->dramCompleted(acalsim::top->getGlobalTick()); });
+}
+
+void DMA::sendBusRequests(acalsim::Tick _when) {
+	if (this->busRequests.empty() && !this->busPending) {
+		// The last DRAM access of the phase ends it otherwise
+		if (!this->dramPending) this->endPhase();
+		return;
+	}
+
+	while (!this->busRequests.empty()) {
+		// A transfer may be granted right away, so it leaves the queue before it is sent
+		BusRequest req = this->busRequests.front();
+		this->busRequests.pop_front();
+		this->busPending++;
+		if (!this->getBus()->transfer(_when, this->getBusMaster(), req.addr, req.bytes, req.isWrite,
+		                              [this](acalsim::Tick _done) { this->busGranted(_done); })) {
+			// The bus calls retryBusRequests() once a transfer of the engine retires
+			this->busPending--;
+			this->busRequests.push_front(req);
+			return;
+		}
+	}
+}
+
+void DMA::retryBusRequests(acalsim::Tick _when) {
+	if (!this->busRequests.empty()) this->sendBusRequests(_when);
+}
+
+void DMA::busGranted(acalsim::Tick _done) {
+	this->busPending--;
+	this->burstEnd = std::max(this->burstEnd, _done);
+	if (!this->busPending && this->busRequests.empty() && !this->dramPending) this->endPhase();
+}
+
+void DMA::dramCompleted(acalsim::Tick _done) {
+	this->dramPending--;
+	this->burstEnd = std::max(this->burstEnd, _done);
+	if (!this->busPending && this->busRequests.empty() && !this->dramPending) this->endPhase();
+}
+
+void DMA::endPhase() {
+	// Bus contention only moves the end of the transfer, the bursts left keep their own timing
+	this->phaseEndTick = this->burstEnd + (this->fetchingDesc ? 0 : this->remainingCycles);
+	this->schedule(this->burstEnd);
+}
+
+void DMA::advance(acalsim::Tick _when) {
+	if (this->getTimingModel() == TimingModel::ANALYTICAL) {
+		bool copied = this->copyCommand();
+		if (!copied) CLASS_ERROR << "The DMA descriptor chain grows past " << kMaxDescriptors << " descriptors.";
+		this->finish(_when, !copied);
+		return;
+	}
+
+	if (this->fetchingDesc) {
+		auto words         = (const uint32_t*)this->translate(this->descAddr, 4 * sizeof(uint32_t));
+		this->fetchingDesc = false;
+		this->descriptors++;
+		this->chainLength++;
+		this->loadTransfer(words[0], words[1], words[2], words[3]);
+		this->issueBurst(_when);
+		return;
+	}
+
+	uint32_t srcAddr = this->xfer.src + this->xfer.row * this->xfer.srcStride + this->xfer.offset;
+	uint32_t dstAddr = this->xfer.dst + this->xfer.row * this->xfer.dstStride + this->xfer.offset;
+	std::memmove(this->translate(dstAddr, this->burstBytes), this->translate(srcAddr, this->burstBytes),
+	             this->burstBytes);
+	this->bytes += this->burstBytes;
+
+	this->xfer.offset += this->burstBytes;
+	if (this->xfer.offset == this->xfer.width) {
+		this->xfer.offset = 0;
+		this->xfer.row++;
+	}
+
+	if (this->xfer.row < this->xfer.height) {
+		this->issueBurst(_when);
+	} else if ((this->cmd.ctrl & CTRL_DESC_MODE) && this->xfer.next && this->chainLength == kMaxDescriptors) {
+		// The transfers rewrote the chain into one that does not end
+		CLASS_ERROR << "The DMA descriptor chain grows past " << kMaxDescriptors << " descriptors.";
+		this->finish(_when, true);
+	} else if ((this->cmd.ctrl & CTRL_DESC_MODE) && this->xfer.next) {
+		this->fetchDescriptor(_when, this->xfer.next);
+	} else {
+		this->finish(_when);
+	}
+}
+
+void DMA::finish(acalsim::Tick _when, bool _failed) {
+	this->running = false;
+	this->doneCnt++;
+	this->status |= _failed ? STATUS_DONE | STATUS_ERROR : STATUS_DONE;
+	this->updateStatus();
+	this->busyCycles += _when - this->startTick;
+	if (this->getTimingModel() == TimingModel::VALIDATE && !_failed) {
+		this->recordValidation(this->estimate, _when - this->startTick);
+	}
+	CLASS_INFO << "DMA transfer completes at Tick = " << _when;
+
+	if (this->cmd.ctrl & CTRL_IRQ_EN) {
+		this->interrupts++;
+		this->raiseInterrupt();
+	}
+
+	// Lets this and the other devices start the commands waiting for this one
+	this->getScoreboard()->complete(this->cmd.id, _when);
+}
+
+acalsim::Tick DMA::getNextStatusChangeTick(acalsim::Tick _when) const {
+	// In descriptor mode this is the end of the current descriptor, a lower bound of the completion
+	if (this->running) return this->phaseEndTick;
+
+	// A queued command waits for a running command of another device
+	return this->queue.empty() ? 0 : this->getScoreboard()->getNextCompletionTick(_when);
+}
+
+uint32_t DMA::getBurstBytes(const Transfer& _xfer) const {
+	uint32_t srcAddr  = _xfer.src + _xfer.row * _xfer.srcStride + _xfer.offset;
+	uint32_t maxBytes = this->maxBurstBeats * this->busWidth - srcAddr % this->busWidth;
+	return std::min(_xfer.width - _xfer.offset, maxBytes);
+}
+
+uint32_t DMA::getBeats(uint32_t _addr, uint32_t _bytes) const {
+	return (_addr % this->busWidth + _bytes + this->busWidth - 1) / this->busWidth;
+}
+
+bool DMA::estimateCommand(acalsim::Tick& _cycles) const {
+	if (!(this->cmd.ctrl & CTRL_DESC_MODE)) {
+		_cycles = this->estimateTransfer(this->cmd.cfg);
+		return true;
+	}
+
+	acalsim::Tick fetchTime = this->burstLatency + (4 * sizeof(uint32_t) + this->busWidth - 1) / this->busWidth;
+	_cycles                 = 0;
+	return this->walkChain(this->cmd.desc, [&](uint32_t _addr, const uint32_t* _words) {
+		_cycles += fetchTime + this->estimateTransfer(_words[2]);
+	});
+}
+
+acalsim::Tick DMA::estimateTransfer(uint32_t _cfg) const {
+	uint32_t width        = ((_cfg >> 8) & 0xff) + 1;
+	uint32_t height       = (_cfg & 0xff) + 1;
+	uint32_t maxBytes     = this->maxBurstBeats * this->busWidth;
+	uint32_t burstsPerRow = (width + maxBytes - 1) / maxBytes;
+	uint32_t beatsPerRow  = (width + this->busWidth - 1) / this->busWidth;
+	return (acalsim::Tick)height * (burstsPerRow * this->burstLatency + beatsPerRow);
+}
+
+bool DMA::copyCommand() {
+	if (!(this->cmd.ctrl & CTRL_DESC_MODE)) {
+		this->copyTransfer(this->cmd.src, this->cmd.dst, this->cmd.cfg);
+		return true;
+	}
+
+	// walkChain() reads every descriptor out before its transfer may overwrite it
+	return this->walkChain(this->cmd.desc, [this](uint32_t _addr, const uint32_t* _words) {
+		this->descriptors++;
+		this->copyTransfer(_words[0], _words[1], _words[2]);
+	});
+}
+
+void DMA::copyTransfer(uint32_t _src, uint32_t _dst, uint32_t _cfg) {
+	this->loadTransfer(_src, _dst, _cfg, 0);
+	for (uint32_t row = 0; row < this->xfer.height; row++) {
+		uint32_t srcAddr = this->xfer.src + row * this->xfer.srcStride;
+		uint32_t dstAddr = this->xfer.dst + row * this->xfer.dstStride;
+		std::memmove(this->translate(dstAddr, this->xfer.width), this->translate(srcAddr, this->xfer.width),
+		             this->xfer.width);
+	}
+	this->bytes += this->xfer.width * this->xfer.height;
+
+	// Bus statistics follow the aligned-row assumption of estimateTransfer()
+	uint32_t maxBytes = this->maxBurstBeats * this->busWidth;
+	this->bursts += this->xfer.height * ((this->xfer.width + maxBytes - 1) / maxBytes);
+	this->beats += this->xfer.height * ((this->xfer.width + this->busWidth - 1) / this->busWidth);
+}
+
+void DMA::schedule(acalsim::Tick _when) {
+	auto      rc    = acalsim::top->getRecycleContainer();
+	DMAEvent* event = rc->acquire<DMAEvent>(&DMAEvent::renew, this);
+	this->scheduleEvent(event, _when);
+}
+
+void DMA::printStats() const {
+	double efficiency = this->beats ? 100.0 * this->bytes / (this->beats * this->busWidth) : 0.0;
+	double throughput = this->busyCycles ? (double)this->bytes / this->busyCycles : 0.0;
+
+	CLASS_INFO << "DMA: " << this->transfers << " transfers (" << this->descriptors << " descriptors) | " << this->bytes
+	           << " bytes in " << this->bursts << " bursts, " << this->beats << " beats";
+	CLASS_INFO << "DMA: " << this->busyCycles << " busy cycles | " << throughput << " bytes/cycle | bus efficiency "
+	           << efficiency << "% | " << this->interrupts << " interrupts";
+	this->printValidationStats();
+}
+
+void DMA::addIntervalStats(IntervalStats& _stats, const std::string& _prefix) const {
+	_stats.addCounter(_prefix + "bytes", [this] { return this->bytes; });
+	_stats.addCounter(_prefix + "busy_cycles", [this] { return this->busyCycles; });
+	_stats.addRatio(_prefix + "bandwidth", _prefix + "bytes", "cycles");
+}
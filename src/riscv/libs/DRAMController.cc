@@ -0,0 +1,169 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DRAMController.hh"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+DRAMController::DRAMController() {
+	size_t numChannels = acalsim::top->getParameter<int>("DRAM", "channels");
+	size_t numBanks    = acalsim::top->getParameter<int>("DRAM", "banks");
+	size_t rowSize     = acalsim::top->getParameter<int>("DRAM", "row_size");
+	this->burstSize    = acalsim::top->getParameter<int>("DRAM", "burst_size");
+	this->tRCD         = acalsim::top->getParameter<acalsim::Tick>("DRAM", "t_rcd");
+	this->tCAS         = acalsim::top->getParameter<acalsim::Tick>("DRAM", "t_cas");
+	this->tRP          = acalsim::top->getParameter<acalsim::Tick>("DRAM", "t_rp");
+	this->tBurst       = acalsim::top->getParameter<acalsim::Tick>("DRAM", "t_burst");
+
+	std::string policy = acalsim::top->getParameter<std::string>("DRAM", "page_policy");
+	ASSERT_MSG(policy == "open" || policy == "closed", "DRAM page_policy must be \"open\" or \"closed\".");
+	this->closedPage = policy == "closed";
+
+	ASSERT_MSG(numChannels > 0 && numBanks > 0, "DRAM must have at least one channel and one bank.");
+	ASSERT_MSG(this->burstSize > 0 && rowSize >= this->burstSize, "DRAM row_size must hold at least one burst.");
+	this->burstsPerRow = rowSize / this->burstSize;
+
+	this->channels.resize(numChannels);
+	for (auto& channel : this->channels) { channel.banks.resize(numBanks); }
+}
+
+void DRAMController::enqueue(acalsim::Tick _when, uint32_t _addr, bool _isWrite, Callback _callback) {
+	uint64_t block   = _addr / this->burstSize;
+	size_t   channel = block % this->channels.size();
+	block /= this->channels.size();
+	block /= this->burstsPerRow;
+
+	size_t   numBanks = this->channels[channel].banks.size();
+	size_t   bank     = block % numBanks;
+	uint32_t row      = block / numBanks;
+
+	auto& queue = this->channels[channel].queue;
+	queue.push_back(Request{_isWrite, bank, row, _when, _callback});
+	this->peakQueueLength = std::max(this->peakQueueLength, queue.size());
+}
+
+void DRAMController::enqueueAccess(acalsim::Tick _when, uint32_t _addr, uint32_t _bytes, bool _isWrite,
+                                   Callback _callback) {
+	uint64_t first = _addr / this->burstSize;
+	uint64_t last  = ((uint64_t)_addr + std::max<uint32_t>(_bytes, 1) - 1) / this->burstSize;
+	if (first == last || !_callback) {
+		for (uint64_t block = first; block <= last; block++) {
+			this->enqueue(_when, block * this->burstSize, _isWrite, block == last ? _callback : nullptr);
+		}
+		return;
+	}
+
+	// FR-FCFS may finish the bursts out of order, the callback waits for all of them
+	auto remaining = std::make_shared<uint64_t>(last - first + 1);
+	for (uint64_t block = first; block <= last; block++) {
+		this->enqueue(_when, block * this->burstSize, _isWrite, [remaining, _callback]() {
+			if (--*remaining == 0) _callback();
+		});
+	}
+}
+
+bool DRAMController::isRowHit(const Channel& _channel, const Request& _req) const {
+	const Bank& bank = _channel.banks[_req.bank];
+	return bank.rowOpen && bank.openRow == _req.row;
+}
+
+void DRAMController::issue(acalsim::Tick _when, std::vector<Completion>& _completions) {
+	for (auto& channel : this->channels) {
+		if (channel.queue.empty()) continue;
+		if (channel.issued && channel.lastIssueTick == _when) continue;
+
+		// FR-FCFS: the oldest row hit wins, otherwise the oldest request with a ready bank
+		auto selected = channel.queue.end();
+		for (auto it = channel.queue.begin(); it != channel.queue.end(); it++) {
+			if (channel.banks[it->bank].readyTick > _when) continue;
+			if (this->isRowHit(channel, *it)) {
+				selected = it;
+				break;
+			}
+			if (selected == channel.queue.end()) selected = it;
+		}
+		if (selected == channel.queue.end()) continue;
+
+		Request req  = std::move(*selected);
+		Bank&   bank = channel.banks[req.bank];
+		channel.queue.erase(selected);
+
+		acalsim::Tick colTick = _when;
+		if (this->isRowHit(channel, req)) {
+			this->rowHits++;
+		} else if (bank.rowOpen) {
+			this->rowConflicts++;
+			colTick += this->tRP + this->tRCD;
+		} else {
+			this->rowEmpty++;
+			colTick += this->tRCD;
+		}
+
+		acalsim::Tick dataStart = std::max(colTick + this->tCAS, channel.busFreeTick);
+		acalsim::Tick dataEnd   = dataStart + this->tBurst;
+		channel.busFreeTick     = dataEnd;
+		channel.lastIssueTick   = _when;
+		channel.issued          = true;
+		this->busBusyCycles += this->tBurst;
+
+		if (this->closedPage) {
+			// Auto-precharge right after the burst
+			bank.rowOpen   = false;
+			bank.readyTick = colTick + this->tBurst + this->tRP;
+		} else {
+			bank.rowOpen   = true;
+			bank.openRow   = req.row;
+			bank.readyTick = colTick + this->tBurst;
+		}
+
+		if (req.isWrite) {
+			this->writes++;
+		} else {
+			this->reads++;
+			this->readLatencySum += dataEnd - req.arrival;
+		}
+		if (req.callback) _completions.emplace_back(dataEnd, std::move(req.callback));
+	}
+}
+
+acalsim::Tick DRAMController::getNextIssueTick(acalsim::Tick _when) const {
+	acalsim::Tick next = 0;
+	for (const auto& channel : this->channels) {
+		for (const auto& req : channel.queue) {
+			acalsim::Tick tick = std::max(channel.banks[req.bank].readyTick, _when + 1);
+			if (!next || tick < next) next = tick;
+		}
+	}
+	return next;
+}
+
+void DRAMController::printStats() const {
+	acalsim::Tick now         = acalsim::top->getGlobalTick();
+	uint64_t      accesses    = this->reads + this->writes;
+	double        rowHitRate  = accesses ? 100.0 * this->rowHits / accesses : 0.0;
+	double        avgLatency  = this->reads ? (double)this->readLatencySum / this->reads : 0.0;
+	double        utilization = now ? 100.0 * this->busBusyCycles / (now * this->channels.size()) : 0.0;
+	double        bytesPerCyc = now ? (double)accesses * this->burstSize / now : 0.0;
+
+	CLASS_INFO << "DRAM: " << accesses << " bursts (" << this->reads << " reads, " << this->writes << " writes) | "
+	           << (this->closedPage ? "closed" : "open") << "-page policy";
+	CLASS_INFO << "DRAM row buffer: hit rate " << rowHitRate << "% | " << this->rowHits << " hits, " << this->rowEmpty
+	           << " empty, " << this->rowConflicts << " conflicts";
+	CLASS_INFO << "DRAM bandwidth: utilization " << utilization << "% | " << bytesPerCyc << " bytes/cycle | "
+	           << "average read latency " << avgLatency << " cycles | peak queue length " << this->peakQueueLength;
+}
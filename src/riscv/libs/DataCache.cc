@@ -0,0 +1,518 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DataCache.hh"
+
+#include <algorithm>
+
+#include "event/MemRespEvent.hh"
+
+DataCache::DataCache(std::string _name, DataMemory* _dmem) : acalsim::SimModule(_name), dmem(_dmem) {
+	size_t size          = acalsim::top->getParameter<int>("DataCache", "size");
+	this->lineSize       = acalsim::top->getParameter<int>("DataCache", "line_size");
+	this->numWays        = acalsim::top->getParameter<int>("DataCache", "associativity");
+	this->maxTargets     = acalsim::top->getParameter<int>("DataCache", "mshr_targets");
+	this->hitLatency     = acalsim::top->getParameter<acalsim::Tick>("DataCache", "hit_latency");
+	this->memReadLatency = acalsim::top->getParameter<acalsim::Tick>("SOC", "memory_read_latency");
+	this->numSets        = size / (this->lineSize * this->numWays);
+	ASSERT_MSG(this->numSets > 0, "The data cache must have at least one set.");
+	ASSERT_MSG(this->lineSize / 4 <= 64, "The data cache line must not hold more than 64 words.");
+
+	this->lines.resize(this->numSets * this->numWays);
+	this->mshrs.resize(acalsim::top->getParameter<int>("DataCache", "mshr_count"));
+	for (auto& mshr : this->mshrs) { mshr.targets.reserve(this->maxTargets); }
+
+	std::string prefetcherType = acalsim::top->getParameter<std::string>("DataCache", "prefetcher");
+	this->prefetcher = Prefetcher::create(prefetcherType, this->lineSize,
+	                                      acalsim::top->getParameter<int>("DataCache", "prefetch_degree"),
+	                                      acalsim::top->getParameter<int>("DataCache", "prefetch_distance"),
+	                                      acalsim::top->getParameter<int>("DataCache", "prefetch_table_size"));
+}
+
+bool DataCache::isReqAcceptable(uint32_t _addr, bool _isWrite) {
+	uint32_t   lineAddr = this->getLineAddr(_addr);
+	CacheLine* line     = this->lookup(lineAddr);
+	if (line && !(_isWrite && line->state == State::SHARED)) return true;
+
+	if (MSHR* mshr = this->findMSHR(lineAddr)) {
+		if (mshr->targets.size() < this->maxTargets) return true;
+		this->targetFullStallCycles++;
+		return false;
+	}
+
+	if (this->activeMSHRs < this->mshrs.size()) return true;
+	this->mshrFullStallCycles++;
+	return false;
+}
+
+void DataCache::memReadReqHandler(acalsim::Tick _when, MemReadReqPacket* _memReqPkt) {
+	instr_type op       = _memReqPkt->getOP();
+	uint32_t   addr     = _memReqPkt->getAddr();
+	uint32_t   lineAddr = this->getLineAddr(addr);
+	uint32_t   pc       = _memReqPkt->getPC();
+
+	// Atomics are performed at the cache. LR and a failing SC only read the line, a successful SC and
+	// the AMOs write it and need it in MODIFIED state before they return their value.
+	uint32_t data   = 0;
+	bool     writes = false;
+	if (isAtomicOp(op)) {
+		data   = this->dmem->atomicData(op, addr, _memReqPkt->getData(), _memReqPkt->getHartId());
+		writes = op != LR_W && !(op == SC_W && data);
+		this->atomics++;
+	} else {
+		data = this->dmem->loadData(op, addr);
+	}
+	MSHRTarget target{writes, true, _memReqPkt->getInstr(), op, data, _memReqPkt->getA1(), _memReqPkt->getCallback()};
+	acalsim::top->getRecycleContainer()->recycle(_memReqPkt);
+
+	if (writes) {
+		bool trigger = false;
+		this->writes++;
+		if (!this->writeAccess(_when, addr, target, trigger)) {
+			this->respond(this->hitLatency, [this, target]() { this->sendReadResp(target); });
+		} else {
+			this->atomicMisses++;
+		}
+		this->issuePrefetches(_when, pc, addr, trigger);
+		return;
+	}
+	this->reads++;
+
+	if (CacheLine* line = this->lookup(lineAddr)) {
+		bool firstUse = line->prefetched;
+		this->readHits++;
+		if (this->activeMSHRs) this->hitUnderMiss++;
+		if (firstUse) this->prefetchHits++;
+		line->prefetched = false;
+		line->lastUse    = ++this->useCnt;
+		line->wordMask |= this->getWordMask(addr);
+		this->respond(this->hitLatency, [this, target]() { this->sendReadResp(target); });
+		this->issuePrefetches(_when, pc, addr, firstUse);
+		return;
+	}
+
+	if (isAtomicOp(op)) this->atomicMisses++;
+	if (MSHR* mshr = this->findMSHR(lineAddr)) {
+		// Secondary miss: wait for the line fill that is already in flight
+		ASSERT_MSG(mshr->targets.size() < this->maxTargets, "No MSHR target slot is available for a secondary miss.");
+		bool late = mshr->prefetch;
+		if (late) {
+			this->latePrefetches++;
+		} else {
+			this->secondaryMisses++;
+		}
+		mshr->prefetch = false;
+		mshr->wordMask |= this->getWordMask(addr);
+		mshr->targets.push_back(target);
+		this->issuePrefetches(_when, pc, addr, late);
+		return;
+	}
+
+	this->primaryMisses++;
+	MSHR* mshr     = this->allocateMSHR(_when, lineAddr);
+	mshr->shared   = this->snoopPeers(_when, Coherence::READ, addr);
+	mshr->wordMask = this->getWordMask(addr);
+	mshr->targets.push_back(target);
+	this->issueLineFill(_when, lineAddr);
+	this->issuePrefetches(_when, pc, addr, true);
+}
+
+void DataCache::memWriteReqHandler(acalsim::Tick _when, MemWriteReqPacket* _memReqPkt) {
+	instr    i        = _memReqPkt->getInstr();
+	uint32_t addr     = _memReqPkt->getAddr();
+	uint32_t pc       = _memReqPkt->getPC();
+	auto     callback = _memReqPkt->getCallback();
+	bool     trigger  = false;
+
+	this->dmem->storeData(_memReqPkt->getOP(), addr, _memReqPkt->getData());
+	acalsim::top->getRecycleContainer()->recycle(_memReqPkt);
+	this->writes++;
+
+	this->writeAccess(_when, addr, MSHRTarget{true, false, i, SW, 0, operand(), nullptr}, trigger);
+	this->issuePrefetches(_when, pc, addr, trigger);
+
+	this->respond(this->hitLatency, [i, callback]() {
+		auto                rc      = acalsim::top->getRecycleContainer();
+		MemWriteRespPacket* respPkt = rc->acquire<MemWriteRespPacket>(&MemWriteRespPacket::renew, i);
+		if (callback) {
+			callback(respPkt);
+		} else {
+			rc->recycle(respPkt);
+		}
+	});
+}
+
+void DataCache::releaseLine(acalsim::Tick _when, uint32_t _addr) {
+	uint32_t lineAddr = this->getLineAddr(_addr);
+	this->farAtomics++;
+
+	if (CacheLine* line = this->lookup(lineAddr)) {
+		if (line->isDirty()) {
+			this->writebacks++;
+			this->dmem->postWrite(_when, lineAddr, this->lineSize);
+		}
+		if (line->prefetched) this->unusedPrefetches++;
+		line->state = State::INVALID;
+	}
+	// A fill still in flight must not keep the line either
+	if (MSHR* mshr = this->findMSHR(lineAddr)) mshr->stolen = true;
+
+	this->snoopPeers(_when, Coherence::READ_EXCLUSIVE, _addr);
+}
+
+bool DataCache::writeAccess(acalsim::Tick _when, uint32_t _addr, const MSHRTarget& _target, bool& _trigger) {
+	uint32_t   lineAddr = this->getLineAddr(_addr);
+	CacheLine* line     = this->lookup(lineAddr);
+
+	if (line) {
+		_trigger = line->prefetched;
+		this->writeHits++;
+		if (this->activeMSHRs) this->hitUnderMiss++;
+		if (_trigger) this->prefetchHits++;
+		line->prefetched = false;
+		line->lastUse    = ++this->useCnt;
+		line->wordMask |= this->getWordMask(_addr);
+		if (line->state != State::SHARED) {
+			line->state = State::MODIFIED;
+			return false;
+		}
+	}
+
+	// The request is issued once the target is in place, a fill may complete within the issuing cycle
+	MSHR* mshr    = this->findMSHR(lineAddr);
+	bool  primary = !mshr;
+	if (line) {
+		// Write to a SHARED copy: the other copies are invalidated now and an MSHR upgrades the line
+		this->upgrades++;
+		if (primary) {
+			mshr            = this->allocateMSHR(_when, lineAddr);
+			mshr->exclusive = true;
+			this->snoopPeers(_when, Coherence::UPGRADE, _addr);
+		} else {
+			ASSERT_MSG(mshr->targets.size() < this->maxTargets, "No MSHR target slot is available.");
+		}
+	} else if (primary) {
+		// Write-allocate: the write marks the line dirty once the fill arrives
+		this->primaryMisses++;
+		_trigger        = true;
+		mshr            = this->allocateMSHR(_when, lineAddr);
+		mshr->exclusive = true;
+		this->snoopPeers(_when, Coherence::READ_EXCLUSIVE, _addr);
+	} else {
+		ASSERT_MSG(mshr->targets.size() < this->maxTargets, "No MSHR target slot is available.");
+		_trigger = mshr->prefetch;
+		if (mshr->prefetch) {
+			this->latePrefetches++;
+		} else {
+			this->secondaryMisses++;
+		}
+		// A write merged into a pending read (or into a line another cache took over) needs ownership
+		if (!mshr->exclusive || mshr->stolen) {
+			mshr->exclusive = true;
+			mshr->shared    = false;
+			mshr->stolen    = false;
+			this->snoopPeers(_when, Coherence::UPGRADE, _addr);
+		}
+		mshr->prefetch = false;
+	}
+	mshr->wordMask |= this->getWordMask(_addr);
+	mshr->targets.push_back(_target);
+	if (primary) this->issueLineFill(_when, lineAddr, line != nullptr);
+	return true;
+}
+
+void DataCache::lineFillRespHandler(acalsim::Tick _when, uint32_t _lineAddr, MemReadRespPacket* _memRespPkt) {
+	acalsim::top->getRecycleContainer()->recycle(_memRespPkt);
+
+	MSHR* mshr = this->findMSHR(_lineAddr);
+	ASSERT_MSG(mshr, "Received a line fill without a matching MSHR.");
+
+	bool dirty = std::any_of(mshr->targets.begin(), mshr->targets.end(), [](const auto& t) { return t.isWrite; });
+	if (!mshr->stolen) {
+		State state = State::EXCLUSIVE;
+		if (mshr->shared || (this->coherence && !dirty && this->coherence->getProtocol() == Coherence::Protocol::MSI)) {
+			state = State::SHARED;
+		} else if (dirty) {
+			state = State::MODIFIED;
+		}
+		// Another cache read the line while the stores were in flight, so they are flushed right away
+		if (state == State::SHARED && dirty) {
+			this->snoopFlushes++;
+			this->dmem->postWrite(_when, _lineAddr, this->lineSize);
+		}
+
+		// An upgrade finds its SHARED copy in place unless it has been evicted in the meantime
+		CacheLine* line = this->lookup(_lineAddr);
+		if (line) {
+			line->state = state;
+		} else {
+			line = this->installLine(_when, _lineAddr, state, mshr->prefetch);
+		}
+		line->wordMask |= mshr->wordMask;
+	}
+
+	for (const auto& target : mshr->targets) {
+		if (target.hasResp) this->sendReadResp(target);
+	}
+	this->freeMSHR(_when, mshr);
+}
+
+DataCache::CacheLine* DataCache::lookup(uint32_t _lineAddr) {
+	size_t   lineIdx = _lineAddr / this->lineSize;
+	size_t   set     = lineIdx % this->numSets;
+	uint32_t tag     = lineIdx / this->numSets;
+
+	for (size_t way = 0; way < this->numWays; way++) {
+		CacheLine& line = this->lines[set * this->numWays + way];
+		if (line.isValid() && line.tag == tag) return &line;
+	}
+	return nullptr;
+}
+
+DataCache::MSHR* DataCache::findMSHR(uint32_t _lineAddr) {
+	for (auto& mshr : this->mshrs) {
+		if (mshr.valid && mshr.lineAddr == _lineAddr) return &mshr;
+	}
+	return nullptr;
+}
+
+DataCache::MSHR* DataCache::allocateMSHR(acalsim::Tick _when, uint32_t _lineAddr) {
+	for (auto& mshr : this->mshrs) {
+		if (mshr.valid) continue;
+
+		this->updateOccupancy(_when);
+		mshr.valid     = true;
+		mshr.lineAddr  = _lineAddr;
+		mshr.allocTick = _when;
+		this->activeMSHRs++;
+		this->peakMSHRs = std::max(this->peakMSHRs, this->activeMSHRs);
+		return &mshr;
+	}
+	ASSERT_MSG(false, "No MSHR is available for a primary miss.");
+	return nullptr;
+}
+
+void DataCache::freeMSHR(acalsim::Tick _when, MSHR* _mshr) {
+	this->updateOccupancy(_when);
+	_mshr->valid     = false;
+	_mshr->prefetch  = false;
+	_mshr->exclusive = false;
+	_mshr->shared    = false;
+	_mshr->stolen    = false;
+	_mshr->wordMask  = 0;
+	_mshr->targets.clear();
+	this->activeMSHRs--;
+}
+
+DataCache::CacheLine* DataCache::installLine(acalsim::Tick _when, uint32_t _lineAddr, State _state, bool _prefetched) {
+	size_t lineIdx = _lineAddr / this->lineSize;
+	size_t set     = lineIdx % this->numSets;
+
+	// Pick an invalid way first, otherwise evict the least recently used line
+	CacheLine* victim = &this->lines[set * this->numWays];
+	for (size_t way = 0; way < this->numWays; way++) {
+		CacheLine& line = this->lines[set * this->numWays + way];
+		if (!line.isValid()) {
+			victim = &line;
+			break;
+		}
+		if (line.lastUse < victim->lastUse) victim = &line;
+	}
+
+	// Data is kept up to date in DataMemory, so a dirty victim only costs a write-back
+	if (victim->isDirty()) {
+		this->writebacks++;
+		this->dmem->postWrite(_when, (victim->tag * this->numSets + set) * this->lineSize, this->lineSize);
+	}
+	if (victim->isValid() && victim->prefetched) this->unusedPrefetches++;
+
+	victim->state      = _state;
+	victim->prefetched = _prefetched;
+	victim->tag        = lineIdx / this->numSets;
+	victim->lastUse    = ++this->useCnt;
+	victim->wordMask   = 0;
+	return victim;
+}
+
+void DataCache::issueLineFill(acalsim::Tick _when, uint32_t _lineAddr, bool _upgrade) {
+	auto callback = [this, _lineAddr](MemReadRespPacket* _pkt) {
+		this->lineFillRespHandler(acalsim::top->getGlobalTick(), _lineAddr, _pkt);
+	};
+
+	auto              rc  = acalsim::top->getRecycleContainer();
+	MemReadReqPacket* pkt = rc->acquire<MemReadReqPacket>(&MemReadReqPacket::renew, callback, instr(), LW, _lineAddr,
+	                                                      operand());
+
+	// An upgrade only carries the address, the requester already holds the data. It completes at the
+	// bus grant, after the peers have been snooped, and DataMemory answers it without a memory access.
+	uint32_t      bytes   = _upgrade ? 0 : this->lineSize;
+	acalsim::Tick latency = _upgrade ? 1 : this->memReadLatency;
+	pkt->setBytes(bytes);
+	bool sent = this->bus->send(_when, this->busMaster, pkt, _lineAddr, bytes, false, latency);
+	ASSERT_MSG(sent, "The data cache has more line fills in flight than the bus allows.");
+}
+
+void DataCache::issuePrefetches(acalsim::Tick _when, uint32_t _pc, uint32_t _addr, bool _trigger) {
+	if (!this->prefetcher) return;
+
+	this->prefetchCandidates.clear();
+	this->prefetcher->notify(_pc, _addr, _trigger, this->prefetchCandidates);
+
+	for (uint32_t lineAddr : this->prefetchCandidates) {
+		if ((uint64_t)lineAddr + this->lineSize > this->dmem->getSize()) continue;
+		if (this->lookup(lineAddr) || this->findMSHR(lineAddr)) continue;
+
+		// Always leave one MSHR for demand misses
+		if (this->activeMSHRs + 1 >= this->mshrs.size()) {
+			this->prefetchesDropped++;
+			continue;
+		}
+
+		this->prefetchesIssued++;
+		MSHR* mshr     = this->allocateMSHR(_when, lineAddr);
+		mshr->prefetch = true;
+		mshr->shared   = this->snoopPeers(_when, Coherence::READ, lineAddr);
+		this->issueLineFill(_when, lineAddr);
+	}
+}
+
+bool DataCache::snoopPeers(acalsim::Tick _when, Coherence::Request _req, uint32_t _addr) {
+	if (!this->coherence) return false;
+
+	uint64_t writeMask = _req == Coherence::READ ? 0 : this->getWordMask(_addr);
+	return this->coherence->snoop(_when, this->cacheId, _req, this->getLineAddr(_addr), writeMask);
+}
+
+Coherence::SnoopResult DataCache::snoop(acalsim::Tick _when, Coherence::Request _req, uint32_t _lineAddr,
+                                        uint64_t _writeMask) {
+	Coherence::SnoopResult result;
+	uint64_t               referenced = 0;
+
+	if (CacheLine* line = this->lookup(_lineAddr)) {
+		result.hadCopy = true;
+		referenced |= line->wordMask;
+		if (line->isDirty()) {
+			// Data is kept up to date in DataMemory, so the flush only costs a write-back
+			result.flushed = true;
+			this->snoopFlushes++;
+			this->dmem->postWrite(_when, _lineAddr, this->lineSize);
+		}
+		if (_req == Coherence::READ) {
+			line->state = State::SHARED;
+		} else {
+			if (line->prefetched) this->unusedPrefetches++;
+			line->state = State::INVALID;
+		}
+	}
+
+	// A fill still in flight is ordered before the request, which takes effect once the line arrives
+	if (MSHR* mshr = this->findMSHR(_lineAddr)) {
+		result.hadCopy = true;
+		referenced |= mshr->wordMask;
+		if (_req == Coherence::READ) {
+			mshr->shared = true;
+		} else {
+			mshr->stolen = true;
+		}
+	}
+
+	if (result.hadCopy && _req != Coherence::READ) {
+		result.invalidated  = true;
+		result.falseSharing = referenced && !(referenced & _writeMask);
+		this->invalidationsReceived++;
+		if (result.falseSharing) this->falseSharingReceived++;
+	}
+	return result;
+}
+
+void DataCache::sendReadResp(const MSHRTarget& _target) {
+	auto               rc      = acalsim::top->getRecycleContainer();
+	MemReadRespPacket* respPkt = rc->acquire<MemReadRespPacket>(&MemReadRespPacket::renew, _target.i, _target.op,
+	                                                            _target.data, _target.a1);
+	if (_target.callback) {
+		_target.callback(respPkt);
+	} else {
+		rc->recycle(respPkt);
+	}
+}
+
+void DataCache::respond(acalsim::Tick _latency, std::function<void()> _callback) {
+	if (_latency <= 1) {
+		_callback();
+	} else {
+		auto          rc    = acalsim::top->getRecycleContainer();
+		MemRespEvent* event = rc->acquire<MemRespEvent>(&MemRespEvent::renew, _callback);
+		this->scheduleEvent(event, acalsim::top->getGlobalTick() + _latency - 1);
+	}
+}
+
+void DataCache::updateOccupancy(acalsim::Tick _when) {
+	this->occupancyIntegral += this->activeMSHRs * (_when - this->lastOccupancyTick);
+	this->lastOccupancyTick = _when;
+}
+
+void DataCache::printStats() const {
+	acalsim::Tick now       = acalsim::top->getGlobalTick();
+	uint64_t      integral  = this->occupancyIntegral + this->activeMSHRs * (now - this->lastOccupancyTick);
+	uint64_t      accesses  = this->reads + this->writes;
+	uint64_t      hits      = this->readHits + this->writeHits;
+	double        hitRate   = accesses ? 100.0 * hits / accesses : 0.0;
+	double        occupancy = now ? (double)integral / now : 0.0;
+
+	CLASS_INFO << "Data cache: " << accesses << " accesses (" << this->reads << " reads, " << this->writes
+	           << " writes) | hit rate " << hitRate << "%";
+	CLASS_INFO << "Data cache: " << this->primaryMisses << " primary misses, " << this->secondaryMisses
+	           << " secondary misses merged, " << this->hitUnderMiss << " hits under miss, " << this->writebacks
+	           << " write-backs";
+	CLASS_INFO << "Data cache MSHRs: " << this->mshrs.size() << " entries | average occupancy " << occupancy
+	           << " | peak occupancy " << this->peakMSHRs << " | stall cycles (MSHR full) " << this->mshrFullStallCycles
+	           << " | stall cycles (targets full) " << this->targetFullStallCycles;
+	if (this->coherence) {
+		CLASS_INFO << "Data cache coherence: " << this->upgrades << " upgrades, " << this->snoopFlushes
+		           << " flushes for other caches | " << this->invalidationsReceived << " invalidations received ("
+		           << this->falseSharingReceived << " false sharing)";
+	}
+	if (this->atomics || this->farAtomics) {
+		CLASS_INFO << "Data cache atomics: " << this->atomics << " performed at the cache (" << this->atomicMisses
+		           << " waited for the line or its ownership) | " << this->farAtomics
+		           << " performed at memory after releasing the line";
+	}
+
+	if (!this->prefetcher) return;
+
+	// Prefetched lines still unreferenced at the end of the simulation were not useful either
+	uint64_t unused = this->unusedPrefetches;
+	for (const auto& line : this->lines) { unused += line.isValid() && line.prefetched; }
+
+	uint64_t useful     = this->prefetchHits + this->latePrefetches;
+	double   coverage   = useful ? 100.0 * useful / (useful + this->primaryMisses) : 0.0;
+	double   accuracy   = this->prefetchesIssued ? 100.0 * useful / this->prefetchesIssued : 0.0;
+	double   timeliness = useful ? 100.0 * this->prefetchHits / useful : 0.0;
+
+	CLASS_INFO << "Prefetcher (" << this->prefetcher->getName() << "): " << this->prefetchesIssued << " issued, "
+	           << this->prefetchesDropped << " dropped (no free MSHR) | " << this->prefetchHits << " timely, "
+	           << this->latePrefetches << " late, " << unused << " unused";
+	CLASS_INFO << "Prefetcher (" << this->prefetcher->getName() << "): coverage " << coverage << "% | accuracy "
+	           << accuracy << "% | timeliness " << timeliness << "%";
+}
+
+void DataCache::addIntervalStats(IntervalStats& _stats, const std::string& _prefix) const {
+	_stats.addCounter(_prefix + "accesses", [this] { return this->reads + this->writes; });
+	_stats.addCounter(_prefix + "misses", [this] { return this->primaryMisses; });
+	_stats.addCounter(_prefix + "writebacks", [this] { return this->writebacks; });
+	_stats.addCounter(_prefix + "mshr_full_cycles", [this] { return this->mshrFullStallCycles; });
+	_stats.addRatio(_prefix + "miss_rate", _prefix + "misses", _prefix + "accesses");
+}
@@ -16,16 +16,23 @@
 
 #include "DataMemory.hh"
 
-uint32_t DataMemory::memReadReqHandler(acalsim::Tick _when, MemReadReqPacket* _memReqPkt) {
-	instr      i    = _memReqPkt->getInstr();
-	instr_type op   = _memReqPkt->getOP();
-	uint32_t   addr = _memReqPkt->getAddr();
-	operand    a1   = _memReqPkt->getA1();
+#include <algorithm>
+#include <utility>
+#include <vector>
 
+#include "event/DRAMIssueEvent.hh"
+#include "event/MemRespEvent.hh"
+
+DataMemory::DataMemory(std::string _name, size_t _size)
+    : acalsim::SimModule(_name), BaseMemory(_size), dramWakeTick(0) {
+	if (acalsim::top->getParameter<int>("DRAM", "enable")) { this->dram = std::make_unique<DRAMController>(); }
+}
+
+uint32_t DataMemory::loadData(instr_type _op, uint32_t _addr) {
 	size_t   bytes = 0;
 	uint32_t ret   = 0;
 
-	switch (op) {
+	switch (_op) {
 		case LB:
 		case LBU: bytes = 1; break;
 		case LH:
@@ -33,9 +40,9 @@ uint32_t DataMemory::memReadReqHandler(acalsim::Tick _when, MemReadReqPacket* _m
 		case LW: bytes = 4; break;
 	}
 
-	void* data = this->readData(addr, bytes, false);
+	void* data = this->readData(_addr, bytes, false);
 
-	switch (op) {
+	switch (_op) {
 		case LB: ret = static_cast<uint32_t>(*(int8_t*)data); break;
 		case LBU: ret = *(uint8_t*)data; break;
 		case LH: ret = static_cast<uint32_t>(*(int16_t*)data); break;
@@ -43,44 +50,190 @@ uint32_t DataMemory::memReadReqHandler(acalsim::Tick _when, MemReadReqPacket* _m
 		case LW: ret = *(uint32_t*)data; break;
 	}
 
-	auto rc = acalsim::top->getRecycleContainer();
-	rc->recycle(_memReqPkt);
 	return ret;
 }
 
-void DataMemory::memWriteReqHandler(acalsim::Tick _when, MemWriteReqPacket* _memReqPkt) {
-	instr      i        = _memReqPkt->getInstr();
-	instr_type op       = _memReqPkt->getOP();
-	uint32_t   addr     = _memReqPkt->getAddr();
-	uint32_t   data     = _memReqPkt->getData();
-	auto       callback = _memReqPkt->getCallback();
-
-	size_t bytes = 0;
-
-	switch (op) {
-		case SB: bytes = 1; break;
-		case SH: bytes = 2; break;
-		case SW: bytes = 4; break;
+void DataMemory::storeData(instr_type _op, uint32_t _addr, uint32_t _data) {
+	// A store to a reserved word makes the pending SCs on it fail
+	for (auto it = this->reservations.begin(); it != this->reservations.end();) {
+		if (it->second == (_addr & ~3u)) {
+			it = this->reservations.erase(it);
+		} else {
+			++it;
+		}
 	}
 
-	switch (op) {
+	switch (_op) {
 		case SB: {
-			uint8_t val8 = static_cast<uint8_t>(data);
-			this->writeData(&val8, addr, 1);
+			uint8_t val8 = static_cast<uint8_t>(_data);
+			this->writeData(&val8, _addr, 1);
 			break;
 		}
 		case SH: {
-			uint16_t val16 = static_cast<uint16_t>(data);
-			this->writeData(&val16, addr, 2);
+			uint16_t val16 = static_cast<uint16_t>(_data);
+			this->writeData(&val16, _addr, 2);
 			break;
 		}
 		case SW: {
-			uint32_t val32 = static_cast<uint32_t>(data);
-			this->writeData(&val32, addr, 4);
+			uint32_t val32 = static_cast<uint32_t>(_data);
+			this->writeData(&val32, _addr, 4);
 			break;
 		}
 	}
+}
 
-	auto rc = acalsim::top->getRecycleContainer();
+uint32_t DataMemory::atomicData(instr_type _op, uint32_t _addr, uint32_t _data, uint32_t _hartId) {
+	ASSERT_MSG(_addr % 4 == 0, "Atomic memory operations must be word aligned.");
+
+	auto [last, first] = this->lastAtomic.try_emplace(_addr, _hartId);
+	if (!first && last->second != _hartId) this->contendedCnt++;
+	last->second = _hartId;
+
+	uint32_t old = this->loadData(LW, _addr);
+	if (_op == LR_W) {
+		this->lrCnt++;
+		this->reservations[_hartId] = _addr;
+		return old;
+	}
+	if (_op == SC_W) {
+		this->scCnt++;
+		auto it = this->reservations.find(_hartId);
+		if (it == this->reservations.end() || it->second != _addr) {
+			this->scFailures++;
+			this->reservations.erase(_hartId);
+			return 1;
+		}
+		this->storeData(SW, _addr, _data);
+		return 0;
+	}
+
+	uint32_t value = 0;
+	switch (_op) {
+		case AMOSWAP_W: value = _data; break;
+		case AMOADD_W: value = old + _data; break;
+		case AMOXOR_W: value = old ^ _data; break;
+		case AMOAND_W: value = old & _data; break;
+		case AMOOR_W: value = old | _data; break;
+		case AMOMIN_W: value = std::min<int32_t>(old, _data); break;
+		case AMOMAX_W: value = std::max<int32_t>(old, _data); break;
+		case AMOMINU_W: value = std::min(old, _data); break;
+		case AMOMAXU_W: value = std::max(old, _data); break;
+		default: ASSERT_MSG(false, "Unknown atomic memory operation."); break;
+	}
+	this->amoCnt++;
+	this->storeData(SW, _addr, value);
+	return old;
+}
+
+void DataMemory::memReadReqHandler(acalsim::Tick _when, MemReadReqPacket* _memReqPkt) {
+	instr      i        = _memReqPkt->getInstr();
+	instr_type op       = _memReqPkt->getOP();
+	uint32_t   addr     = _memReqPkt->getAddr();
+	operand    a1       = _memReqPkt->getA1();
+	uint32_t   bytes    = _memReqPkt->getBytes();
+	auto       callback = _memReqPkt->getCallback();
+
+	// Atomics are performed here when they bypass the data caches. An SC that fails writes nothing.
+	uint32_t ret = 0;
+	if (isAtomicOp(op)) {
+		ret = this->atomicData(op, addr, _memReqPkt->getData(), _memReqPkt->getHartId());
+		if (op != LR_W && !(op == SC_W && ret)) this->postWrite(_when, addr);
+	} else {
+		ret = this->loadData(op, addr);
+	}
+
+	auto               rc      = acalsim::top->getRecycleContainer();
+	MemReadRespPacket* respPkt = rc->acquire<MemReadRespPacket>(&MemReadRespPacket::renew, i, op, ret, a1);
+	rc->recycle(_memReqPkt);
+
+	// An address-only request, e.g. a coherence upgrade, does not reach the DRAM
+	if (this->dram && bytes) {
+		// Data is read on arrival; the response is released when the last DRAM burst of the access completes
+		this->dram->enqueueAccess(_when, addr, bytes, false, [rc, callback, respPkt]() {
+			if (callback) {
+				callback(respPkt);
+			} else {
+				rc->recycle(respPkt);
+			}
+		});
+		this->issueDRAMRequests(_when);
+		return;
+	}
+
+	if (callback) {
+		callback(respPkt);
+	} else {
+		rc->recycle(respPkt);
+	}
+}
+
+void DataMemory::memWriteReqHandler(acalsim::Tick _when, MemWriteReqPacket* _memReqPkt) {
+	instr      i        = _memReqPkt->getInstr();
+	instr_type op       = _memReqPkt->getOP();
+	uint32_t   addr     = _memReqPkt->getAddr();
+	uint32_t   data     = _memReqPkt->getData();
+	auto       callback = _memReqPkt->getCallback();
+
+	this->storeData(op, addr, data);
+	this->postWrite(_when, addr);
+
+	auto                rc      = acalsim::top->getRecycleContainer();
+	MemWriteRespPacket* respPkt = rc->acquire<MemWriteRespPacket>(&MemWriteRespPacket::renew, i);
 	rc->recycle(_memReqPkt);
+
+	if (callback) {
+		callback(respPkt);
+	} else {
+		rc->recycle(respPkt);
+	}
+}
+
+void DataMemory::postWrite(acalsim::Tick _when, uint32_t _addr, uint32_t _bytes) {
+	if (!this->dram) return;
+
+	this->dram->enqueueAccess(_when, _addr, _bytes, true, nullptr);
+	this->issueDRAMRequests(_when);
+}
+
+void DataMemory::accessDRAM(acalsim::Tick _when, uint32_t _addr, uint32_t _bytes, bool _isWrite,
+                            DRAMController::Callback _callback) {
+	this->dram->enqueueAccess(_when, _addr, _bytes, _isWrite, std::move(_callback));
+	this->issueDRAMRequests(_when);
+}
+
+void DataMemory::issueDRAMRequests(acalsim::Tick _when) {
+	if (this->dramWakeTick == _when) this->dramWakeTick = 0;
+
+	std::vector<DRAMController::Completion> completions;
+	this->dram->issue(_when, completions);
+
+	auto rc = acalsim::top->getRecycleContainer();
+	for (auto& [tick, callback] : completions) {
+		if (tick <= _when) {
+			callback();
+		} else {
+			MemRespEvent* event = rc->acquire<MemRespEvent>(&MemRespEvent::renew, callback);
+			this->scheduleEvent(event, tick);
+		}
+	}
+
+	// Only keep the earliest wake-up scheduled; a stale later wake-up just finds nothing to do
+	acalsim::Tick next = this->dram->getNextIssueTick(_when);
+	if (next && (!this->dramWakeTick || next < this->dramWakeTick)) {
+		DRAMIssueEvent* event = rc->acquire<DRAMIssueEvent>(&DRAMIssueEvent::renew, this);
+		this->scheduleEvent(event, next);
+		this->dramWakeTick = next;
+	}
+}
+
+void DataMemory::printStats() const {
+	uint64_t atomics = this->amoCnt + this->lrCnt + this->scCnt;
+	if (atomics) {
+		double retryRate  = this->scCnt ? 100.0 * this->scFailures / this->scCnt : 0.0;
+		double contention = 100.0 * this->contendedCnt / atomics;
+		CLASS_INFO << "Atomics: " << this->amoCnt << " AMOs, " << this->lrCnt << " LR, " << this->scCnt << " SC ("
+		           << this->scFailures << " failed, retry rate " << retryRate << "%) | contention " << contention
+		           << "% (" << this->contendedCnt << " atomics followed another hart on the same word)";
+	}
+	if (this->dram) this->dram->printStats();
 }
@@ -26,30 +26,33 @@ void EXEStage::step() {
 
 	// check hazards
 	bool controlHazard = false;
-	if (this->getPipeRegister("prIF2EXE-out")->isValid()) {
-		InstPacket* instPacket = ((InstPacket*)this->getPipeRegister("prIF2EXE-out")->value());
+	if (this->prIF2EXE->isValid()) {
+		InstPacket* instPacket = ((InstPacket*)this->prIF2EXE->value());
 		controlHazard          = instPacket->isTakenBranch;
 		inboundPacket          = instPacket;
 	}
 
 	if (inboundPacket)
-		CLASS_INFO << "   EXEStage step() an InstPacket @PC=" << inboundPacket->pc
-		           << " controlHazard: " << (controlHazard ? "Yes" : "No");
+		SOC_TRACE(2, currTick, TraceStage::EXE, TraceEvent::EXE_INBOUND, this->hartId, inboundPacket->pc,
+		          inboundPacket->inst.op, controlHazard);
 	else
-		CLASS_INFO << "   EXEStage step(), no inbound packet";
+		SOC_TRACE(2, currTick, TraceStage::EXE, TraceEvent::EXE_IDLE, this->hartId, 0, 0);
 
-	if (this->getPipeRegister("prIF2EXE-out")->isValid() && !this->getPipeRegister("prEXE2WB-in")->isStalled()) {
-		SimPacket* pkt = this->getPipeRegister("prIF2EXE-out")->pop();
+	if (this->cycleStack && inboundPacket && this->prEXE2WB->isStalled()) this->cycleStack->structural++;
+
+	if (this->prIF2EXE->isValid() && !this->prEXE2WB->isStalled()) {
+		SimPacket* pkt = this->prIF2EXE->pop();
 		// process tht packet regardless whether it has control hazard or not
-		this->accept(currTick, *pkt);
+		static_cast<InstPacket*>(pkt)->visit(currTick, *this);
 	}
 }
 
 void EXEStage::instPacketHandler(Tick when, SimPacket* pkt) {
-	CLASS_INFO << "   EXEStage::instPacketHandler()  has received and an InstPacket @PC=" << ((InstPacket*)pkt)->pc
-	           << " from prIF2EXE-out and push it to prEXE2WB-in";
+	InstPacket* instPacket = (InstPacket*)pkt;
+	SOC_TRACE(2, when, TraceStage::EXE, TraceEvent::EXE_RECEIVE, this->hartId, instPacket->pc, instPacket->inst.op);
 
 	// push to the prEXE2WB register
-	if (!this->getPipeRegister("prEXE2WB-in")->push(pkt)) { CLASS_ERROR << "EXEStage failed to handle an InstPacket!"; }
+	if (!this->prEXE2WB->push(pkt)) { CLASS_ERROR << "EXEStage failed to handle an InstPacket!"; }
+	SOC_KONATA(KonataTrace::advance(KonataTrace::EXE, when, instPacket->traceId, "EX", "WB"));
 	WBInstPacket = (InstPacket*)pkt;
 }
@@ -123,6 +123,19 @@ void Emulator::parse_mem(char* _tok, int* _reg, uint32_t* _imm, int _bits, int _
 	*_reg      = parse_reg(regs, _line);
 }
 
+void Emulator::parse_amo_addr(char* _tok, int* _reg, int _line) {
+	// Atomic memory operations address memory with a plain base register: (rs1) or 0(rs1)
+	if (_tok[0] == '(') {
+		char* regs = strtok(_tok + 1, ")");
+		if (!regs) print_syntax_error(_line, "Malformed address operand");
+		*_reg = parse_reg(regs, _line);
+		return;
+	}
+	uint32_t imm = 0;
+	parse_mem(_tok, _reg, &imm, 12, _line);
+	if (imm) print_syntax_error(_line, "Atomic memory operations take no address offset");
+}
+
 int Emulator::parse_assembler_directive(int _line, char* _ftok, uint8_t* _mem, int _memoff) {
 	// printf( "assembler directive %s\n", ftok );
 	if (0 == memcmp(_ftok, ".text", strlen(_ftok))) {
@@ -249,6 +262,30 @@ int Emulator::parse_instr(int _line, char* _ftok, instr* _imem, int _memoff, lab
 				i->a3.type = OPTYPE_LABEL;
 				strncpy(i->a3.label, o3, MAX_LABEL_LEN);
 				return 1;
+			case LR_W:
+				if (!o1 || !o2 || o3 || o4) print_syntax_error(_line, "Invalid format");
+				i->a1.reg = parse_reg(o1, _line);
+				parse_amo_addr(o2, &i->a2.reg, _line);
+				i->a3.reg = 0;
+				i->a3.imm = 0;
+				return 1;
+			case SC_W:
+			case AMOSWAP_W:
+			case AMOADD_W:
+			case AMOXOR_W:
+			case AMOAND_W:
+			case AMOOR_W:
+			case AMOMIN_W:
+			case AMOMAX_W:
+			case AMOMINU_W:
+			case AMOMAXU_W:
+				// rd, rs2, (rs1): the source operand goes to a3.reg, a3.imm stays the zero address offset
+				if (!o1 || !o2 || !o3 || o4) print_syntax_error(_line, "Invalid format");
+				i->a1.reg = parse_reg(o1, _line);
+				i->a3.reg = parse_reg(o2, _line);
+				i->a3.imm = 0;
+				parse_amo_addr(o3, &i->a2.reg, _line);
+				return 1;
 			case LUI:
 			case AUIPC:  // how to deal with LSB correctly? FIXME
 				if (!o1 || !o2 || o3 || o4) print_syntax_error(_line, "Invalid format");
@@ -294,6 +331,26 @@ instr_type Emulator::parse_instr(char* _tok) {
 	if (streq(_tok, "sh")) return SH;
 	if (streq(_tok, "sw")) return SW;
 
+	// atomics, the ordering suffixes are accepted and ignored since every core performs its memory
+	// accesses in program order
+	char* suffix = strstr(_tok, ".w");
+	bool  word   = suffix && (streq(suffix, ".w") || streq(suffix, ".w.aq") || streq(suffix, ".w.rl") ||
+	                          streq(suffix, ".w.aqrl"));
+	if (word) {
+		std::string base(_tok, suffix - _tok);
+		if (base == "lr") return LR_W;
+		if (base == "sc") return SC_W;
+		if (base == "amoswap") return AMOSWAP_W;
+		if (base == "amoadd") return AMOADD_W;
+		if (base == "amoxor") return AMOXOR_W;
+		if (base == "amoand") return AMOAND_W;
+		if (base == "amoor") return AMOOR_W;
+		if (base == "amomin") return AMOMIN_W;
+		if (base == "amomax") return AMOMAX_W;
+		if (base == "amominu") return AMOMINU_W;
+		if (base == "amomaxu") return AMOMAXU_W;
+	}
+
 	// branch
 	if (streq(_tok, "beq")) return BEQ;
 	if (streq(_tok, "bge")) return BGE;
@@ -628,6 +685,15 @@ void Emulator::normalize_labels(instr* _imem, label_loc* _labels, int _label_cou
 	}
 }
 
+int Emulator::find_label(const std::string& _label) const {
+	std::string label = _label;
+	for (auto& c : label) c = tolower(c);
+	for (int i = 0; i < this->label_count; i++) {
+		if (label == this->labels[i].label) return this->labels[i].loc;
+	}
+	return -1;
+}
+
 uint32_t Emulator::label_addr(char* _label, label_loc* _labels, int _label_count, int _orig_line) {
 	for (int i = 0; i < _label_count; i++) {
 		if (streq(_labels[i].label, _label)) return _labels[i].loc;
@@ -74,8 +74,8 @@ void IFStage::step() {
 
 	// check hazards
 	bool dataHazard = false;
-	if (this->getSlavePort("soc-s")->isPopValid()) {
-		InstPacket* instPacket = ((InstPacket*)this->getSlavePort("soc-s")->front());
+	if (this->socPort->isPopValid()) {
+		InstPacket* instPacket = ((InstPacket*)this->socPort->front());
 
 		// IF, EXE hazard
 		auto EXEDestReg = EXEInstPacket ? this->getDestReg(EXEInstPacket->inst) : 0;
@@ -90,31 +90,56 @@ void IFStage::step() {
 	if (EXEInstPacket) { controlHazard = EXEInstPacket->isTakenBranch; }
 
 	Tick currTick = top->getGlobalTick();
-	if (this->getSlavePort("soc-s")->isPopValid()) {
-		CLASS_INFO << "   IFStage step() : has an inbound  InstPacket availble ";
+	if (this->socPort->isPopValid()) {
+		SOC_TRACE(2, currTick, TraceStage::IF, TraceEvent::IF_INBOUND, this->hartId, 0, 0);
 
 		if (!dataHazard && !controlHazard) {
-			CLASS_INFO << "   IFStage step() :  popped an InstPacket";
-			SimPacket* pkt = this->getSlavePort("soc-s")->pop();
-			this->accept(currTick, *pkt);
+			InstPacket* pkt = static_cast<InstPacket*>(this->socPort->pop());
+			SOC_TRACE(2, currTick, TraceStage::IF, TraceEvent::IF_POP, this->hartId, pkt->pc, pkt->inst.op);
+			SOC_KONATA(this->endStall(currTick, pkt));
+			pkt->visit(currTick, *this);
 
 		} else {
 			WBInstPacket  = EXEInstPacket;
 			EXEInstPacket = nullptr;
-			// There are still pending request but no new input in the next cycle
-			this->forceStepInNextIteration();
-			if (dataHazard) CLASS_INFO << "   IFStage step() :  data Hazard detected. Stall IFStage";
-			if (controlHazard) CLASS_INFO << "   IFStage step() :  control Hazard detected. Stall IFStage";
+			// There are still pending request but no new input in the next cycle, a scheduler steps the
+			// stage as long as the instruction waits in the port
+			if (!this->scheduled) this->forceStepInNextIteration();
+			SOC_KONATA(this->beginStall(currTick, dataHazard ? "DH" : "CH"));
+			if (this->cycleStack) {
+				// A cycle with both hazards counts as a data hazard stall
+				if (dataHazard) {
+					this->cycleStack->dataHazard++;
+				} else {
+					this->cycleStack->controlHazard++;
+				}
+			}
+			if (dataHazard) SOC_TRACE(2, currTick, TraceStage::IF, TraceEvent::IF_DATA_HAZARD, this->hartId, 0, 0);
+			if (controlHazard) SOC_TRACE(2, currTick, TraceStage::IF, TraceEvent::IF_CTRL_HAZARD, this->hartId, 0, 0);
 		}
 	}
 }
 
 void IFStage::instPacketHandler(Tick when, SimPacket* pkt) {
-	CLASS_INFO << "   IFStage::instPacketHandler() has received InstPacket @PC=" << ((InstPacket*)pkt)->pc
-	           << " from soc-s and push it to prIF2EXE-in";
+	InstPacket* instPacket = (InstPacket*)pkt;
+	SOC_TRACE(2, when, TraceStage::IF, TraceEvent::IF_RECEIVE, this->hartId, instPacket->pc, instPacket->inst.op);
 
 	// push to the prIF2EXE register
-	if (!this->getPipeRegister("prIF2EXE-in")->push(pkt)) { CLASS_ERROR << "IFStage failed to handle an InstPacket!"; }
+	if (!this->prIF2EXE->push(pkt)) { CLASS_ERROR << "IFStage failed to handle an InstPacket!"; }
+	SOC_KONATA(KonataTrace::advance(KonataTrace::IF, when, instPacket->traceId, "IF", "EX"));
 	WBInstPacket  = EXEInstPacket;
 	EXEInstPacket = (InstPacket*)pkt;
 }
+
+void IFStage::beginStall(Tick _when, const char* _cause) {
+	if (this->stalledPacket) return;
+	this->stalledPacket = (InstPacket*)this->socPort->front();
+	this->stallCause    = _cause;
+	KonataTrace::stall(KonataTrace::IF, _when, this->stalledPacket->traceId, _cause);
+}
+
+void IFStage::endStall(Tick _when, InstPacket* _pkt) {
+	if (this->stalledPacket != _pkt) return;
+	KonataTrace::resume(KonataTrace::IF, _when, _pkt->traceId, this->stallCause);
+	this->stalledPacket = nullptr;
+}
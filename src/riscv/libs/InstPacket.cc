@@ -25,13 +25,10 @@ void InstPacket::visit(acalsim::Tick _when, acalsim::SimModule& _module) {
 }
 
 void InstPacket::visit(acalsim::Tick _when, acalsim::SimBase& _simulator) {
-	if (auto sim = dynamic_cast<IFStage*>(&_simulator)) {
-		sim->instPacketHandler(_when, this);
-	} else if (auto sim = dynamic_cast<EXEStage*>(&_simulator)) {
-		sim->instPacketHandler(_when, this);
-	} else if (auto sim = dynamic_cast<WBStage*>(&_simulator)) {
-		sim->instPacketHandler(_when, this);
-	} else {
-		CLASS_ERROR << "Invalid simulator type!";
-	}
+	CLASS_ERROR << "InstPacket is delivered with a typed visit()!";
 }
+
+#define SOC_DEFINE_VISIT(_stage) \
+	void InstPacket::visit(acalsim::Tick _when, _stage& _simulator) { _simulator.instPacketHandler(_when, this); }
+SOC_STAGE_TARGETS(SOC_DEFINE_VISIT)
+#undef SOC_DEFINE_VISIT
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "IntervalStats.hh"
+
+IntervalStats::IntervalStats(const std::string& _path, acalsim::Tick _interval)
+    : out(_path), interval(_interval), nextTick(_interval) {
+	if (!this->out) ERROR << "Cannot open the interval statistics file " << _path;
+}
+
+void IntervalStats::addCounter(const std::string& _name, Probe _probe) {
+	ASSERT_MSG(!this->started, "Interval statistics counters are added before the first sample.");
+	this->names.push_back(_name);
+	this->probes.push_back(std::move(_probe));
+}
+
+void IntervalStats::addRatio(const std::string& _name, const std::string& _num, const std::string& _den) {
+	ASSERT_MSG(!this->started, "Interval statistics ratios are added before the first sample.");
+	this->ratios.push_back({_name, this->findColumn(_num), this->findColumn(_den)});
+}
+
+size_t IntervalStats::findColumn(const std::string& _name) const {
+	if (_name == "cycles") return kCycles;
+	for (size_t i = 0; i < this->names.size(); i++) {
+		if (this->names[i] == _name) return i;
+	}
+	ERROR << "Unknown interval statistics counter " << _name;
+	return kCycles;
+}
+
+void IntervalStats::record(acalsim::Tick _now) {
+	if (!this->started) {
+		// The header and the baseline are taken at the first sample, once every module has registered
+		this->started = true;
+		this->out << "tick,cycles";
+		for (auto& name : this->names) { this->out << "," << name; }
+		for (auto& ratio : this->ratios) { this->out << "," << ratio.name; }
+		this->out << "\n";
+		this->last.assign(this->probes.size(), 0);
+		this->delta.resize(this->probes.size());
+	}
+
+	acalsim::Tick cycles = _now - this->lastTick;
+	this->out << _now << "," << cycles;
+	for (size_t i = 0; i < this->probes.size(); i++) {
+		uint64_t value = this->probes[i]();
+		this->delta[i] = value - this->last[i];
+		this->last[i]  = value;
+		this->out << "," << this->delta[i];
+	}
+	for (auto& ratio : this->ratios) {
+		uint64_t num = ratio.num == kCycles ? cycles : this->delta[ratio.num];
+		uint64_t den = ratio.den == kCycles ? cycles : this->delta[ratio.den];
+		this->out << "," << (den ? (double)num / den : 0.0);
+	}
+	this->out << "\n";
+
+	this->lastTick = _now;
+	this->nextTick = (_now / this->interval + 1) * this->interval;
+}
+
+void IntervalStats::finish(acalsim::Tick _now) {
+	if (_now > this->lastTick || !this->started) this->record(_now);
+	this->out.close();
+}
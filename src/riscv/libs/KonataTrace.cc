@@ -0,0 +1,202 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "KonataTrace.hh"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+constexpr size_t kFlushBytes = 1 << 20;
+
+enum class Kind : uint8_t { FETCH, ADVANCE, STALL, RESUME, RETIRE };
+
+/// Event recorded by a unit, the handle is mapped to the id in the file when the event is merged
+struct Event {
+	acalsim::Tick tick;
+	Kind          kind;
+	uint64_t      handle;
+	const char*   a = nullptr;  ///< Stage or stall cause
+	const char*   b = nullptr;  ///< Stage entered by an advance
+	std::string   label;        ///< Label of a fetch
+};
+
+/// Events of one core, one buffer per unit so that every buffer has a single writer
+struct Hart {
+	std::vector<Event> units[KonataTrace::NUM_UNITS];
+	uint32_t           nextSeq = 0;  ///< Sequence number of the next fetch, only touched by the CPU unit
+};
+
+/// State of the open trace; the harts are written by their units, the rest only by flush() and close()
+struct Writer {
+	FILE*                                  file = nullptr;
+	std::string                            buffer;            ///< Text not written to the file yet
+	acalsim::Tick                          cycle        = 0;  ///< Tick of the last event
+	uint64_t                               nextId       = 0;
+	uint64_t                               nextRetireId = 0;
+	std::vector<Hart>                      harts;
+	std::unordered_map<uint64_t, uint64_t> inFlight;  ///< Id of the instructions fetched but not retired
+	std::vector<const Event*>              merged;    ///< Scratch list of flush()
+};
+
+Writer writer;
+
+/// Appends a formatted line to the buffer and writes the buffer out when it is full
+void append(const char* _fmt, ...) {
+	char    line[128];
+	va_list args;
+	va_start(args, _fmt);
+	int len = std::vsnprintf(line, sizeof(line), _fmt, args);
+	va_end(args);
+	writer.buffer.append(line, std::min<size_t>(len, sizeof(line) - 1));
+
+	if (writer.buffer.size() >= kFlushBytes) {
+		std::fwrite(writer.buffer.data(), 1, writer.buffer.size(), writer.file);
+		writer.buffer.clear();
+	}
+}
+
+/// Moves the trace forward to `_tick`, events of an earlier tick are drawn at the current cycle
+void moveTo(acalsim::Tick _tick) {
+	if (_tick <= writer.cycle) return;
+	append("C\t%llu\n", (unsigned long long)(_tick - writer.cycle));
+	writer.cycle = _tick;
+}
+
+/// Records an event of a unit, the core is part of the handle
+void record(KonataTrace::Unit _unit, Event&& _event) {
+	writer.harts[_event.handle >> 32].units[_unit].push_back(std::move(_event));
+}
+
+/// Writes a merged event to the buffer
+void write(const Event& _event) {
+	if (_event.kind == Kind::FETCH) {
+		uint64_t id = writer.nextId++;
+		writer.inFlight.emplace(_event.handle, id);
+		append("I\t%llu\t%llu\t%u\n", (unsigned long long)id, (unsigned long long)id,
+		       (uint32_t)(_event.handle >> 32));
+		append("L\t%llu\t0\t%s\n", (unsigned long long)id, _event.label.c_str());
+		append("S\t%llu\t0\tIF\n", (unsigned long long)id);
+		return;
+	}
+
+	auto it = writer.inFlight.find(_event.handle);
+	if (it == writer.inFlight.end()) return;
+	unsigned long long id = it->second;
+	switch (_event.kind) {
+		case Kind::ADVANCE:
+			append("E\t%llu\t0\t%s\n", id, _event.a);
+			append("S\t%llu\t0\t%s\n", id, _event.b);
+			break;
+		case Kind::STALL: append("S\t%llu\t1\t%s\n", id, _event.a); break;
+		case Kind::RESUME: append("E\t%llu\t1\t%s\n", id, _event.a); break;
+		case Kind::RETIRE:
+			append("E\t%llu\t0\t%s\n", id, _event.a);
+			append("R\t%llu\t%llu\t0\n", id, (unsigned long long)writer.nextRetireId++);
+			writer.inFlight.erase(it);
+			break;
+		default: break;
+	}
+}
+
+}  // namespace
+
+std::atomic<bool> KonataTrace::enabled{false};
+
+void KonataTrace::open(const std::string& _path, uint32_t _numHarts) {
+	ASSERT_MSG(!isEnabled(), "The pipeline trace is already open.");
+	writer.file = std::fopen(_path.c_str(), "w");
+	ASSERT_MSG(writer.file, "Cannot open the pipeline trace file.");
+
+	writer.buffer.reserve(kFlushBytes + 128);
+	writer.cycle        = acalsim::top->getGlobalTick();
+	writer.nextId       = 0;
+	writer.nextRetireId = 0;
+	writer.harts.assign(_numHarts, Hart());
+	append("Kanata\t0004\nC=\t%llu\n", (unsigned long long)writer.cycle);
+	enabled.store(true, std::memory_order_release);
+}
+
+void KonataTrace::flush() {
+	if (!isEnabled()) return;
+
+	// Buffers are concatenated in hart and unit order, a stable sort by tick keeps that order within a tick
+	writer.merged.clear();
+	for (auto& hart : writer.harts) {
+		for (auto& unit : hart.units) {
+			for (auto& event : unit) { writer.merged.push_back(&event); }
+		}
+	}
+	std::stable_sort(writer.merged.begin(), writer.merged.end(),
+	                 [](const Event* _a, const Event* _b) { return _a->tick < _b->tick; });
+
+	for (auto event : writer.merged) {
+		moveTo(event->tick);
+		write(*event);
+	}
+	for (auto& hart : writer.harts) {
+		for (auto& unit : hart.units) { unit.clear(); }
+	}
+}
+
+void KonataTrace::close() {
+	if (!isEnabled()) return;
+	flush();
+	enabled.store(false, std::memory_order_release);
+
+	std::vector<uint64_t> flushed;
+	for (auto& [handle, id] : writer.inFlight) { flushed.push_back(id); }
+	std::sort(flushed.begin(), flushed.end());
+	for (auto id : flushed) { append("R\t%llu\t%llu\t1\n", (unsigned long long)id, (unsigned long long)id); }
+	writer.inFlight.clear();
+	writer.harts.clear();
+
+	std::fwrite(writer.buffer.data(), 1, writer.buffer.size(), writer.file);
+	writer.buffer.clear();
+	std::fclose(writer.file);
+	writer.file = nullptr;
+}
+
+uint64_t KonataTrace::fetch(acalsim::Tick _tick, uint32_t _hartId, uint32_t _pc, const std::string& _op) {
+	uint64_t handle = (uint64_t)_hartId << 32 | writer.harts[_hartId].nextSeq++;
+	char     label[64];
+	std::snprintf(label, sizeof(label), "%08x: %s", _pc, _op.c_str());
+
+	Event event{_tick, Kind::FETCH, handle};
+	event.label = label;
+	record(CPU, std::move(event));
+	return handle;
+}
+
+void KonataTrace::advance(Unit _unit, acalsim::Tick _tick, uint64_t _id, const char* _from, const char* _to) {
+	record(_unit, Event{_tick, Kind::ADVANCE, _id, _from, _to});
+}
+
+void KonataTrace::stall(Unit _unit, acalsim::Tick _tick, uint64_t _id, const char* _cause) {
+	record(_unit, Event{_tick, Kind::STALL, _id, _cause});
+}
+
+void KonataTrace::resume(Unit _unit, acalsim::Tick _tick, uint64_t _id, const char* _cause) {
+	record(_unit, Event{_tick, Kind::RESUME, _id, _cause});
+}
+
+void KonataTrace::retire(Unit _unit, acalsim::Tick _tick, uint64_t _id, const char* _last) {
+	record(_unit, Event{_tick, Kind::RETIRE, _id, _last});
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MMIODevice.hh"
+
+#include <algorithm>
+#include <cmath>
+
+void MMIODevice::setTimingModel(const std::string& _model) {
+	ASSERT_MSG(_model == "cycle" || _model == "analytical" || _model == "validate",
+	           "The timing model must be \"cycle\", \"analytical\" or \"validate\".");
+	if (_model == "analytical") {
+		this->timingModel = TimingModel::ANALYTICAL;
+	} else if (_model == "validate") {
+		this->timingModel = TimingModel::VALIDATE;
+	} else {
+		this->timingModel = TimingModel::CYCLE;
+	}
+}
+
+void MMIODevice::recordValidation(acalsim::Tick _analytical, acalsim::Tick _cycle) {
+	double error = _cycle ? std::fabs((double)_analytical - (double)_cycle) / _cycle : 0.0;
+
+	this->validatedCmds++;
+	this->analyticalSum += _analytical;
+	this->cycleSum += _cycle;
+	this->absErrorSum += error;
+	if (error >= this->maxAbsError) {
+		this->maxAbsError    = error;
+		this->maxErrorCycles = _cycle;
+	}
+}
+
+void MMIODevice::printValidationStats() const {
+	if (!this->validatedCmds) return;
+
+	double meanError  = 100.0 * this->absErrorSum / this->validatedCmds;
+	double totalError = this->cycleSum ? 100.0 * ((double)this->analyticalSum - (double)this->cycleSum) / this->cycleSum
+	                                   : 0.0;
+
+	CLASS_INFO << "Timing model validation: " << this->validatedCmds << " commands | analytical " << this->analyticalSum
+	           << " vs cycle " << this->cycleSum << " cycles (" << totalError << "%) | mean abs error " << meanError
+	           << "% | max abs error " << 100.0 * this->maxAbsError << "% (" << this->maxErrorCycles << " cycles)";
+}
+
+uint8_t* MMIODevice::translate(uint32_t _addr, uint32_t _bytes) const {
+	for (const auto& region : this->regions) {
+		if (_addr < region.baseAddr) continue;
+		uint32_t offset = _addr - region.baseAddr;
+		if (offset + _bytes <= region.mem->getSize()) return (uint8_t*)region.mem->getMemPtr() + offset;
+	}
+	ASSERT_MSG(false, "The device accesses an address outside of the mapped memories.");
+	return nullptr;
+}
+
+void MMIODevice::memReadReqHandler(acalsim::Tick _when, MemReadReqPacket* _memReqPkt) {
+	instr      i        = _memReqPkt->getInstr();
+	instr_type op       = _memReqPkt->getOP();
+	uint32_t   offset   = _memReqPkt->getAddr() - this->baseAddr;
+	operand    a1       = _memReqPkt->getA1();
+	auto       callback = _memReqPkt->getCallback();
+
+	uint32_t word = this->readReg(_when, offset & ~3u) >> ((offset & 3u) * 8);
+	uint32_t ret  = 0;
+	switch (op) {
+		case LB: ret = static_cast<uint32_t>(static_cast<int8_t>(word)); break;
+		case LBU: ret = static_cast<uint8_t>(word); break;
+		case LH: ret = static_cast<uint32_t>(static_cast<int16_t>(word)); break;
+		case LHU: ret = static_cast<uint16_t>(word); break;
+		default: ret = word; break;
+	}
+
+	auto               rc      = acalsim::top->getRecycleContainer();
+	MemReadRespPacket* respPkt = rc->acquire<MemReadRespPacket>(&MemReadRespPacket::renew, i, op, ret, a1);
+	rc->recycle(_memReqPkt);
+
+	if (callback) {
+		callback(respPkt);
+	} else {
+		rc->recycle(respPkt);
+	}
+}
+
+void MMIODevice::memWriteReqHandler(acalsim::Tick _when, MemWriteReqPacket* _memReqPkt) {
+	instr    i        = _memReqPkt->getInstr();
+	uint32_t offset   = _memReqPkt->getAddr() - this->baseAddr;
+	uint32_t data     = _memReqPkt->getData();
+	auto     callback = _memReqPkt->getCallback();
+
+	uint32_t mask = 0xffffffffu;
+	switch (_memReqPkt->getOP()) {
+		case SB: mask = 0xffu; break;
+		case SH: mask = 0xffffu; break;
+		default: break;
+	}
+
+	// Merge sub-word writes into the current register value
+	uint32_t shift = (offset & 3u) * 8;
+	uint32_t word  = offset & ~3u;
+	uint32_t value = data;
+	if (mask != 0xffffffffu) value = (this->readReg(_when, word) & ~(mask << shift)) | ((data & mask) << shift);
+	this->writeReg(_when, word, value);
+
+	auto                rc      = acalsim::top->getRecycleContainer();
+	MemWriteRespPacket* respPkt = rc->acquire<MemWriteRespPacket>(&MemWriteRespPacket::renew, i);
+	rc->recycle(_memReqPkt);
+
+	if (callback) {
+		callback(respPkt);
+	} else {
+		rc->recycle(respPkt);
+	}
+}
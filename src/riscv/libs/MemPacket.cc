@@ -16,7 +16,10 @@
 
 #include "MemPacket.hh"
 
+#include "CPU.hh"
+#include "DataCache.hh"
 #include "DataMemory.hh"
+#include "MMIODevice.hh"
 
 void MemReadRespPacket::renew(const instr& _i, instr_type _op, uint32_t _data, operand _a1) {
 	this->acalsim::SimPacket::renew();
@@ -34,16 +37,21 @@ void MemReadReqPacket::renew(std::function<void(MemReadRespPacket*)> _callback,
 	this->op       = _op;
 	this->addr     = _addr;
 	this->a1       = _a1;
+	this->pc       = 0;
+	this->data     = 0;
+	this->hartId   = 0;
+	this->bytes    = 4;
 }
 
 void MemReadReqPacket::visit(acalsim::Tick _when, acalsim::SimModule& _module) {
-	if (auto dm = dynamic_cast<DataMemory*>(&_module)) {
-		dm->memReadReqHandler(_when, this);
-	} else {
-		CLASS_ERROR << "Invalid module type!";
-	}
+	CLASS_ERROR << "MemReadReqPacket is delivered with a typed visit() or visitMemoryTarget()!";
 }
 
+#define SOC_DEFINE_VISIT(_type) \
+	void MemReadReqPacket::visit(acalsim::Tick _when, _type& _target) { _target.memReadReqHandler(_when, this); }
+SOC_MEMORY_TARGETS(SOC_DEFINE_VISIT)
+#undef SOC_DEFINE_VISIT
+
 void MemReadReqPacket::visit(acalsim::Tick _when, acalsim::SimBase& _simulator) {
 	CLASS_ERROR << "void MemReadReqPacket::visit (SimBase& simulator) is not implemented yet!";
 }
@@ -61,32 +69,54 @@ void MemWriteReqPacket::renew(std::function<void(MemWriteRespPacket*)> _callback
 	this->op       = _op;
 	this->addr     = _addr;
 	this->data     = _data;
+	this->pc       = 0;
 }
 
 void MemWriteReqPacket::visit(acalsim::Tick _when, acalsim::SimModule& _module) {
-	if (auto dm = dynamic_cast<DataMemory*>(&_module)) {
-		dm->memWriteReqHandler(_when, this);
-	} else {
-		CLASS_ERROR << "Invalid module type!";
-	}
+	CLASS_ERROR << "MemWriteReqPacket is delivered with a typed visit() or visitMemoryTarget()!";
 }
 
+#define SOC_DEFINE_VISIT(_type) \
+	void MemWriteReqPacket::visit(acalsim::Tick _when, _type& _target) { _target.memWriteReqHandler(_when, this); }
+SOC_MEMORY_TARGETS(SOC_DEFINE_VISIT)
+#undef SOC_DEFINE_VISIT
+
 void MemWriteReqPacket::visit(acalsim::Tick _when, acalsim::SimBase& _simulator) {
 	CLASS_ERROR << "void MemWriteReqPacket::visit (SimBase& simulator) is not implemented yet!";
 }
 
 void MemReadRespPacket::visit(acalsim::Tick _when, acalsim::SimModule& _module) {
-	CLASS_ERROR << "void MemReadRespPacket::visit (SimModule& module) is not implemented yet!";
+	CLASS_ERROR << "MemReadRespPacket is delivered with a typed visit()!";
 }
 
+void MemReadRespPacket::visit(acalsim::Tick _when, CPU& _cpu) { _cpu.memReadRespHandler(_when, this); }
+
 void MemReadRespPacket::visit(acalsim::Tick _when, acalsim::SimBase& _simulator) {
 	CLASS_ERROR << "void MemReadRespPacket::visit (SimBase& simulator) is not implemented yet!";
 }
 
 void MemWriteRespPacket::visit(acalsim::Tick _when, acalsim::SimModule& _module) {
-	CLASS_ERROR << "void MemWriteRespPacket::visit (SimModule& module) is not implemented yet!";
+	CLASS_ERROR << "MemWriteRespPacket is delivered with a typed visit()!";
 }
 
+void MemWriteRespPacket::visit(acalsim::Tick _when, CPU& _cpu) { _cpu.memWriteRespHandler(_when, this); }
+
 void MemWriteRespPacket::visit(acalsim::Tick _when, acalsim::SimBase& _simulator) {
 	CLASS_ERROR << "void MemWriteRespPacket::visit (SimBase& simulator) is not implemented yet!";
 }
+
+void visitMemoryTarget(acalsim::Tick _when, acalsim::SimPacket& _pkt, bool _isWrite, MemoryTarget _kind,
+                       acalsim::SimModule& _module) {
+	switch (_kind) {
+#define SOC_VISIT_TARGET(_type)                                                               \
+	case MemoryTarget::_type:                                                                 \
+		if (_isWrite) {                                                                       \
+			static_cast<MemWriteReqPacket&>(_pkt).visit(_when, static_cast<_type&>(_module)); \
+		} else {                                                                              \
+			static_cast<MemReadReqPacket&>(_pkt).visit(_when, static_cast<_type&>(_module));  \
+		}                                                                                     \
+		break;
+		SOC_MEMORY_TARGETS(SOC_VISIT_TARGET)
+#undef SOC_VISIT_TARGET
+	}
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PCProfiler.hh"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+
+void PCProfiler::finish(acalsim::Tick _tick) {
+	if (this->last == kNone) return;
+	acalsim::Tick gap = _tick > this->lastTick ? _tick - this->lastTick : 1;
+	this->cycles[this->last] += gap;
+	this->stalls[this->last] += gap - 1;
+	this->last = kNone;
+}
+
+void PCProfiler::merge(const PCProfiler& _other) {
+	for (size_t i = 0; i < this->execCnt.size(); i++) {
+		this->execCnt[i] += _other.execCnt[i];
+		this->cycles[i] += _other.cycles[i];
+		this->stalls[i] += _other.stalls[i];
+	}
+	this->skipped += _other.skipped;
+}
+
+void PCProfiler::writeReport(const std::string& _path, const std::string& _asmPath, const instr* _imem,
+                             uint32_t _topN) const {
+	std::ofstream out(_path);
+	if (!out) {
+		ERROR << "Cannot open the PC profile file " << _path;
+		return;
+	}
+
+	uint64_t totalCycles = std::accumulate(this->cycles.begin(), this->cycles.end(), (uint64_t)0);
+	uint64_t totalStalls = std::accumulate(this->stalls.begin(), this->stalls.end(), (uint64_t)0);
+	auto     share       = [totalCycles](uint64_t _cycles) {
+		return totalCycles ? 100.0 * _cycles / totalCycles : 0.0;
+	};
+
+	out << "# " << totalCycles << " cycles, " << totalStalls << " of them stalls";
+	if (this->skipped) out << ", " << this->skipped << " cycles of fast-forwarded idle loops not attributed";
+	out << "\n" << std::fixed << std::setprecision(2);
+
+	// Top-N instructions by cycles
+	std::vector<size_t> order;
+	for (size_t i = 0; i < this->cycles.size(); i++) {
+		if (this->execCnt[i]) order.push_back(i);
+	}
+	std::stable_sort(order.begin(), order.end(),
+	                 [this](size_t _a, size_t _b) { return this->cycles[_a] > this->cycles[_b]; });
+	if (order.size() > _topN) order.resize(_topN);
+
+	out << "\n# Top " << order.size() << " instructions by cycles\n";
+	out << std::setw(6) << "rank" << std::setw(10) << "pc" << std::setw(7) << "line" << std::setw(12) << "count"
+	    << std::setw(12) << "cycles" << std::setw(12) << "stalls" << std::setw(8) << "cpi" << std::setw(9) << "%cycles"
+	    << "  instruction\n";
+	for (size_t rank = 0; rank < order.size(); rank++) {
+		size_t       i   = order[rank];
+		const instr& ins = _imem[i];
+		out << std::setw(6) << rank + 1 << std::setw(10) << i * 4 << std::setw(7) << ins.orig_line << std::setw(12)
+		    << this->execCnt[i] << std::setw(12) << this->cycles[i] << std::setw(12) << this->stalls[i]
+		    << std::setw(8) << (double)this->cycles[i] / this->execCnt[i] << std::setw(9) << share(this->cycles[i])
+		    << "  " << (ins.psrc ? ins.psrc : "") << "\n";
+	}
+
+	// Annotated listing, pseudoinstructions add up the counters of all their instructions
+	std::ifstream src(_asmPath);
+	if (!src) {
+		ERROR << "Cannot open " << _asmPath << " for the annotated listing";
+		return;
+	}
+	std::vector<std::string> lines;
+	for (std::string line; std::getline(src, line);) { lines.push_back(line); }
+
+	std::vector<uint64_t> lineCnt(lines.size() + 1, 0), lineCycles(lines.size() + 1, 0),
+	    lineStalls(lines.size() + 1, 0);
+	for (size_t i = 0; i < this->execCnt.size(); i++) {
+		int line = _imem[i].orig_line;
+		if (line <= 0 || line > (int)lines.size()) continue;
+		// A line executes as often as the most executed of its instructions
+		lineCnt[line] = std::max(lineCnt[line], this->execCnt[i]);
+		lineCycles[line] += this->cycles[i];
+		lineStalls[line] += this->stalls[i];
+	}
+
+	out << "\n# Annotated listing of " << _asmPath << "\n";
+	out << std::setw(7) << "line" << std::setw(12) << "count" << std::setw(12) << "cycles" << std::setw(12)
+	    << "stalls" << std::setw(9) << "%cycles" << " | source\n";
+	for (size_t line = 1; line <= lines.size(); line++) {
+		out << std::setw(7) << line;
+		if (lineCycles[line]) {
+			out << std::setw(12) << lineCnt[line] << std::setw(12) << lineCycles[line] << std::setw(12)
+			    << lineStalls[line] << std::setw(9) << share(lineCycles[line]);
+		} else {
+			out << std::setw(45) << "";
+		}
+		out << " | " << lines[line - 1] << "\n";
+	}
+}
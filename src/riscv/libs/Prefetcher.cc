@@ -0,0 +1,109 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Prefetcher.hh"
+
+#include <algorithm>
+
+#include "ACALSim.hh"
+
+std::unique_ptr<Prefetcher> Prefetcher::create(const std::string& _type, uint32_t _lineSize, uint32_t _degree,
+                                               uint32_t _distance, uint32_t _tableSize) {
+	if (_type == "none") return nullptr;
+	if (_type == "next_line") return std::make_unique<NextLinePrefetcher>(_lineSize, _degree, _distance);
+	if (_type == "stride") return std::make_unique<StridePrefetcher>(_lineSize, _degree, _distance, _tableSize);
+	ASSERT_MSG(_type == "stream",
+	           "Unknown prefetcher type, expected \"none\", \"next_line\", \"stride\" or \"stream\".");
+	return std::make_unique<StreamPrefetcher>(_lineSize, _degree, _distance, _tableSize);
+}
+
+void NextLinePrefetcher::notify(uint32_t _pc, uint32_t _addr, bool _trigger, std::vector<uint32_t>& _candidates) {
+	if (!_trigger) return;
+
+	uint32_t lineAddr = this->getLineAddr(_addr);
+	for (uint32_t k = 0; k < this->degree; k++) {
+		uint64_t candidate = lineAddr + (uint64_t)(this->distance + k) * this->lineSize;
+		if (candidate >= kAddressSpace) break;
+		_candidates.push_back(candidate);
+	}
+}
+
+void StridePrefetcher::notify(uint32_t _pc, uint32_t _addr, bool _trigger, std::vector<uint32_t>& _candidates) {
+	Entry& entry = this->table[(_pc / 4) % this->table.size()];
+
+	if (!entry.valid || entry.pc != _pc) {
+		entry = Entry{true, _pc, _addr, 0, 0};
+		return;
+	}
+
+	int32_t stride = static_cast<int32_t>(_addr - entry.lastAddr);
+	if (stride == entry.stride) {
+		if (entry.confidence < 3) entry.confidence++;
+	} else if (entry.confidence > 0) {
+		entry.confidence--;
+	} else {
+		entry.stride = stride;
+	}
+	entry.lastAddr = _addr;
+
+	if (entry.confidence < 2 || entry.stride == 0) return;
+
+	uint32_t lastLine = this->getLineAddr(_addr);
+	for (uint32_t k = 0; k < this->degree; k++) {
+		int64_t target = (int64_t)_addr + (int64_t)entry.stride * (this->distance + k);
+		// Later candidates only move further past the end of the address space
+		if (target < 0 || target >= (int64_t)kAddressSpace) break;
+		uint32_t lineAddr = this->getLineAddr((uint32_t)target);
+		// Strides smaller than a line map several prefetches to the same line
+		if (lineAddr == lastLine) continue;
+		_candidates.push_back(lineAddr);
+		lastLine = lineAddr;
+	}
+}
+
+void StreamPrefetcher::notify(uint32_t _pc, uint32_t _addr, bool _trigger, std::vector<uint32_t>& _candidates) {
+	if (!_trigger) return;
+
+	uint32_t lineAddr = this->getLineAddr(_addr);
+	Stream*  stream   = nullptr;
+	for (auto& s : this->streams) {
+		if (s.valid && lineAddr >= s.head && lineAddr < s.nextLine) {
+			stream = &s;
+			break;
+		}
+	}
+
+	if (!stream) {
+		// Allocate a new stream in the least recently used buffer
+		stream = &this->streams[0];
+		for (auto& s : this->streams) {
+			if (!s.valid) {
+				stream = &s;
+				break;
+			}
+			if (s.lastUse < stream->lastUse) stream = &s;
+		}
+		stream->valid    = true;
+		stream->nextLine = lineAddr + (uint64_t)this->distance * this->lineSize;
+	}
+	stream->head    = (uint64_t)lineAddr + this->lineSize;
+	stream->lastUse = ++this->useCnt;
+
+	// Keep the stream degree lines ahead of the access, without wrapping past the address space
+	uint64_t limit = lineAddr + (uint64_t)(this->distance + this->degree) * this->lineSize;
+	limit          = std::min(limit, kAddressSpace);
+	for (; stream->nextLine < limit; stream->nextLine += this->lineSize) { _candidates.push_back(stream->nextLine); }
+}
@@ -16,9 +16,22 @@
 
 #include "SOC.hh"
 
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include "BinaryTrace.hh"
+#include "KonataTrace.hh"
 #include "event/ExecOneInstrEvent.hh"
 
-SOC::SOC(std::string _name) : acalsim::CPPSimBase(_name) {}
+SOC::SOC(std::string _name)
+    : acalsim::CPPSimBase(_name), coherence(nullptr), spm(nullptr), dma(nullptr), sa(nullptr), interruptCnt(0) {
+	// Created before the cores since SOCTop hands them to the pipeline stages right after the SOC
+	if (!acalsim::top->getParameter<std::string>("SOC", "cpi_stack").empty()) {
+		this->cycleStacks.resize(acalsim::top->getParameter<int>("SOC", "num_cores"));
+	}
+}
 
 void SOC::registerModules() {
 	// Get the maximal memory footprint size in the Emulator Configuration
@@ -30,16 +43,100 @@ void SOC::registerModules() {
 	// Instruction Set Architecture Emulator (Functional Model)
 	this->isaEmulator = new Emulator("RISCV RV32I Emulator");
 
-	// CPU Timing Model
-	this->cpu = new CPU("Single-Cycle CPU Model", this);
+	// System bus between the masters and the data memory and devices. Masters are added in the order of
+	// their priority: cores by hart ID, data caches by hart ID, DMA engine
+	this->bus = new Bus("System Bus");
+	this->bus->addTarget("RAM", 0, mem_size, this->dmem);
+	this->bus->setRetryHandler([this](const std::string& _port) { this->masterPortRetry(_port); });
 
 	// register modules
-	this->addModule(this->cpu);
+	this->addModule(this->bus);
 	this->addModule(this->dmem);
 
 	// connect modules (connected_module, master port name, slave port name)
-	this->cpu->addDownStream(this->dmem, "DSDmem");
-	this->dmem->addUpStream(this->cpu, "USCPU");
+	this->bus->addDownStream(this->dmem, "DSDmem");
+	this->dmem->addUpStream(this->bus, "USBus");
+
+	// CPU Timing Models, one per core. SOCTop gives every core its own pipeline stage simulators
+	// unless SOC.pipeline_models is off.
+	uint32_t numCores       = acalsim::top->getParameter<int>("SOC", "num_cores");
+	uint32_t cpuOutstanding = acalsim::top->getParameter<int>("SOC", "cpu_max_outstanding");
+	ASSERT_MSG(numCores > 0, "The SOC needs at least one CPU core.");
+	for (uint32_t hartId = 0; hartId < numCores; hartId++) {
+		std::string id  = std::to_string(hartId);
+		CPU*        cpu = new CPU("Single-Cycle CPU Model " + id, this, hartId);
+		cpu->setBus(this->bus, this->bus->addMaster("CPU " + id, "cpu" + id + "-bus-m", cpuOutstanding));
+		// SOCTop has added the port to the IF stage before the simulators are initialized
+		if (acalsim::top->getParameter<int>("SOC", "pipeline_models")) {
+			cpu->setIFPort(this->getMasterPort(SOC::getIFPortName(hartId)));
+		}
+		this->addModule(cpu);
+
+		cpu->addDownStream(this->bus, "DSBus");
+		this->bus->addUpStream(cpu, "USCPU" + id);
+		this->cpus.push_back(cpu);
+	}
+
+	// Non-blocking private L1 data cache between every core and the data memory (optional). With more
+	// than one core the caches snoop each other's bus requests to stay coherent.
+	if (acalsim::top->getParameter<int>("DataCache", "enable")) {
+		uint32_t mshrs = acalsim::top->getParameter<int>("DataCache", "mshr_count");
+		if (numCores > 1) {
+			this->coherence = new Coherence(acalsim::top->getParameter<std::string>("DataCache", "coherence"));
+		}
+		for (auto cpu : this->cpus) {
+			std::string id     = std::to_string(cpu->getHartId());
+			DataCache*  dcache = new DataCache("L1 Data Cache " + id, this->dmem);
+			this->addModule(dcache);
+
+			cpu->addDownStream(dcache, "DSDcache");
+			dcache->addUpStream(cpu, "USCPU");
+			dcache->addDownStream(this->bus, "DSBus");
+			this->bus->addUpStream(dcache, "USDcache" + id);
+			dcache->setBus(this->bus, this->bus->addMaster("Data Cache " + id, "dcache" + id + "-bus-m", mshrs));
+			if (this->coherence) dcache->setCoherence(this->coherence);
+			cpu->setDataCache(dcache);
+			this->dcaches.push_back(dcache);
+		}
+	}
+
+	// Banked internal buffer, reachable by the devices only
+	uint32_t buffer_addr = acalsim::top->getParameter<int>("SOC", "buffer_addr");
+	uint32_t buffer_size = acalsim::top->getParameter<int>("SOC", "buffer_size");
+	this->spm            = new Scratchpad("Scratchpad", buffer_addr, buffer_size);
+	this->addModule(this->spm);
+
+	// DMA engine moving data between the data memory and the internal buffer (optional)
+	if (acalsim::top->getParameter<int>("DMA", "enable")) {
+		this->dma = new DMA("DMA Engine", acalsim::top->getParameter<int>("DMA", "base_addr"));
+		this->dma->mapMemory(0, this->dmem);
+		this->dma->setDataMemory(this->dmem);
+		this->dma->mapMemory(buffer_addr, this->spm);
+		this->dma->setScratchpad(this->spm, 0);
+		uint32_t dmaOutstanding = acalsim::top->getParameter<int>("DMA", "max_outstanding");
+		this->dma->setBus(this->bus, this->bus->addMaster("DMA", "dma-bus-m", dmaOutstanding));
+		this->addDevice(this->dma);
+	}
+
+	// Systolic array operating on matrices in the internal buffer (optional)
+	if (acalsim::top->getParameter<int>("SystolicArray", "enable")) {
+		this->sa = new SystolicArray("Systolic Array", acalsim::top->getParameter<int>("SystolicArray", "base_addr"));
+		this->sa->mapMemory(buffer_addr, this->spm);
+		this->sa->setScratchpad(this->spm, 1);
+		this->addDevice(this->sa);
+	}
+
+	// One scoreboard orders the commands of all devices. The CPU has no trap support, interrupts are
+	// only recorded
+	for (auto device : this->devices) {
+		device->setScoreboard(&this->scoreboard);
+		this->scoreboard.addDevice(device);
+		device->setInterruptHandler([this](MMIODevice* _device) {
+			this->interruptCnt++;
+			CLASS_INFO << "Interrupt from the device at 0x" << std::hex << _device->getBaseAddr() << std::dec
+			           << " at Tick = " << acalsim::top->getGlobalTick();
+		});
+	}
 }
 
 void SOC::simInit() {
@@ -49,23 +146,192 @@ void SOC::simInit() {
 	// Parse assmebly file and initialize data memory and instruction memory
 	std::string asm_file_path = acalsim::top->getParameter<std::string>("Emulator", "asm_file_path");
 
-	this->isaEmulator->parse(asm_file_path, ((uint8_t*)this->dmem->getMemPtr()), this->cpu->getIMemPtr());
-	this->isaEmulator->normalize_labels(this->cpu->getIMemPtr());
+	// All cores run the same program, it is parsed into the instruction memory of core 0
+	instr* imem = this->cpus[0]->getIMemPtr();
+	this->isaEmulator->parse(asm_file_path, ((uint8_t*)this->dmem->getMemPtr()), imem);
+	this->isaEmulator->normalize_labels(imem);
+	auto data_offset = acalsim::top->getParameter<int>("Emulator", "data_offset");
+	for (size_t i = 1; i < this->cpus.size(); i++) {
+		std::copy(imem, imem + data_offset / 4, this->cpus[i]->getIMemPtr());
+	}
+
+	// The n-th entry point label is where the core with hart ID n starts
+	std::stringstream entries(acalsim::top->getParameter<std::string>("Emulator", "entry_points"));
+	std::string       label;
+	for (uint32_t hartId = 0; hartId < this->cpus.size() && std::getline(entries, label, ','); hartId++) {
+		label.erase(std::remove_if(label.begin(), label.end(), ::isspace), label.end());
+		if (label.empty()) continue;
+		int entry = this->isaEmulator->find_label(label);
+		ASSERT_MSG(entry >= 0, "An entry point label is not defined in the program.");
+		this->cpus[hartId]->setEntryPoint(entry);
+	}
 
 	// Initialize all child modules
 	for (auto& [_, module] : this->modules) { module->init(); }
 
-	// Inject trigger event
-	auto               rc    = acalsim::top->getRecycleContainer();
-	ExecOneInstrEvent* event = rc->acquire<ExecOneInstrEvent>(&ExecOneInstrEvent::renew, 1 /*id*/, this->cpu);
-	this->scheduleEvent(event, acalsim::top->getGlobalTick() + 1);
+	// Binary trace of the cores and their pipeline stages, decoded offline by scripts/riscv_trace_decode.py
+	std::string tracePath = acalsim::top->getParameter<std::string>("SOC", "binary_trace");
+	if (!tracePath.empty()) {
+		std::vector<std::string> opNames;
+		for (int op = UNIMPL; op <= HCF; op++) { opNames.push_back(CPU::instrToString((instr_type)op)); }
+		BinaryTrace::open(tracePath, opNames);
+	}
+
+	// Pipeline occupancy trace of the stage models for the Konata viewer
+	std::string konataPath = acalsim::top->getParameter<std::string>("SOC", "konata_trace");
+	if (!konataPath.empty()) {
+		ASSERT_MSG(acalsim::top->getParameter<int>("SOC", "pipeline_models"),
+		           "konata_trace needs the pipeline stage models, set pipeline_models = 1.");
+		KonataTrace::open(konataPath, this->cpus.size());
+	}
+
+	this->setupIntervalStats();
+
+	// Inject trigger events, one per core
+	auto rc = acalsim::top->getRecycleContainer();
+	for (auto cpu : this->cpus) {
+		ExecOneInstrEvent* event =
+		    rc->acquire<ExecOneInstrEvent>(&ExecOneInstrEvent::renew, cpu->getHartId() + 1 /*id*/, cpu);
+		this->scheduleEvent(event, acalsim::top->getGlobalTick() + 1);
+	}
 }
 
 void SOC::cleanup() {
-	this->cpu->printRegfile();
+	BinaryTrace::close();
+	KonataTrace::close();
+	for (auto cpu : this->cpus) {
+		cpu->printRegfile();
+		cpu->printStats();
+	}
+	for (auto dcache : this->dcaches) { dcache->printStats(); }
+	if (this->coherence) this->coherence->printStats();
+	this->dmem->printStats();
+	this->bus->printStats();
+	if (this->dma) this->dma->printStats();
+	if (this->sa) this->sa->printStats();
+	this->spm->printStats();
+	this->scoreboard.printStats();
+	if (this->interruptCnt) CLASS_INFO << "Device interrupts: " << this->interruptCnt;
+	if (!this->cycleStacks.empty()) this->dumpCycleStacks();
+	this->dumpPCProfile();
+	if (this->intervalStats) {
+		this->intervalStats->finish(acalsim::top->getGlobalTick());
+		delete this->intervalStats;
+		this->intervalStats = nullptr;
+	}
 	CLASS_INFO << "SOC::cleanup() ";
 }
 
+void SOC::dumpCycleStacks() {
+	for (auto cpu : this->cpus) { cpu->accountCycles(this->cycleStacks[cpu->getHartId()]); }
+
+	std::string   path = acalsim::top->getParameter<std::string>("SOC", "cpi_stack");
+	std::ofstream out(path);
+	if (!out) {
+		CLASS_ERROR << "Cannot open the CPI stack file " << path;
+		return;
+	}
+
+	bool csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+	if (csv) out << "hart,cycles,instructions,cpi,base,data_hazard,control_hazard,structural,memory,idle\n";
+
+	nlohmann::json cores = nlohmann::json::array();
+	for (uint32_t hartId = 0; hartId < this->cycleStacks.size(); hartId++) {
+		const CycleStack& stack = this->cycleStacks[hartId];
+		double            cpi   = stack.instructions ? (double)stack.cycles / stack.instructions : 0.0;
+		if (csv) {
+			out << hartId << "," << stack.cycles << "," << stack.instructions << "," << cpi << "," << stack.base()
+			    << "," << stack.dataHazard << "," << stack.controlHazard << "," << stack.structural << ","
+			    << stack.memory << "," << stack.idle << "\n";
+			continue;
+		}
+
+		nlohmann::json core;
+		core["hart"]                    = hartId;
+		core["cycles"]                  = stack.cycles;
+		core["instructions"]            = stack.instructions;
+		core["cpi"]                     = cpi;
+		core["stack"]["base"]           = stack.base();
+		core["stack"]["data_hazard"]    = stack.dataHazard;
+		core["stack"]["control_hazard"] = stack.controlHazard;
+		core["stack"]["structural"]     = stack.structural;
+		core["stack"]["memory"]         = stack.memory;
+		core["stack"]["idle"]           = stack.idle;
+		cores.push_back(core);
+	}
+	if (!csv) {
+		nlohmann::json root;
+		root["cores"] = cores;
+		out << root.dump(4) << "\n";
+	}
+	CLASS_INFO << "CPI stack written to " << path;
+}
+
+void SOC::dumpPCProfile() {
+	std::string path = acalsim::top->getParameter<std::string>("SOC", "pc_profile");
+	if (path.empty()) return;
+
+	// All cores run the same program, so their profiles add up PC by PC
+	PCProfiler* total = nullptr;
+	for (auto cpu : this->cpus) {
+		PCProfiler* profile = cpu->finishProfile();
+		if (!total) {
+			total = profile;
+		} else {
+			total->merge(*profile);
+		}
+	}
+	total->writeReport(path, acalsim::top->getParameter<std::string>("Emulator", "asm_file_path"),
+	                   this->cpus[0]->getIMemPtr(), acalsim::top->getParameter<int>("SOC", "pc_profile_top"));
+	CLASS_INFO << "PC profile written to " << path;
+}
+
+void SOC::setupIntervalStats() {
+	acalsim::Tick interval = acalsim::top->getParameter<int>("SOC", "stats_interval");
+	if (!interval) return;
+
+	std::string path    = acalsim::top->getParameter<std::string>("SOC", "stats_file");
+	this->intervalStats = new IntervalStats(path, interval);
+	for (auto cpu : this->cpus) {
+		cpu->addIntervalStats(*this->intervalStats, "cpu" + std::to_string(cpu->getHartId()) + ".");
+	}
+	for (size_t hartId = 0; hartId < this->dcaches.size(); hartId++) {
+		this->dcaches[hartId]->addIntervalStats(*this->intervalStats, "dcache" + std::to_string(hartId) + ".");
+	}
+	this->bus->addIntervalStats(*this->intervalStats, "bus.");
+	if (this->dma) this->dma->addIntervalStats(*this->intervalStats, "dma.");
+	if (this->sa) this->sa->addIntervalStats(*this->intervalStats, "sa.");
+	if (this->spm) this->spm->addIntervalStats(*this->intervalStats, "spm.");
+	CLASS_INFO << "Interval statistics every " << interval << " ticks written to " << path;
+}
+
+void SOC::addDevice(MMIODevice* _device) {
+	this->bus->addTarget(_device->getName(), _device->getBaseAddr(), _device->getSize(), _device, _device);
+	this->devices.push_back(_device);
+	this->addModule(_device);
+
+	// Devices are reached through the bus
+	this->bus->addDownStream(_device, "DS" + _device->getName());
+	_device->addUpStream(this->bus, "USBus");
+}
+
+MMIODevice* SOC::findDevice(uint32_t _addr) const {
+	const Bus::Target* target = this->bus->decode(_addr);
+	return target ? target->device : nullptr;
+}
+
+bool SOC::hasBusTraffic(const CPU* _cpu) const {
+	auto running = [_cpu](const CPU* _other) { return _other != _cpu && !_other->isHalted(); };
+	auto moving  = [](const MMIODevice* _device) { return _device->isBusActive(); };
+	return std::any_of(this->cpus.begin(), this->cpus.end(), running) ||
+	       std::any_of(this->devices.begin(), this->devices.end(), moving);
+}
+
 void SOC::masterPortRetry(const std::string& port_name) {
-	if (port_name == "sIF-m") { this->cpu->retrySendInstPacket(this->getMasterPort("sIF-m")); }
+	for (auto cpu : this->cpus) {
+		if (port_name == cpu->getIFPortName()) { cpu->retrySendInstPacket(this->getMasterPort(port_name)); }
+	}
+	// The bus retries a master that hit its outstanding limit. The CPU and the data cache check the
+	// limit before they send, so only the DMA engine is ever refused.
+	if (port_name == "dma-bus-m") { this->dma->retryBusRequests(acalsim::top->getGlobalTick()); }
 }
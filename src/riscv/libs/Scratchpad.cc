@@ -0,0 +1,125 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Scratchpad.hh"
+
+#include <algorithm>
+
+Scratchpad::Scratchpad(std::string _name, uint32_t _baseAddr, size_t _size)
+    : acalsim::SimModule(_name), BaseMemory(_size), baseAddr(_baseAddr) {
+	uint32_t banks  = acalsim::top->getParameter<int>("Scratchpad", "banks");
+	uint32_t ports  = acalsim::top->getParameter<int>("Scratchpad", "ports");
+	this->bankWidth = acalsim::top->getParameter<int>("Scratchpad", "bank_width");
+	this->latency   = acalsim::top->getParameter<acalsim::Tick>("Scratchpad", "latency");
+	ASSERT_MSG(banks > 0 && ports > 0 && this->bankWidth > 0, "The scratchpad needs at least one bank and one port.");
+	ASSERT_MSG(_size % (banks * this->bankWidth) == 0, "The scratchpad size must be a multiple of banks x bank_width.");
+	this->wordsPerBank = _size / this->bankWidth / banks;
+
+	std::string interleave = acalsim::top->getParameter<std::string>("Scratchpad", "interleave");
+	ASSERT_MSG(interleave == "word" || interleave == "xor" || interleave == "block",
+	           "Scratchpad interleave must be \"word\", \"xor\" or \"block\".");
+	if (interleave == "xor") {
+		this->interleave = Interleave::XOR;
+	} else if (interleave == "block") {
+		this->interleave = Interleave::BLOCK;
+	} else {
+		this->interleave = Interleave::WORD;
+	}
+
+	this->bankFree.assign(banks, 0);
+	this->bankLoad.assign(banks, 0);
+	this->bankWords.assign(banks, 0);
+	this->ports.resize(ports);
+}
+
+uint32_t Scratchpad::getBank(uint32_t _word) const {
+	uint32_t banks = this->bankFree.size();
+	switch (this->interleave) {
+		case Interleave::XOR: return (_word ^ (_word / banks)) % banks;
+		case Interleave::BLOCK: return _word / this->wordsPerBank;
+		default: return _word % banks;
+	}
+}
+
+acalsim::Tick Scratchpad::access(acalsim::Tick _when, uint32_t _port, uint32_t _addr, uint32_t _bytes,
+                                 bool _isWrite) {
+	ASSERT_MSG(_bytes && this->contains(_addr) && this->contains(_addr + _bytes - 1),
+	           "The scratchpad access falls outside of the scratchpad.");
+
+	Port&         port  = this->ports[_port % this->ports.size()];
+	acalsim::Tick start = std::max(_when, port.freeTick);
+	port.requests++;
+	port.waitCycles += start - _when;
+	if (_isWrite) {
+		this->writes++;
+	} else {
+		this->reads++;
+	}
+
+	// Words of the request are issued serially within a bank and in parallel across banks
+	uint32_t first = (_addr - this->baseAddr) / this->bankWidth;
+	uint32_t last  = (_addr - this->baseAddr + _bytes - 1) / this->bankWidth;
+	uint32_t count = last - first + 1;
+	for (uint32_t word = first; word <= last; word++) { this->bankLoad[this->getBank(word)]++; }
+
+	uint32_t      maxLoad = 0;
+	acalsim::Tick end     = start;
+	for (uint32_t bank = 0; bank < this->bankFree.size(); bank++) {
+		uint32_t load = this->bankLoad[bank];
+		if (!load) continue;
+		acalsim::Tick begin  = std::max(start, this->bankFree[bank]);
+		this->bankFree[bank] = begin + load;
+		this->bankLoad[bank] = 0;
+		maxLoad              = std::max(maxLoad, load);
+		end                  = std::max(end, begin + load);
+		this->bankWords[bank] += load;
+	}
+
+	uint32_t ideal = (count + this->bankFree.size() - 1) / this->bankFree.size();
+	this->words += count;
+	this->conflictCycles += maxLoad - ideal;
+	this->contentionStall += end - start - maxLoad;
+	port.freeTick = end;
+
+	return end - 1 + this->latency;
+}
+
+void Scratchpad::printStats() const {
+	acalsim::Tick now       = acalsim::top->getGlobalTick();
+	uint64_t      busiest   = *std::max_element(this->bankWords.begin(), this->bankWords.end());
+	double        avgWords  = (double)this->words / this->bankWords.size();
+	double        util      = now ? 100.0 * this->words / (now * this->bankWords.size()) : 0.0;
+	double        imbalance = avgWords ? busiest / avgWords : 0.0;
+
+	CLASS_INFO << "Scratchpad: " << this->bankWords.size() << " banks x " << this->bankWidth << " bytes, "
+	           << this->ports.size() << " ports | " << this->reads << " reads, " << this->writes << " writes, "
+	           << this->words << " words";
+	CLASS_INFO << "Scratchpad: " << this->conflictCycles << " bank conflict cycles | " << this->contentionStall
+	           << " port contention stall cycles | bank utilization " << util << "% | busiest bank "
+	           << imbalance << "x the average";
+	for (uint32_t idx = 0; idx < this->ports.size(); idx++) {
+		if (!this->ports[idx].requests) continue;
+		CLASS_INFO << "Scratchpad port " << idx << ": " << this->ports[idx].requests << " requests | "
+		           << this->ports[idx].waitCycles << " cycles waiting for the port";
+	}
+}
+
+void Scratchpad::addIntervalStats(IntervalStats& _stats, const std::string& _prefix) const {
+	_stats.addCounter(_prefix + "reads", [this] { return this->reads; });
+	_stats.addCounter(_prefix + "writes", [this] { return this->writes; });
+	_stats.addCounter(_prefix + "words", [this] { return this->words; });
+	_stats.addCounter(_prefix + "conflict_cycles", [this] { return this->conflictCycles; });
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "StageScheduler.hh"
+
+StageScheduler::StageScheduler(const std::string& _name, uint32_t _numThreads)
+    : acalsim::CPPSimBase(_name), numThreads(_numThreads), lanes(_numThreads) {
+	ASSERT_MSG(_numThreads > 0, "The stage scheduler needs at least one thread.");
+}
+
+void StageScheduler::init() {
+	for (auto& threadLanes : this->lanes) {
+		for (auto& lane : threadLanes) {
+			lane.sIF->init();
+			lane.sEXE->init();
+			lane.sWB->init();
+		}
+	}
+
+	// Threads without a lane, with more threads than cores, are not started
+	for (uint32_t threadId = 1; threadId < this->numThreads; threadId++) {
+		if (this->lanes[threadId].empty()) continue;
+		auto worker      = std::make_unique<Worker>();
+		worker->threadId = threadId;
+		worker->thread   = std::thread(&StageScheduler::workerLoop, this, worker.get());
+		this->workers.push_back(std::move(worker));
+	}
+}
+
+void StageScheduler::step() {
+	for (auto& worker : this->workers) {
+		bool sent = worker->ticks.push(true);
+		ASSERT_MSG(sent, "A stage worker received a tick before it finished the previous one.");
+		worker->ticks.publish();
+	}
+
+	bool busy = StageScheduler::stepLanes(this->lanes[0]);
+
+	for (auto& worker : this->workers) {
+		while (!worker->results.isPopValid()) { std::this_thread::yield(); }
+		busy |= worker->results.pop();
+	}
+
+	// Instructions arriving from the SOC wake the scheduler through its slave ports, everything else that
+	// is in flight between the stages needs another step
+	if (busy) this->forceStepInNextIteration();
+}
+
+void StageScheduler::cleanup() {
+	this->stopWorkers();
+	for (auto& threadLanes : this->lanes) {
+		for (auto& lane : threadLanes) {
+			lane.sIF->cleanup();
+			lane.sEXE->cleanup();
+			lane.sWB->cleanup();
+		}
+	}
+}
+
+void StageScheduler::addLane(IFStage* _sIF, EXEStage* _sEXE, WBStage* _sWB) {
+	size_t hartId = 0;
+	for (auto& threadLanes : this->lanes) { hartId += threadLanes.size(); }
+	_sIF->setScheduled();
+	this->lanes[hartId % this->numThreads].push_back({_sIF, _sEXE, _sWB});
+}
+
+bool StageScheduler::stepLanes(const std::vector<Lane>& _lanes) {
+	bool busy = false;
+	for (auto& lane : _lanes) {
+		// An idle lane is skipped like the framework skips a simulator without inbound packets. A stage
+		// that had work may have pushed to the next one, which then steps in the next tick.
+		if (!lane.sIF->hasWork() && !lane.sEXE->hasWork() && !lane.sWB->hasWork()) continue;
+		lane.sIF->step();
+		lane.sEXE->step();
+		lane.sWB->step();
+		busy = true;
+	}
+	return busy;
+}
+
+void StageScheduler::workerLoop(Worker* _worker) {
+	// The workers spin between the ticks, a tick is far too short to sleep on a condition variable
+	while (true) {
+		while (!_worker->ticks.isPopValid()) { std::this_thread::yield(); }
+		if (!_worker->ticks.pop()) return;
+
+		bool sent = _worker->results.push(StageScheduler::stepLanes(this->lanes[_worker->threadId]));
+		ASSERT_MSG(sent, "A stage worker answered a tick twice.");
+		_worker->results.publish();
+	}
+}
+
+void StageScheduler::stopWorkers() {
+	for (auto& worker : this->workers) {
+		bool sent = worker->ticks.push(false);
+		ASSERT_MSG(sent, "A stage worker was stopped in the middle of a tick.");
+		worker->ticks.publish();
+	}
+	for (auto& worker : this->workers) { worker->thread.join(); }
+	this->workers.clear();
+}
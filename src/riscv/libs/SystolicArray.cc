@@ -0,0 +1,373 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SystolicArray.hh"
+
+#include <algorithm>
+#include <cstring>
+
+#include "event/SAEvent.hh"
+
+namespace {
+
+/**
+ * @brief c[rows x cols] += a[rows x depth] * b[depth x cols] on packed row-major operands
+ * @details The innermost loop walks contiguous rows of b and c without aliasing so that it is
+ *          vectorized by the compiler.
+ */
+void macKernel(const int32_t* __restrict__ _a, const int32_t* __restrict__ _b, int32_t* __restrict__ _c,
+               uint32_t _rows, uint32_t _depth, uint32_t _cols) {
+	for (uint32_t i = 0; i < _rows; i++) {
+		int32_t* __restrict__ cRow = _c + i * _cols;
+		for (uint32_t k = 0; k < _depth; k++) {
+			const int32_t               a    = _a[i * _depth + k];
+			const int32_t* __restrict__ bRow = _b + k * _cols;
+			for (uint32_t j = 0; j < _cols; j++) { cRow[j] += a * bRow[j]; }
+		}
+	}
+}
+
+}  // namespace
+
+SystolicArray::SystolicArray(std::string _name, uint32_t _baseAddr) : MMIODevice(_name, _baseAddr, 0x100) {
+	this->arrayRows = acalsim::top->getParameter<int>("SystolicArray", "array_rows");
+	this->arrayCols = acalsim::top->getParameter<int>("SystolicArray", "array_cols");
+	ASSERT_MSG(this->arrayRows > 0 && this->arrayCols > 0, "The systolic array must have at least one PE.");
+
+	std::string dataflow = acalsim::top->getParameter<std::string>("SystolicArray", "dataflow");
+	ASSERT_MSG(dataflow == "ws" || dataflow == "os", "SystolicArray dataflow must be \"ws\" or \"os\".");
+	this->dataflow = dataflow == "ws" ? Dataflow::WS : Dataflow::OS;
+
+	// Moving the results from the PEs back to the buffer takes as many cycles as the array width by default
+	int drainLatency = acalsim::top->getParameter<int>("SystolicArray", "drain_latency");
+	ASSERT_MSG(drainLatency >= -1, "SystolicArray drain_latency must be -1 (array width) or a cycle count.");
+	this->drainLatency = drainLatency < 0 ? this->arrayCols : drainLatency;
+
+	this->queueDepth = acalsim::top->getParameter<int>("SystolicArray", "queue_depth");
+	this->setTimingModel(acalsim::top->getParameter<std::string>("SystolicArray", "timing_model"));
+}
+
+uint32_t SystolicArray::readReg(acalsim::Tick _when, uint32_t _offset) {
+	switch (_offset) {
+		case CTRL: return this->ctrl;
+		case STATUS: return this->status;
+		case A_DIMS: return this->aDims;
+		case B_DIMS: return this->bDims;
+		case C_DIMS: return this->cDims;
+		case A_ADDR: return this->aAddr;
+		case B_ADDR: return this->bAddr;
+		case C_ADDR: return this->cAddr;
+		case STRIDES: return this->strides;
+		case DONE_CNT: return this->doneCnt;
+		default: return 0;
+	}
+}
+
+void SystolicArray::writeReg(acalsim::Tick _when, uint32_t _offset, uint32_t _data) {
+	switch (_offset) {
+		case CTRL:
+			this->ctrl = _data & ~CTRL_START;
+			if (_data & CTRL_START) this->submit(_when);
+			break;
+		case STATUS:
+			// Software acknowledges a completed computation by clearing the done bit
+			this->status &= _data | STATUS_BUSY | STATUS_QUEUE_FULL;
+			break;
+		case A_DIMS: this->aDims = _data; break;
+		case B_DIMS: this->bDims = _data; break;
+		case C_DIMS: this->cDims = _data; break;
+		case A_ADDR: this->aAddr = _data; break;
+		case B_ADDR: this->bAddr = _data; break;
+		case C_ADDR: this->cAddr = _data; break;
+		case STRIDES: this->strides = _data; break;
+		default: CLASS_ERROR << "Write to an undefined systolic array register at offset " << _offset; break;
+	}
+}
+
+void SystolicArray::submit(acalsim::Tick _when) {
+	if (this->queue.size() >= this->queueDepth) {
+		CLASS_ERROR << "The systolic array command queue is full, the start command is ignored.";
+		return;
+	}
+
+	auto rows = [](uint32_t _dims) { return ((_dims >> 12) & 0xfff) + 1; };
+	auto cols = [](uint32_t _dims) { return (_dims & 0xfff) + 1; };
+
+	Command command{0, this->ctrl, this->aAddr, this->bAddr, this->cAddr, this->strides};
+	command.M = rows(this->aDims);
+	command.K = cols(this->aDims);
+	command.N = cols(this->bDims);
+	if (rows(this->bDims) != command.K || rows(this->cDims) != command.M || cols(this->cDims) != command.N) {
+		// A rejected command completes right away so that software waiting for it does not hang
+		CLASS_ERROR << "The systolic array is programmed with mismatched matrix dimensions.";
+		this->status |= STATUS_DONE | STATUS_ERROR;
+		this->doneCnt++;
+		return;
+	}
+
+	command.id = this->getScoreboard()->submit(this, this->getFootprint(command), _when);
+	this->queue.push_back(command);
+	this->issueCommands(_when);
+	this->updateStatus();
+}
+
+void SystolicArray::issueCommands(acalsim::Tick _when) {
+	if (this->running || this->queue.empty() || !this->getScoreboard()->isReady(this->queue.front().id)) return;
+
+	this->cmd     = this->queue.front();
+	this->running = true;
+	this->queue.pop_front();
+	this->getScoreboard()->start(this->cmd.id, _when);
+	this->start(_when);
+	this->updateStatus();
+}
+
+CommandScoreboard::Footprint SystolicArray::getFootprint(const Command& _cmd) const {
+	uint32_t aStride = (_cmd.strides >> 16) & 0xff;
+	uint32_t bStride = (_cmd.strides >> 8) & 0xff;
+	uint32_t cStride = _cmd.strides & 0xff;
+
+	// Weight-stationary passes also read C, which the write range covers
+	CommandScoreboard::Footprint footprint;
+	footprint.reads.push_back({_cmd.aAddr, (_cmd.M - 1) * aStride + _cmd.K * (uint32_t)sizeof(int32_t)});
+	footprint.reads.push_back({_cmd.bAddr, (_cmd.K - 1) * bStride + _cmd.N * (uint32_t)sizeof(int32_t)});
+	footprint.writes.push_back({_cmd.cAddr, (_cmd.M - 1) * cStride + _cmd.N * (uint32_t)sizeof(int32_t)});
+	return footprint;
+}
+
+void SystolicArray::updateStatus() {
+	this->status &= ~(STATUS_BUSY | STATUS_QUEUE_FULL);
+	if (this->running || !this->queue.empty()) this->status |= STATUS_BUSY;
+	if (this->queue.size() >= this->queueDepth) this->status |= STATUS_QUEUE_FULL;
+}
+
+void SystolicArray::start(acalsim::Tick _when) {
+	this->M         = this->cmd.M;
+	this->K         = this->cmd.K;
+	this->N         = this->cmd.N;
+	this->startTick = _when;
+	this->tileIdx   = 0;
+	this->runs++;
+
+	if (this->getTimingModel() != TimingModel::CYCLE) this->estimate = this->estimateCycles();
+	if (this->getTimingModel() == TimingModel::ANALYTICAL) {
+		this->endTick = _when + this->estimate;
+		this->schedule(this->endTick);
+		return;
+	}
+
+	// The PE timing of the whole computation is summed up front so that pollers know when it completes
+	uint32_t tileCount    = this->getTileCount();
+	this->remainingCycles = 0;
+	for (uint32_t idx = 0; idx < tileCount; idx++) {
+		this->remainingCycles += this->getTileCycles(this->makeTile(idx));
+	}
+
+	this->issueTile(_when);
+}
+
+void SystolicArray::issueTile(acalsim::Tick _when) {
+	Tile          tile    = this->makeTile(this->tileIdx);
+	acalsim::Tick cycles  = this->getTileCycles(tile);
+	uint32_t      aStride = (this->cmd.strides >> 16) & 0xff;
+	uint32_t      bStride = (this->cmd.strides >> 8) & 0xff;
+	uint32_t      cStride = this->cmd.strides & 0xff;
+	uint32_t      aBytes  = tile.depthLen * sizeof(int32_t);
+	uint32_t      cBytes  = tile.cols * sizeof(int32_t);
+
+	// Operands are read through the scratchpad when the tile starts
+	acalsim::Tick readEnd = _when;
+	for (uint32_t i = 0; i < tile.rows; i++) {
+		uint32_t addr = this->cmd.aAddr + (tile.row + i) * aStride + tile.depth * sizeof(int32_t);
+		readEnd       = std::max(readEnd, this->accessScratchpad(_when, addr, aBytes, false));
+	}
+	for (uint32_t k = 0; k < tile.depthLen; k++) {
+		uint32_t addr = this->cmd.bAddr + (tile.depth + k) * bStride + tile.col * sizeof(int32_t);
+		readEnd       = std::max(readEnd, this->accessScratchpad(_when, addr, cBytes, false));
+	}
+	for (uint32_t i = 0; this->dataflow == Dataflow::WS && tile.depth > 0 && i < tile.rows; i++) {
+		uint32_t addr = this->cmd.cAddr + (tile.row + i) * cStride + tile.col * sizeof(int32_t);
+		readEnd       = std::max(readEnd, this->accessScratchpad(_when, addr, cBytes, false));
+	}
+
+	// Results are written once every operand is in
+	acalsim::Tick writeEnd = readEnd;
+	for (uint32_t i = 0; i < tile.rows; i++) {
+		uint32_t addr = this->cmd.cAddr + (tile.row + i) * cStride + tile.col * sizeof(int32_t);
+		writeEnd      = std::max(writeEnd, this->accessScratchpad(readEnd, addr, cBytes, true));
+	}
+
+	// A tile is bound by either the PE pipeline or the scratchpad. The tiles left keep their PE
+	// timing, which makes the end of the computation a lower bound until the last tile is issued.
+	acalsim::Tick tileEnd = std::max(_when + cycles, writeEnd);
+	this->spmStallCycles += tileEnd - (_when + cycles);
+	this->remainingCycles -= cycles;
+	this->endTick = tileEnd + this->remainingCycles;
+	this->schedule(tileEnd);
+}
+
+void SystolicArray::advance(acalsim::Tick _when) {
+	// The analytical model completes all tiles of the command with a single event
+	uint32_t tileCount = this->getTileCount();
+	uint32_t last      = this->getTimingModel() == TimingModel::ANALYTICAL ? tileCount : this->tileIdx + 1;
+	for (; this->tileIdx < last; this->tileIdx++) {
+		Tile tile = this->makeTile(this->tileIdx);
+		this->computeTile(tile);
+		this->tiles++;
+		this->macs += (uint64_t)tile.rows * tile.cols * tile.depthLen;
+		if (this->dataflow == Dataflow::OS) this->drainCycles += this->drainLatency;
+	}
+
+	if (this->tileIdx < tileCount) {
+		this->issueTile(_when);
+	} else {
+		this->finish(_when);
+	}
+}
+
+void SystolicArray::finish(acalsim::Tick _when) {
+	this->running = false;
+	this->doneCnt++;
+	this->status |= STATUS_DONE;
+	this->updateStatus();
+	this->busyCycles += _when - this->startTick;
+	if (this->getTimingModel() == TimingModel::VALIDATE) {
+		this->recordValidation(this->estimate, _when - this->startTick);
+	}
+	CLASS_INFO << "Systolic array computation completes at Tick = " << _when;
+
+	if (this->cmd.ctrl & CTRL_IRQ_EN) {
+		this->interrupts++;
+		this->raiseInterrupt();
+	}
+
+	// Lets this and the other devices start the commands waiting for this one
+	this->getScoreboard()->complete(this->cmd.id, _when);
+}
+
+acalsim::Tick SystolicArray::getNextStatusChangeTick(acalsim::Tick _when) const {
+	if (this->running) return this->endTick;
+
+	// A queued command waits for a running command of another device
+	return this->queue.empty() ? 0 : this->getScoreboard()->getNextCompletionTick(_when);
+}
+
+uint32_t SystolicArray::getTileCount() const {
+	uint32_t colTiles = (this->N + this->arrayCols - 1) / this->arrayCols;
+	if (this->dataflow == Dataflow::OS) return (this->M + this->arrayRows - 1) / this->arrayRows * colTiles;
+	return (this->K + this->arrayRows - 1) / this->arrayRows * colTiles;
+}
+
+SystolicArray::Tile SystolicArray::makeTile(uint32_t _index) const {
+	uint32_t colTiles = (this->N + this->arrayCols - 1) / this->arrayCols;
+	uint32_t outer    = _index / colTiles * this->arrayRows;
+
+	Tile tile;
+	tile.col  = _index % colTiles * this->arrayCols;
+	tile.cols = std::min(this->arrayCols, this->N - tile.col);
+	if (this->dataflow == Dataflow::OS) {
+		tile.row      = outer;
+		tile.rows     = std::min(this->arrayRows, this->M - outer);
+		tile.depthLen = this->K;
+	} else {
+		tile.rows     = this->M;
+		tile.depth    = outer;
+		tile.depthLen = std::min(this->arrayRows, this->K - outer);
+	}
+	return tile;
+}
+
+acalsim::Tick SystolicArray::getTileCycles(const Tile& _tile) const {
+	if (this->dataflow == Dataflow::OS) return _tile.rows + _tile.cols + _tile.depthLen - 2 + this->drainLatency;
+
+	// Preload the weights, then stream every row of A through them
+	return _tile.depthLen + (_tile.rows + _tile.depthLen + _tile.cols - 2);
+}
+
+acalsim::Tick SystolicArray::estimateCycles() const {
+	int64_t colTiles = (this->N + this->arrayCols - 1) / this->arrayCols;
+
+	// Summing the per-tile latency over the tile grid: every tile row covers all columns and every
+	// tile column all rows, so only the constant part of a tile scales with the number of tiles
+	if (this->dataflow == Dataflow::OS) {
+		int64_t rowTiles = (this->M + this->arrayRows - 1) / this->arrayRows;
+		return colTiles * this->M + rowTiles * this->N +
+		       rowTiles * colTiles * ((int64_t)this->K + (int64_t)this->drainLatency - 2);
+	}
+
+	int64_t depthTiles = (this->K + this->arrayRows - 1) / this->arrayRows;
+	return colTiles * 2 * this->K + depthTiles * this->N + depthTiles * colTiles * ((int64_t)this->M - 2);
+}
+
+void SystolicArray::computeTile(const Tile& _tile) {
+	uint32_t aStride = (this->cmd.strides >> 16) & 0xff;
+	uint32_t bStride = (this->cmd.strides >> 8) & 0xff;
+	uint32_t cStride = this->cmd.strides & 0xff;
+
+	this->aTile.resize(_tile.rows * _tile.depthLen);
+	this->bTile.resize(_tile.depthLen * _tile.cols);
+	this->cTile.assign(_tile.rows * _tile.cols, 0);
+
+	size_t aBytes = _tile.depthLen * sizeof(int32_t);
+	size_t cBytes = _tile.cols * sizeof(int32_t);
+	for (uint32_t i = 0; i < _tile.rows; i++) {
+		uint32_t addr = this->cmd.aAddr + (_tile.row + i) * aStride + _tile.depth * sizeof(int32_t);
+		std::memcpy(&this->aTile[i * _tile.depthLen], this->translate(addr, aBytes), aBytes);
+	}
+	for (uint32_t k = 0; k < _tile.depthLen; k++) {
+		uint32_t addr = this->cmd.bAddr + (_tile.depth + k) * bStride + _tile.col * sizeof(int32_t);
+		std::memcpy(&this->bTile[k * _tile.cols], this->translate(addr, cBytes), cBytes);
+	}
+
+	// Weight-stationary passes after the first one accumulate onto the partial sums in the buffer
+	bool accumulate = this->dataflow == Dataflow::WS && _tile.depth > 0;
+	for (uint32_t i = 0; accumulate && i < _tile.rows; i++) {
+		uint32_t addr = this->cmd.cAddr + (_tile.row + i) * cStride + _tile.col * sizeof(int32_t);
+		std::memcpy(&this->cTile[i * _tile.cols], this->translate(addr, cBytes), cBytes);
+	}
+
+	macKernel(this->aTile.data(), this->bTile.data(), this->cTile.data(), _tile.rows, _tile.depthLen, _tile.cols);
+
+	for (uint32_t i = 0; i < _tile.rows; i++) {
+		uint32_t addr = this->cmd.cAddr + (_tile.row + i) * cStride + _tile.col * sizeof(int32_t);
+		std::memcpy(this->translate(addr, cBytes), &this->cTile[i * _tile.cols], cBytes);
+	}
+}
+
+void SystolicArray::schedule(acalsim::Tick _when) {
+	auto     rc    = acalsim::top->getRecycleContainer();
+	SAEvent* event = rc->acquire<SAEvent>(&SAEvent::renew, this);
+	this->scheduleEvent(event, _when);
+}
+
+void SystolicArray::printStats() const {
+	double utilization = this->busyCycles ? 100.0 * this->macs / (this->busyCycles * this->arrayRows * this->arrayCols)
+	                                      : 0.0;
+
+	CLASS_INFO << "Systolic array (" << this->arrayRows << "x" << this->arrayCols << ", "
+	           << (this->dataflow == Dataflow::OS ? "output" : "weight") << " stationary): " << this->runs
+	           << " runs, " << this->tiles << " tiles, " << this->macs << " MACs";
+	CLASS_INFO << "Systolic array: " << this->busyCycles << " busy cycles (" << this->drainCycles
+	           << " draining, " << this->spmStallCycles << " waiting for the scratchpad) | PE utilization "
+	           << utilization << "% | " << this->interrupts << " interrupts";
+	this->printValidationStats();
+}
+
+void SystolicArray::addIntervalStats(IntervalStats& _stats, const std::string& _prefix) const {
+	_stats.addCounter(_prefix + "macs", [this] { return this->macs; });
+	_stats.addCounter(_prefix + "busy_cycles", [this] { return this->busyCycles; });
+	_stats.addRatio(_prefix + "macs_per_cycle", _prefix + "macs", "cycles");
+}
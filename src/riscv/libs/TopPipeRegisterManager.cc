@@ -17,8 +17,15 @@
 #include "TopPipeRegisterManager.hh"
 
 void TopPipeRegisterManager::runSyncPipeRegister() {
+	// All registers are added before the simulation starts, the order is only built once
+	if (this->syncOrder.size() != this->registers.size()) {
+		std::map<std::string, acalsim::SimPipeRegister*> sorted(this->registers.begin(), this->registers.end());
+		this->syncOrder.clear();
+		for (auto& [_, reg] : sorted) { this->syncOrder.push_back(reg); }
+	}
+
 	// you may do customized logic here. For example stall propogation
-	for (auto& [_, reg] : this->registers) {
+	for (auto reg : this->syncOrder) {
 		reg->sync();
 		reg->clearStallFlag();
 	}
@@ -0,0 +1,35 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "event/BusEvent.hh"
+
+BusEvent::BusEvent(Bus* _callee, Kind _kind, uint32_t _index)
+    : acalsim::SimEvent("BusEvent"), callee(_callee), kind(_kind), index(_index) {}
+
+void BusEvent::renew(Bus* _callee, Kind _kind, uint32_t _index) {
+	this->acalsim::SimEvent::renew();
+	this->callee = _callee;
+	this->kind   = _kind;
+	this->index  = _index;
+}
+
+void BusEvent::process() {
+	if (this->kind == ARBITRATE) {
+		this->callee->arbitrate(acalsim::top->getGlobalTick(), (Bus::Channel)this->index);
+	} else {
+		this->callee->retry(acalsim::top->getGlobalTick(), this->index);
+	}
+}
@@ -0,0 +1,28 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "event/DRAMIssueEvent.hh"
+
+#include "DataMemory.hh"
+
+DRAMIssueEvent::DRAMIssueEvent(DataMemory* _callee) : acalsim::SimEvent("DRAMIssueEvent"), callee(_callee) {}
+
+void DRAMIssueEvent::renew(DataMemory* _callee) {
+	this->acalsim::SimEvent::renew();
+	this->callee = _callee;
+}
+
+void DRAMIssueEvent::process() { this->callee->issueDRAMRequests(acalsim::top->getGlobalTick()); }
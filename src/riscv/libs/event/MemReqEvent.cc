@@ -16,15 +16,21 @@
 
 #include "event/MemReqEvent.hh"
 
-#include "DataMemory.hh"
+#include "MemPacket.hh"
 
-MemReqEvent::MemReqEvent(DataMemory* _callee, acalsim::SimPacket* _memReqPkt)
-    : acalsim::SimEvent("MemReqEvent"), callee(_callee), memReqPkt(_memReqPkt) {}
+MemReqEvent::MemReqEvent(acalsim::SimModule* _callee, MemoryTarget _kind, acalsim::SimPacket* _memReqPkt,
+                         bool _isWrite)
+    : acalsim::SimEvent("MemReqEvent"), callee(_callee), kind(_kind), memReqPkt(_memReqPkt), isWrite(_isWrite) {}
 
-void MemReqEvent::renew(DataMemory* _callee, acalsim::SimPacket* _memReqPkt) {
+void MemReqEvent::renew(acalsim::SimModule* _callee, MemoryTarget _kind, acalsim::SimPacket* _memReqPkt,
+                        bool _isWrite) {
 	this->acalsim::SimEvent::renew();
 	this->callee    = _callee;
+	this->kind      = _kind;
 	this->memReqPkt = _memReqPkt;
+	this->isWrite   = _isWrite;
 }
 
-void MemReqEvent::process() { this->callee->accept(acalsim::top->getGlobalTick(), *this->memReqPkt); }
+void MemReqEvent::process() {
+	visitMemoryTarget(acalsim::top->getGlobalTick(), *this->memReqPkt, this->isWrite, this->kind, *this->callee);
+}
@@ -0,0 +1,28 @@
+/*
+ * Copyright 2023-2024 Playlab/ACAL
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "event/SAEvent.hh"
+
+#include "SystolicArray.hh"
+
+SAEvent::SAEvent(SystolicArray* _callee) : acalsim::SimEvent("SAEvent"), callee(_callee) {}
+
+void SAEvent::renew(SystolicArray* _callee) {
+	this->acalsim::SimEvent::renew();
+	this->callee = _callee;
+}
+
+void SAEvent::process() { this->callee->advance(acalsim::top->getGlobalTick()); }